@@ -58,6 +58,12 @@ class App {
 		//!@note Orthographic or Perspective projection matrix?
 		static GLvoid Resize(GLsizei w, GLsizei h);
 
+		//!@brief Sets the OpenGL state every frame is drawn with
+		//!
+		//!Called by Init(), and again when the window is re-created, as 
+		//!the new context starts out with the default state.
+		static GLvoid SetState();
+
 		//!@brief Check for and print errors until there are no more
 		static GLvoid CheckErrors();
 
@@ -66,6 +72,31 @@ class App {
 		//!@brief The wavefront object file to render
 		static std::string objectFilename;
 
+		//!@brief MeshLoadFlags used when opening the object file
+		static GLuint loadFlags;
+
+		//!@brief VertexFormats layout of the object file's vertex buffer
+		static GLuint vertexFormat;
+
+		//!@brief Split the object file into meshlets and cull them every 
+		//!frame
+		static GLboolean cullMeshlets;
+
+		//!@brief Simplify the object file into levels of detail and draw 
+		//!the coarsest one that looks the same from the camera
+		static GLboolean selectLods;
+
+		//!@brief Rasterize the object file into a small depth buffer on the
+		//!CPU every frame and cull the groups hidden behind it
+		static GLboolean cullOccluded;
+
+		//!@brief Print the load statistics of the object file to stdout
+		static GLboolean printStats;
+
+		//!@brief Draw this many copies of the object file on a grid with
+		//!one instanced draw per group, or a single copy if 0
+		static GLuint instanceCount;
+
 		//!@brief Runs the main App loop (i.e. update, render, events...)
 		static GLvoid Run();
 
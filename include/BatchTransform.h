@@ -0,0 +1,96 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __BATCHTRANSFORM__
+#define __BATCHTRANSFORM__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+
+#include <Vector3.h>
+#include <Matrix4.h>
+
+//!@brief The number of vectors each task of the Parallel functions
+//!transforms
+#define TRANSFORM_BLOCK_SIZE (1<<16)
+
+//!@brief Transforms arrays of points and normals by one matrix
+//!
+//!The vectors are either an array of Vector3 or three separate arrays
+//!(streams) of x, y and z coordinates. The output arrays may be the input
+//!arrays. The results are the same as transforming the vectors one at a
+//!time with Matrix4::operator*(). The Parallel versions split the arrays
+//!into blocks transformed by Parallel::For(), which pays off for arrays of
+//!more than a few hundred thousand vectors.
+struct BatchTransform {
+
+	//!@brief Multiplies the matrix with every vector
+	//!@param [in] m - The matrix
+	//!@param [in] in - The vectors, including their w coordinates
+	//!@param [out] out - The transformed vectors
+	//!@param [in] count - The number of vectors
+	static GLvoid Points(const Matrix4 &m, const Vector3 *in, Vector3 *out,
+			size_t count);
+
+	//!@brief Multiplies the matrix with every point of the streams
+	//!
+	//!The points have w=1 and the fourth row of the matrix is ignored, so
+	//!the matrix should be affine.
+	//!@param [in] m - The matrix
+	//!@param [in] x - The x coordinates of the points
+	//!@param [in] y - The y coordinates of the points
+	//!@param [in] z - The z coordinates of the points
+	//!@param [out] ox - The transformed x coordinates
+	//!@param [out] oy - The transformed y coordinates
+	//!@param [out] oz - The transformed z coordinates
+	//!@param [in] count - The number of points
+	static GLvoid Points(const Matrix4 &m, const GLfloat *x,
+			const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+			GLfloat *oz, size_t count);
+
+	//!@brief Transforms every normal by the matrix's Matrix4::NormalMatrix()
+	//!and normalizes it
+	//!@param [in] m - The matrix the points of the surface are transformed
+	//!by
+	//!@param [in] in - The normals
+	//!@param [out] out - The transformed unit normals, with w=1
+	//!@param [in] count - The number of normals
+	static GLvoid Normals(const Matrix4 &m, const Vector3 *in, Vector3 *out,
+			size_t count);
+
+	//!@brief Transforms every normal of the streams by the matrix's
+	//!Matrix4::NormalMatrix() and normalizes it
+	//!@param [in] m - The matrix the points of the surface are transformed
+	//!by
+	//!@param [in] x - The x coordinates of the normals
+	//!@param [in] y - The y coordinates of the normals
+	//!@param [in] z - The z coordinates of the normals
+	//!@param [out] ox - The transformed x coordinates
+	//!@param [out] oy - The transformed y coordinates
+	//!@param [out] oz - The transformed z coordinates
+	//!@param [in] count - The number of normals
+	static GLvoid Normals(const Matrix4 &m, const GLfloat *x,
+			const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+			GLfloat *oz, size_t count);
+
+	//!@brief Points() on multiple threads
+	static GLvoid ParallelPoints(const Matrix4 &m, const Vector3 *in,
+			Vector3 *out, size_t count);
+
+	//!@brief Points() of streams on multiple threads
+	static GLvoid ParallelPoints(const Matrix4 &m, const GLfloat *x,
+			const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+			GLfloat *oz, size_t count);
+
+	//!@brief Normals() on multiple threads
+	static GLvoid ParallelNormals(const Matrix4 &m, const Vector3 *in,
+			Vector3 *out, size_t count);
+
+	//!@brief Normals() of streams on multiple threads
+	static GLvoid ParallelNormals(const Matrix4 &m, const GLfloat *x,
+			const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+			GLfloat *oz, size_t count);
+};
+
+#endif // __BATCHTRANSFORM__
@@ -0,0 +1,152 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __BENCHMARK__
+#define __BENCHMARK__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+//!@brief Headless benchmarks for the CPU side of the renderer
+//!
+//!None of the benchmarks create a window, and all but InstancedDraw() and
+//!StreamUpload() run without an OpenGL context, so they can be run on
+//!machines without a GPU.
+//!Results are printed to stdout.
+class Benchmark {
+
+	private:
+
+		//!@brief Compares the Matrix4 and Vector3 kernels with the scalar
+		//!code they replaced
+		//!@return True if both produce the same results
+		static GLboolean MathKernels();
+
+		//!@brief Compares Matrix4::Inverse(), AffineInverse(), 
+		//!RigidInverse() and NormalMatrix() with the cofactor inverse they
+		//!replaced
+		//!@return True if they produce the same matrices, within rounding
+		static GLboolean MatrixInverse();
+
+		//!@brief Measures the throughput of the BatchTransform functions
+		//!on millions of vectors and streams, on 1, 2, 4... threads, 
+		//!compared with transforming one vector at a time
+		//!@return True if every function matches the results of 
+		//!transforming one vector at a time
+		static GLboolean VectorTransform();
+
+		//!@brief Checks the quaternions, transforms and camera against
+		//!the matrices glRotatef() builds, and times building the matrices
+		//!of a frame with them and the way App::Render() used to
+		//!@return True if both ways build the same matrices
+		static GLboolean FrameMatrices();
+
+		//!@brief Compares the OBJ parse throughput of each load path and 
+		//!checks that they produce the same mesh
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if every load path produced the same mesh
+		static GLboolean MeshLoad(const std::string &filename);
+
+		//!@brief Compares loading a mesh, including its normals, from the 
+		//!OBJ file with loading it from its binary cache
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if the cache holds the same mesh as the OBJ file
+		static GLboolean MeshCacheLoad(const std::string &filename);
+
+		//!@brief Measures how long quantizing the vertices of a mesh takes
+		//!and how far the quantized vertices are from the originals
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if the errors are within the precision of the format
+		static GLboolean VertexQuantize(const std::string &filename);
+
+		//!@brief Measures how long calculating the vertex normals of a 
+		//!mesh, and of a synthetic sphere, takes on 1, 2, 4... threads
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if the normals match the ones summed one triangle 
+		//!at a time
+		static GLboolean MeshNormals(const std::string &filename);
+
+		//!@brief Compares the vertex cache use of the groups of a mesh, and
+		//!of synthetic grids, before and after reordering their triangles
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if the reordered index buffers hold the same 
+		//!triangles and use the cache at least as well
+		static GLboolean VertexCacheOrder(const std::string &filename);
+
+		//!@brief Compares the estimated vertex fetch cache misses of a mesh,
+		//!and of a synthetic grid, in file order, after reordering the 
+		//!triangles and after reordering the vertices
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if every triangle still has the same vertices
+		static GLboolean VertexFetchOrder(const std::string &filename);
+
+		//!@brief Builds the meshlets of a mesh, and of a synthetic sphere
+		//!wound both ways, and culls them from cameras around the mesh
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if no visible triangle was culled
+		static GLboolean MeshletCull(const std::string &filename);
+
+		//!@brief Builds the levels of detail of a mesh, and of a synthetic
+		//!sphere, and reports their triangle counts and errors
+		//!@param [in] filename - The OBJ file to load
+		//!@return True if every level is a valid triangle list that keeps
+		//!the borders of the groups
+		static GLboolean MeshSimplify(const std::string &filename);
+
+		//!@brief Draws 10000 to 100000 copies of a small sphere with one
+		//!draw per copy and with Mesh::DrawInstanced(), and times updating
+		//!1% of the instances
+		//!
+		//!Draws into a framebuffer object of a context without a window,
+		//!and is skipped if OpenGL 3.3 isn't available. Needs ft.glsl in
+		//!the working directory.
+		//!@return True if both ways draw the same image
+		static GLboolean InstancedDraw();
+
+		//!@brief Sorts a frame of thousands of items for many meshes, 
+		//!shaders and materials with the RenderQueue radix sort and with
+		//!std::stable_sort(), and counts the state changes of drawing them
+		//!in submission order and sorted
+		//!@return True if both sorts produce the same order
+		static GLboolean RenderQueueSort();
+
+		//!@brief Streams 20000 instance transforms a frame for 200 frames,
+		//!which the GPU copies to another buffer, with glBufferSubData()
+		//!and with a StreamBuffer that orphans and that is mapped
+		//!persistently
+		//!
+		//!Runs in a context without a window, and is skipped if OpenGL 3.3
+		//!isn't available. Works on software renderers like llvmpipe.
+		//!@return True if the last frame arrived intact every way
+		static GLboolean StreamUpload();
+
+		//!@brief Tests 200000 random boxes against a frustum one plane at a
+		//!time, with Frustum::Intersects() and as spheres, and culls the
+		//!groups of an assembly of 4096 parts from its center
+		//!@return True if both box tests agree on every box
+		static GLboolean FrustumCull();
+
+		//!@brief Rasterizes a wall and an assembly of 4096 parts with the
+		//!OcclusionCuller on one thread and on all of them, and culls the
+		//!parts hidden behind the wall, and checks the back of the wall
+		//!hides nothing. Then culls boxes seen through the hole of a ring
+		//!added with its levels of detail.
+		//!@return True if both rasterize the same depth buffer, the 
+		//!occluders picked by default fit in the budget and no part or box
+		//!that can be seen is culled
+		static GLboolean OcclusionCull();
+
+	public:
+
+		//!@brief Runs the benchmark with the specified name
+		//!@param [in] name - The name of the benchmark, "all" runs every 
+		//!benchmark
+		//!@param [in] filename - The OBJ file used by mesh benchmarks
+		//!@return True if the benchmark exists and succeeded
+		static GLboolean Run(const std::string &name, 
+				const std::string &filename);
+};
+
+#endif // __BENCHMARK__
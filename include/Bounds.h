@@ -0,0 +1,114 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __BOUNDS__
+#define __BOUNDS__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+#include <Vector3.h>
+#include <Matrix4.h>
+
+//!@brief An axis aligned bounding box
+//!
+//!A new box is empty (min is greater than max) until a point is added.
+struct BoundingBox {
+
+	Vector3 min; //!<The corner with the smallest coordinates
+	Vector3 max; //!<The corner with the largest coordinates
+
+	//!@brief Constructs an empty box
+	BoundingBox();
+
+	//!@brief Empties the box
+	GLvoid Reset();
+
+	//!@brief Grows the box so that it contains the point
+	//!@param [in] p - The point to add
+	GLvoid Add(const Vector3 &p);
+
+	//!@brief Grows the box so that it contains the other box
+	//!@param [in] b - The box to add
+	GLvoid Add(const BoundingBox &b);
+
+	//!@brief Checks if any point was added to the box
+	//!@return True if the box is empty
+	GLboolean Empty() const;
+
+	//!@brief Calculates the center of the box
+	//!@return The point halfway between min and max
+	Vector3 Center() const;
+
+	//!@brief Calculates the size of the box along each axis
+	//!@return The vector from min to max
+	Vector3 Size() const;
+
+	//!@brief Describes the box
+	//!@return A string containing the min and max corners
+	const std::string ToString() const;
+};
+
+//!@brief A bounding sphere
+//!
+//!A new sphere is empty, its radius is negative.
+struct BoundingSphere {
+
+	Vector3 center; //!<The center of the sphere
+	GLfloat radius; //!<The radius of the sphere
+
+	//!@brief Constructs an empty sphere
+	BoundingSphere();
+
+	//!@brief Checks if the sphere contains any point
+	//!@return True if the sphere is empty
+	GLboolean Empty() const;
+};
+
+//!@brief The six clipping planes of a view volume
+//!
+//!Each plane is stored as a Vector3 holding the unit normal in x, y, z and
+//!the distance in w. Points inside the volume have a positive distance 
+//!n.p+w to every plane.
+struct Frustum {
+
+	Vector3 planes[6]; //!<Left, right, bottom, top, near and far planes
+	GLfloat soa[4][8]; //!<The x, y, z and w components of the planes, 
+	                   //!<padded with two planes that contain everything,
+	                   //!<for testing four planes at a time
+
+	//!@brief Constructs a frustum that contains everything
+	Frustum();
+
+	//!@brief Extracts the planes of the view volume of a matrix
+	//!
+	//!For a projection matrix the planes are in eye space, for a 
+	//!modelviewprojection matrix they are in the model's space.
+	//!@param [in] m - The matrix transforming points to clip space
+	Frustum(const Matrix4 &m);
+
+	//!@brief Checks if a sphere is at least partially inside the frustum
+	//!@param [in] center - The center of the sphere
+	//!@param [in] radius - The radius of the sphere
+	//!@return False if the sphere is entirely outside one of the planes
+	GLboolean Intersects(const Vector3 &center, GLfloat radius) const;
+
+	//!@brief Checks if a box is at least partially inside the frustum
+	//!
+	//!Tests four planes at a time with the Simd operations. Boxes near
+	//!the corners of the frustum may pass without being inside, like
+	//!spheres.
+	//!@param [in] box - The box
+	//!@return False if the box is empty or entirely outside one of the 
+	//!planes
+	GLboolean Intersects(const BoundingBox &box) const;
+
+	private:
+
+		//!@brief Copies the planes into soa
+		GLvoid Transpose();
+};
+
+#endif // __BOUNDS__
@@ -0,0 +1,56 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __CAMERA__
+#define __CAMERA__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+
+#include <Vector3.h>
+#include <Matrix4.h>
+#include <Transform.h>
+
+//!@brief A camera that turns left and right (yaw), looks up and down
+//!(pitch) and moves along the direction it looks in (dolly)
+//!
+//!The camera starts at the origin looking down the -z axis, like OpenGL's
+//!eye space. Angles are in degrees.
+struct Camera {
+
+	Vector3 position; //!<The position of the camera in world space
+	GLfloat yaw; //!<The angle turned around the world's y axis
+	GLfloat pitch; //!<The angle looked up, between -89 and 89 degrees
+
+	//!@brief Constructs a camera at the origin looking down the -z axis
+	Camera();
+
+	//!@brief Turns the camera left, or right for negative angles
+	//!@param [in] angle - The angle to turn by
+	GLvoid Yaw(GLfloat angle);
+
+	//!@brief Tilts the camera up, or down for negative angles. The camera
+	//!stops short of looking straight up or down.
+	//!@param [in] angle - The angle to tilt by
+	GLvoid Pitch(GLfloat angle);
+
+	//!@brief Moves the camera forward, or back for negative distances
+	//!@param [in] distance - The distance to move
+	GLvoid Dolly(GLfloat distance);
+
+	//!@brief Returns the rotation from eye space to world space
+	//!@return The yaw rotation times the pitch rotation
+	Quaternion Orientation() const;
+
+	//!@brief Returns the direction the camera looks in
+	//!@return The unit vector along the camera's -z axis, in world space
+	Vector3 Forward() const;
+
+	//!@brief Calculates the view matrix, which moves points from world
+	//!space into eye space
+	//!@return The inverse of the camera's position and orientation
+	Matrix4 ViewMatrix() const;
+};
+
+#endif // __CAMERA__
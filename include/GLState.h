@@ -0,0 +1,172 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __GLSTATE__
+#define __GLSTATE__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+//!@brief The number of texture units whose GL_TEXTURE_2D binding is tracked
+#define GL_STATE_TEXTURE_UNITS 16
+
+//!@brief The number of indexed uniform buffer binding points tracked
+#define GL_STATE_UNIFORM_BINDINGS 16
+
+//!@brief Counts the calls made and dropped by GLState
+struct GLStateStats {
+
+	size_t issued; //!<Calls passed on to OpenGL
+	size_t elided; //!<Calls dropped because they wouldn't change anything
+	size_t mismatches; //!<Shadow values found to differ from OpenGL by
+	                   //!<GLState::Validate()
+
+	//!@brief Constructs zeroed counters
+	GLStateStats();
+
+	//!@brief Describes the counters
+	//!@return A string containing the calls issued and elided
+	const std::string ToString() const;
+};
+
+//!@brief Shadows the OpenGL state and drops calls that don't change it
+//!
+//!Each function makes the OpenGL call of the same name, unless the
+//!shadowed state already has the value. The shadow starts out unknown, so
+//!the first call always goes through. Code that changes the tracked state
+//!without GLState has to call Invalidate() afterwards.
+//!
+//!Tracked are the program, the vertex array object, the GL_ARRAY_BUFFER
+//!and GL_UNIFORM_BUFFER bindings, the indexed uniform buffer bindings, the
+//!active texture unit and its GL_TEXTURE_2D binding, the GL_BLEND,
+//!GL_CULL_FACE, GL_DEPTH_TEST, GL_DEPTH_CLAMP and GL_SCISSOR_TEST caps, and
+//!the blend function, depth function, depth mask, cull face, front face
+//!and polygon mode. Other targets and caps are passed on, and counted as
+//!issued. GL_ELEMENT_ARRAY_BUFFER is part of the vertex array object, so
+//!it is never dropped.
+//!
+//!Deleting objects through GLState clears the bindings that referred to
+//!them, as OpenGL does, so a new object reusing the name is bound again.
+struct GLState {
+
+	//!@brief Checks the whole shadow against glGet*() before every call,
+	//!reporting and fixing mismatches. Slow, for debugging.
+	static GLboolean validate;
+
+	//!@brief The calls made and dropped since the last ResetStats()
+	static GLStateStats stats;
+
+	//!@brief Zeroes stats, at the start of a frame
+	static GLvoid ResetStats();
+
+	//!@brief Forgets the shadowed state, so every next call goes through
+	static GLvoid Invalidate();
+
+	//!@brief Compares the known shadow values with OpenGL
+	//!
+	//!Mismatches are printed to stderr, counted in stats and replaced by
+	//!the value OpenGL reports.
+	//!@return True if every known value matched
+	static GLboolean Validate();
+
+	//!@brief Calls glUseProgram() if the program isn't in use
+	//!@param [in] program - The program, 0 for none
+	static GLvoid UseProgram(GLuint program);
+
+	//!@brief Calls glBindVertexArray() if the array isn't bound
+	//!@param [in] vao - The vertex array object, 0 for none
+	static GLvoid BindVertexArray(GLuint vao);
+
+	//!@brief Calls glBindBuffer() if the buffer isn't bound to the target
+	//!@param [in] target - The target, like GL_ARRAY_BUFFER
+	//!@param [in] buffer - The buffer object, 0 for none
+	static GLvoid BindBuffer(GLenum target, GLuint buffer);
+
+	//!@brief Calls glBindBufferBase(), unless the whole buffer is bound
+	//!to the binding point already. Also binds the buffer to the target.
+	//!@param [in] target - The target, like GL_UNIFORM_BUFFER
+	//!@param [in] index - The binding point
+	//!@param [in] buffer - The buffer object
+	static GLvoid BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+	//!@brief Calls glBindBufferRange(), unless the same range is bound to
+	//!the binding point already. Also binds the buffer to the target.
+	//!@param [in] target - The target, like GL_UNIFORM_BUFFER
+	//!@param [in] index - The binding point
+	//!@param [in] buffer - The buffer object
+	//!@param [in] offset - The offset of the range in bytes
+	//!@param [in] size - The size of the range in bytes
+	static GLvoid BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+			GLintptr offset, GLsizeiptr size);
+
+	//!@brief Calls glActiveTexture() if the unit isn't active
+	//!@param [in] unit - The unit, GL_TEXTURE0 and up
+	static GLvoid ActiveTexture(GLenum unit);
+
+	//!@brief Calls glBindTexture() if the texture isn't bound to the
+	//!active unit
+	//!@param [in] target - The target, like GL_TEXTURE_2D
+	//!@param [in] texture - The texture object, 0 for none
+	static GLvoid BindTexture(GLenum target, GLuint texture);
+
+	//!@brief Calls glEnable() if the cap is disabled
+	//!@param [in] cap - The capability, like GL_BLEND
+	static GLvoid Enable(GLenum cap);
+
+	//!@brief Calls glDisable() if the cap is enabled
+	//!@param [in] cap - The capability, like GL_BLEND
+	static GLvoid Disable(GLenum cap);
+
+	//!@brief Calls glBlendFunc() if either factor differs
+	//!@param [in] src - The source factor
+	//!@param [in] dst - The destination factor
+	static GLvoid BlendFunc(GLenum src, GLenum dst);
+
+	//!@brief Calls glDepthFunc() if the function differs
+	//!@param [in] func - The comparison, like GL_LEQUAL
+	static GLvoid DepthFunc(GLenum func);
+
+	//!@brief Calls glDepthMask() if the mask differs
+	//!@param [in] mask - True to write depth values
+	static GLvoid DepthMask(GLboolean mask);
+
+	//!@brief Calls glCullFace() if the mode differs
+	//!@param [in] mode - GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+	static GLvoid CullFace(GLenum mode);
+
+	//!@brief Calls glFrontFace() if the mode differs
+	//!@param [in] mode - GL_CW or GL_CCW
+	static GLvoid FrontFace(GLenum mode);
+
+	//!@brief Calls glPolygonMode() for front and back faces if the mode
+	//!differs
+	//!@param [in] mode - GL_POINT, GL_LINE or GL_FILL
+	static GLvoid PolygonMode(GLenum mode);
+
+	//!@brief Calls glDeleteProgram() and forgets the program if it was
+	//!in use
+	//!@param [in] program - The program
+	static GLvoid DeleteProgram(GLuint program);
+
+	//!@brief Calls glDeleteBuffers() and clears the bindings of the
+	//!buffers
+	//!@param [in] n - The number of buffers
+	//!@param [in] buffers - The buffer objects
+	static GLvoid DeleteBuffers(GLsizei n, const GLuint *buffers);
+
+	//!@brief Calls glDeleteVertexArrays() and clears the binding if one
+	//!of the arrays was bound
+	//!@param [in] n - The number of arrays
+	//!@param [in] arrays - The vertex array objects
+	static GLvoid DeleteVertexArrays(GLsizei n, const GLuint *arrays);
+
+	//!@brief Calls glDeleteTextures() and clears the bindings of the
+	//!textures
+	//!@param [in] n - The number of textures
+	//!@param [in] textures - The texture objects
+	static GLvoid DeleteTextures(GLsizei n, const GLuint *textures);
+};
+
+#endif // __GLSTATE__
@@ -0,0 +1,78 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __INSTANCEBUFFER__
+#define __INSTANCEBUFFER__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <vector>
+
+#include <Vector3.h>
+#include <Vec.h>
+
+//!@brief The first of the four attributes holding the columns of an
+//!instance's model matrix, a mat4 attribute in the shader
+#define INSTANCE_ATTRIBUTE_MODEL 3
+
+//!@brief The attribute holding an instance's color
+#define INSTANCE_ATTRIBUTE_COLOR 7
+
+//!@brief The attributes of one copy of a mesh in an instanced draw
+struct MeshInstance {
+
+	Mat4f model; //!<Moves the mesh into world space
+	Vec4f color; //!<Multiplies the color of the material
+};
+
+//!@brief A vertex buffer object holding the MeshInstance of every copy
+//!drawn by Mesh::DrawInstanced()
+//!
+//!The instances are edited on the CPU and the ranges that changed are
+//!marked with MarkDirty(). Upload() then only sends those ranges to the
+//!GPU, merging ranges that overlap or touch.
+struct InstanceBuffer {
+
+	GLuint vbo; //!<The identifier for the vertex buffer object
+	std::vector<MeshInstance> instances; //!<The instances
+	std::vector<GLuint> dirty; //!<Pairs of first instance and instance
+	                           //!<count changed since the last Upload()
+	GLuint capacity; //!<The number of instances the VBO has room for
+
+	//!@brief Constructs an empty buffer without a vertex buffer object
+	InstanceBuffer();
+
+	//!@brief Changes the number of instances. New instances have an
+	//!identity model matrix and a white color.
+	//!@param [in] count - The number of instances
+	GLvoid Resize(GLuint count);
+
+	//!@brief Marks instances to be uploaded by the next Upload()
+	//!@param [in] first - The first instance that changed
+	//!@param [in] count - The number of instances that changed
+	GLvoid MarkDirty(GLuint first, GLuint count);
+
+	//!@brief Places the instances on a square grid in the xy plane, in
+	//!rows from the bottom left, and marks them all dirty
+	//!@param [in] center - The center of the grid
+	//!@param [in] spacing - The distance between neighboring instances
+	GLvoid FillGrid(const Vector3 &center, GLfloat spacing);
+
+	//!@brief Sends the dirty instances to the GPU
+	//!
+	//!Creates the VBO the first time. If the instances don't fit the VBO
+	//!any more it is reallocated and every instance is uploaded, the VBO
+	//!keeps its identifier so vertex array objects referring to it stay
+	//!valid.
+	//!@return The number of bytes uploaded
+	GLsizeiptr Upload();
+
+	//!@brief Deletes the instances and the vertex buffer object
+	GLvoid Close();
+
+	//!@brief Calls Close()
+	~InstanceBuffer();
+};
+
+#endif // __INSTANCEBUFFER__
@@ -0,0 +1,49 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __MAPPEDFILE__
+#define __MAPPEDFILE__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+//!@brief A read-only memory mapping of an entire file
+//!
+//!The file contents can be accessed directly through the data pointer
+//!without copying them into a buffer first. The mapping is released when
+//!Close() is called or the object is destroyed.
+//!@note The mapping is not null terminated, always use size to find the end
+struct MappedFile {
+
+	const GLchar *data; //!<Pointer to the first byte of the mapped file
+	size_t size; //!<The size of the mapping (and the file) in bytes
+
+#ifdef _WIN32
+	GLvoid *file; //!<Handle to the opened file
+	GLvoid *mapping; //!<Handle to the file mapping object
+#endif
+
+	//!@brief Constructs an empty mapping
+	MappedFile();
+
+	//!@brief Maps the specified file into memory, read only
+	//!@param [in] filename - The name of the file to map
+	//!@return True if the file was mapped successfully, false otherwise
+	GLboolean Open(const std::string &filename);
+
+	//!@brief Unmaps the file, if one is mapped
+	GLvoid Close();
+
+	//!@brief Calls Close()
+	~MappedFile();
+
+	private:
+
+		//!Mappings can't be shared, so copying is not allowed
+		MappedFile(const MappedFile &m);
+		MappedFile& operator=(const MappedFile &m);
+};
+
+#endif // __MAPPEDFILE__
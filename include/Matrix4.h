@@ -12,6 +12,8 @@
 #include <Vector3.h>
 
 //!@brief A standard 4x4 homogeneous matrix
+//!
+//!The matrix is trivially copyable and has the same layout as a Mat4f.
 struct Matrix4 {
 
 	//@!brief The representation of the matrix
@@ -26,6 +28,15 @@ struct Matrix4 {
 	//!@brief Constructs a new identity matrix
 	Matrix4();
 
+	//!@brief Constructs a matrix from a packed matrix, which has the same
+	//!layout
+	//!@param [in] m - The matrix to copy
+	Matrix4(const Mat4f &m);
+
+	//!@brief Copies the matrix to a packed matrix
+	//!@return The matrix as a Mat4f
+	Mat4f ToMat4() const;
+
 	//!@brief Sets the current matrix to an identity matrix
 	//!
 	//!An identity matrix does nothing. It is equivalent to multiplying by 1
@@ -100,6 +111,35 @@ struct Matrix4 {
 	//!a new one with the inverted data.
 	Matrix4 Inverse() const;
 
+	//!@brief Calculates the inverse of an affine matrix, one whose fourth
+	//!row is 0, 0, 0, 1, such as a model or view transformation
+	//!
+	//!Inverts the upper 3x3 matrix and moves the translation back through
+	//!it, which takes a fraction of the work of Inverse().
+	//!@return The inverted matrix, or the identity matrix if the matrix
+	//!can't be inverted
+	Matrix4 AffineInverse() const;
+
+	//!@brief Calculates the inverse of a matrix that only rotates and 
+	//!translates, such as a camera/view transformation
+	//!
+	//!The inverse of a rotation is its transpose, so this transposes the
+	//!upper 3x3 matrix and rotates the negated translation by it.
+	//!@return The inverted matrix
+	//!@note The result is wrong if the matrix scales, shears or projects,
+	//!use AffineInverse() or Inverse() for those
+	Matrix4 RigidInverse() const;
+
+	//!@brief Calculates the matrix that transforms normals, the inverse
+	//!transpose of the upper 3x3 matrix
+	//!
+	//!Normals transformed by this matrix stay perpendicular to the surface
+	//!even if the matrix scales unevenly. They have to be normalized
+	//!afterwards.
+	//!@return The normal matrix, without translation, or the identity
+	//!matrix if the matrix can't be inverted
+	Matrix4 NormalMatrix() const;
+
 	//!@brief Calculates the cofactor of the element in the matrix at the 
 	//!intersection of the specified column and row.
 	//!
@@ -133,11 +173,6 @@ struct Matrix4 {
 	//!@return The new matrix
 	Matrix4 operator*(const Matrix4 &m) const;
 
-	//!@brief Assigns a matrix to this matrix
-	//!@param [in] m - A reference to the matrix to copy
-	//!@return A reference to the new matrix
-	Matrix4& operator=(const Matrix4 &m);
-
 	//!@brief Multiplies the two matrices and assigns the resultant matrix 
 	//!to itself
 	//!@param [in] m - A reference to the matrix to be multiplied with
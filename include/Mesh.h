@@ -8,7 +8,113 @@
 #include <GL/glew.h>
 #include <SFML/Window.hpp>
 #include <string>
+#include <vector>
+#include <map>
 #include <Vector3.h>
+#include <Bounds.h>
+#include <MeshCache.h>
+#include <VertexFormat.h>
+#include <VertexCache.h>
+#include <Meshlet.h>
+#include <Matrix4.h>
+#include <UniformBuffer.h>
+#include <InstanceBuffer.h>
+#include <OcclusionCuller.h>
+
+//!@brief Flags that select how Mesh::Open loads an OBJ file. The flags can be
+//!OR'd together.
+enum MeshLoadFlags {
+	MESH_LOAD_STREAM = 0x0, //!<Read the file line by line using iostreams
+	MESH_LOAD_MAPPED = 0x1, //!<Memory map the file and parse it in place
+	MESH_LOAD_PARALLEL = 0x2, //!<Memory map the file and parse chunks of it
+	                          //!<on multiple threads
+	MESH_LOAD_CACHE = 0x4, //!<Load the binary cache of the file if it is 
+	                       //!<valid, otherwise load the file and write the
+	                       //!<cache
+	MESH_LOAD_WELD = 0x8, //!<Build one vertex per unique v/vt/vn triple of
+	                      //!<the faces. Implies MESH_LOAD_MAPPED.
+	MESH_LOAD_OPTIMIZE = 0x10 //!<Reorder the triangles of each group for 
+	                          //!<the post-transform vertex cache, then the
+	                          //!<vertices in the order they're first used
+};
+
+//!@brief The MeshLoadFlags that change the loaded data and therefore must
+//!match for a binary cache to be used
+#define MESH_CACHE_FLAGS (MESH_LOAD_WELD | MESH_LOAD_OPTIMIZE)
+
+//!@brief The number of levels of detail built by Mesh::BuildLods(), counting
+//!the full mesh. Every level has about half the triangles of the one before.
+#define MESH_LOD_COUNT 5
+
+//!@brief The largest error, in pixels of the occlusion depth buffer, of a 
+//!level of detail Mesh::AddOccluders() adds instead of the full group
+#define MESH_OCCLUDER_LOD_ERROR 1.0f
+
+//!@brief The smallest size, in pixels of the occlusion depth buffer, of the
+//!groups Mesh::AddOccluders() adds by default
+#define MESH_OCCLUDER_MIN_SIZE 8.0f
+
+//!@brief The most occluder triangles Mesh::AddOccluders() adds by default
+#define MESH_OCCLUDER_TRIANGLES 32768
+
+//!@brief Marks a missing index, such as a face corner without a texture 
+//!coordinate
+#define NO_INDEX 0xFFFFFFFF
+
+//!@brief Statistics gathered while loading a mesh
+struct MeshLoadStats {
+
+	size_t bytes; //!<The size of the OBJ file in bytes
+	GLfloat parseTime; //!<Seconds spent reading and parsing the OBJ file
+	GLuint threads; //!<The number of threads used to parse the file
+	GLboolean fromCache; //!<The mesh was loaded from its binary cache
+	GLboolean cacheWritten; //!<The binary cache was written
+	size_t corners; //!<Face corners read while welding
+	size_t uniqueVerts; //!<Unique vertices built from the corners
+	GLfloat optimizeTime; //!<Seconds spent reordering the triangles
+	VertexCacheStats vertexCacheBefore; //!<Vertex cache use of the groups
+	                                    //!<before reordering
+	VertexCacheStats vertexCacheAfter; //!<Vertex cache use of the groups
+	                                   //!<after reordering
+	GLfloat remapTime; //!<Seconds spent reordering the vertices
+	VertexFetchStats fetchBefore; //!<Vertex fetches before reordering the 
+	                              //!<vertices
+	VertexFetchStats fetchAfter; //!<Vertex fetches after reordering the 
+	                             //!<vertices
+
+	//!@brief Constructs zeroed statistics
+	MeshLoadStats();
+
+	//!@brief Calculates the parse throughput
+	//!@return The throughput in megabytes per second
+	GLfloat Throughput() const;
+
+	//!@brief Describes the statistics
+	//!@return A string containing the file size, parse time, thread count,
+	//!throughput, cache usage, welding and reordering results
+	const std::string ToString() const;
+};
+
+//!@brief Counters of a pass of group culling
+struct GroupCullStats {
+
+	size_t groups; //!<The number of groups tested
+	size_t triangles; //!<The number of triangles in those groups
+	size_t culledGroups; //!<Groups outside the view frustum
+	size_t culledTriangles; //!<Triangles in the culled groups
+
+	//!@brief Constructs zeroed counters
+	GroupCullStats();
+
+	//!@brief Adds the counters of another frame
+	//!@param [in] s - The counters to add
+	GLvoid Add(const GroupCullStats &s);
+
+	//!@brief Describes the counters
+	//!@return A string containing the number of groups and triangles 
+	//!tested and culled
+	const std::string ToString() const;
+};
 
 //!@brief Stores material information
 //!
@@ -25,8 +131,16 @@ struct Material {
 	GLuint illum;  //!<Illumination model (What is it's use?)
 	GLfloat ni;    //!<Index of refraction (What is it's use?)
 
+	//!@brief Constructs a material with the default values given by the MTL
+	//!specification
+	Material();
+
 	//!@brief Fills the material structure using data from the specified 
 	//!MTL file
+	//!
+	//!The MTL file is parsed once and cached by MaterialLibrary::Load(), so
+	//!opening many materials from the same file is cheap. If the file has
+	//!no material with the specified name the default values are used.
 	//!@param [in] filename - The MTL filename
 	//!@param [in] matname - The name of the material to read data from
 	//!@return True if the method succeeded or false if something fails
@@ -38,19 +152,86 @@ struct Material {
 	const std::string ToString() const;
 };
 
+//!@brief All the material definitions of one MTL file
+//!
+//!The MTL file is parsed once into a table of materials that can be looked
+//!up by name. Libraries are cached by filename and shared by every mesh
+//!using the same MTL file, so the materials they hold never move or change.
+struct MaterialLibrary {
+
+	std::string filename; //!<The MTL file the materials were read from
+	std::vector<Material> materials; //!<The materials, in file order
+	std::vector<std::string> names; //!<The name of each material
+	std::map<std::string, GLuint> lookup; //!<Maps names to material indices
+
+	//!@brief Parses all the material definitions in the MTL file
+	//!@param [in] filename - The MTL filename
+	//!@return True if the file was opened successfully, false otherwise
+	GLboolean Open(const std::string &filename);
+
+	//!@brief Finds a material by name
+	//!@param [in] name - The name given by the newmtl statement
+	//!@return A pointer to the material or NULL if there is no such material
+	const Material* Find(const std::string &name) const;
+
+	//!@brief Returns the cached library for the MTL file, parsing the file 
+	//!the first time it is requested
+	//!@param [in] filename - The MTL filename
+	//!@return A pointer to the shared library, or NULL if the file can't be
+	//!opened
+	static MaterialLibrary* Load(const std::string &filename);
+
+	//!@brief Deletes all cached libraries
+	//!@note Meshes referencing materials from the cache must be closed first
+	static GLvoid ClearCache();
+
+	private:
+
+		//!Libraries that have been loaded, by MTL filename
+		static std::map<std::string, MaterialLibrary*> cache;
+};
+
+//!@brief The index of a group's material if it never specified one
+#define NO_MATERIAL 0xFFFFFFFF
+
 //!@brief Defines a collection of triangles/vertices which use the same
 //!materials
 struct TriangleGroup {
 
 	std::vector<GLuint> indices; //!<Contains the indices into the vector array
-	Material mtl; //!<The material data for this group
+	GLuint mtl; //!<Index of the group's material in Mesh::materials
 	GLuint ibo; //!<The identifier for the index buffer object
+	GLuint vao; //!<The vertex array object holding the mesh's vertex layout
+	            //!<and this group's index buffer object
+	GLsizei count; //!<The number of indices in the index buffer object
+	std::vector<Meshlet> meshlets; //!<The meshlets, built by 
+	                               //!<Mesh::BuildMeshlets()
+	std::vector<GLuint> meshletVertices; //!<The vertices of each meshlet
+	std::vector<GLubyte> meshletIndices; //!<The local indices of each 
+	                                     //!<meshlet's triangles
+	std::vector<GLsizei> ranges; //!<Pairs of first index and index count
+	                             //!<left to draw by Mesh::CullMeshlets()
+	std::vector<GLuint> lodIndices; //!<The index arrays of the simplified 
+	                                //!<levels of detail, one after the other
+	std::vector<GLsizei> lods; //!<Pairs of first index and index count of
+	                           //!<each simplified level of detail in the
+	                           //!<index buffer object, which follow the 
+	                           //!<group's own indices
+	BoundingBox bounds; //!<The bounding box of the group's vertices
+	BoundingSphere sphere; //!<A sphere around the group's vertices
+	GLboolean visible; //!<False if Mesh::CullGroups() found the group 
+	                   //!<outside the view frustum, or 
+	                   //!<Mesh::CullOccluded() found it hidden
+
+	//!@brief Constructs an empty group without any buffer objects
+	TriangleGroup();
 
 	//!@brief Returns a string containing the data contained within this struct
 	//!@return A string containing the data within this struct
 	const std::string ToString() const;
 
-	//!@brief Deletes all vector containers and buffer objects
+	//!@brief Deletes all vector containers, buffer objects and the vertex
+	//!array object
 	~TriangleGroup();
 };
 
@@ -63,10 +244,32 @@ struct TriangleGroup {
 struct Mesh {
 
 	std::vector<Vector3> v; //!<A vector containing both vertices and normals
-	std::vector<Vector3> vt; //!<A vector of texture coords
+	std::vector<Vec2f> vt; //!<A vector of texture coords
 	std::vector<TriangleGroup> g; //!<A vector of material groups
+	std::vector<const Material*> materials; //!<Materials used by the groups,
+	                                        //!<shared through MaterialLibrary
+	std::vector<std::string> materialNames; //!<The MTL file and the name of
+	                                        //!<each material, one after 
+	                                        //!<the other
 	GLuint vbo; //!<Handle for vertex/normal/texcoord interleaved VBO
+	GLuint format; //!<The VertexFormats layout of the VBO
 	GLuint numVerts; //!<Number of just the vertices in the array
+	BoundingBox bounds; //!<The bounding box of all the vertices
+	BoundingSphere sphere; //!<A sphere around all the vertices
+	MeshCache cache; //!<The mapped binary cache, if loaded from one
+	MeshLoadStats stats; //!<Statistics from the last call to Open()
+	GLboolean culled; //!<Draw() only draws the ranges of the groups, set by
+	                  //!<CullMeshlets()
+	std::vector<GLfloat> lodErrors; //!<The largest distance of each level of
+	                                //!<detail from the full mesh, which is 
+	                                //!<level 0
+	GLuint lod; //!<The level of detail Draw() draws, set by SelectLod()
+	UniformBuffer materialBuffer; //!<A Material block for each material,
+	                              //!<then one for the default material
+	GLsizeiptr materialStride; //!<The distance between the Material blocks
+
+	//!@brief Constructs an empty mesh without any buffer objects
+	Mesh();
 
 	//!@brief Opens the OBJ file and the corresponding MTL file
 	//!
@@ -74,15 +277,222 @@ struct Mesh {
 	//!Loads all the data from the file and fills the vertex, normal,
 	//!texture and material group vector containers.
 	//!@param [in] filename - The name of the OBJ file
+	//!@param [in] flags - MeshLoadFlags selecting how the file is loaded
 	//!@return True if file(s) were opened successfully, False otherwise
-	GLboolean Open(const std::string &filename);
+	GLboolean Open(const std::string &filename, 
+			GLuint flags=MESH_LOAD_STREAM);
+
+	//!@brief Parses the OBJ file line by line using iostreams
+	//!@param [in] filename - The name of the OBJ file
+	//!@return True if file(s) were opened successfully, False otherwise
+	GLboolean ParseStream(const std::string &filename);
+
+	//!@brief Loads the mesh from the binary cache of the OBJ file
+	//!
+	//!The vertex and index arrays stay in the mapped cache file, v and the
+	//!groups' indices are left empty. Use Vertices() and the cache to
+	//!access them. The bounds are read from the cache as well, the 
+	//!materials are looked up in their MTL files by name.
+	//!@param [in] filename - The name of the OBJ file
+	//!@param [in] flags - The content affecting MeshLoadFlags
+	//!@return True if a valid cache was loaded, false otherwise
+	GLboolean OpenCache(const std::string &filename, GLuint flags);
+
+	//!@brief Memory maps the OBJ file and parses it in place
+	//!
+	//!Produces the same vertices, texture coordinates and indices as 
+	//!ParseStream(), but tokenizes the mapped file directly so nothing is 
+	//!allocated per line. Unlike ParseStream(), vertices that follow a group
+	//!definition are kept, faces that precede the first group are put
+	//!into a group of their own and negative (relative) indices are 
+	//!resolved. Polygons are split into triangles.
+	//!
+	//!With MESH_LOAD_WELD, the texture coordinate and normal indices of 
+	//!every face corner are kept as well, and the mesh gets one vertex per
+	//!unique v/vt/vn triple. vt then holds one texture coordinate per 
+	//!vertex, and if every corner has a normal the normals from the file
+	//!follow the vertices in v.
+	//!@param [in] filename - The name of the OBJ file
+	//!@param [in] flags - The MeshLoadFlags, only MESH_LOAD_WELD is used
+	//!@return True if file(s) were opened successfully, False otherwise
+	GLboolean ParseMapped(const std::string &filename, GLuint flags);
+
+	//!@brief Memory maps the OBJ file and parses it on multiple threads
+	//!
+	//!The file is split into chunks at line boundaries and each chunk is 
+	//!parsed on its own. The chunks are then stitched together in file 
+	//!order, so the result is the same as the result of ParseMapped().
+	//!@param [in] filename - The name of the OBJ file
+	//!@param [in] flags - The MeshLoadFlags, only MESH_LOAD_WELD is used
+	//!@return True if file(s) were opened successfully, False otherwise
+	GLboolean ParseParallel(const std::string &filename, GLuint flags);
+
+	//!@brief Makes the group use the specified material
+	//!
+	//!The material is looked up in the cached MaterialLibrary of the MTL
+	//!file and added to the materials table, unless the table already holds
+	//!it. Unknown material names use the default material.
+	//!@param [in] grp - The group to set the material of
+	//!@param [in] mtlfilename - The MTL file defining the material
+	//!@param [in] matname - The name of the material
+	//!@return True if the MTL file could be opened, false otherwise
+	GLboolean UseMaterial(TriangleGroup &grp, const std::string &mtlfilename,
+			const std::string &matname);
+
+	//!@brief Returns the material of the specified group
+	//!@param [in] grp - The group
+	//!@return The group's material, or the default material if it has none
+	const Material& GetMaterial(const TriangleGroup &grp) const;
 	
+	//!@brief Returns the vertex array, followed by the normals if they 
+	//!were calculated
+	//!@return A pointer to v or to the vertex array in the mapped cache
+	const Vector3* Vertices() const;
+
+	//!@brief Returns the texture coordinate of each vertex
+	//!@return A pointer to vt or to the texture coordinates in the mapped
+	//!cache, NULL if there isn't exactly one texture coordinate per vertex
+	const Vec2f* Texcoords() const;
+
+	//!@brief Calculates the bounding box and sphere of the vertices and
+	//!of each group
+	//!
+	//!The spheres are centered on the boxes, with the radius reaching the
+	//!furthest vertex. Called by Open() before the cache is written, and
+	//!by Benchmark for meshes it builds itself.
+	GLvoid CalculateBounds();
+
 	//!@brief Creates vertex/index buffer objects from the vertex/group 
 	//!data
 	//!
-	//!Creates a VBO for the vertex/normal/texture coordinate arrays and a
-	//!index buffer object for each group.
-	GLvoid CreateBufferObjects();
+	//!Creates a VBO for the vertex/normal/texture coordinate arrays and an
+	//!index buffer object for each group, then the vertex array objects 
+	//!with CreateVertexArrays(). If the mesh was loaded from its binary 
+	//!cache the buffers are filled straight from the mapped file. The 
+	//!materials are packed into materialBuffer, one std140 Material block
+	//!each (see UniformBlockBindings).
+	//!With VERTEX_FORMAT_QUANTIZED the vertices are quantized against the
+	//!bounding box first, the shader has to decode them (see Draw()).
+	//!@param [in] format - The VertexFormats layout of the VBO
+	GLvoid CreateBufferObjects(GLuint format=VERTEX_FORMAT_FLOAT);
+
+	//!@brief Creates a vertex array object for each group
+	//!
+	//!Each records the attribute pointers into the VBO and the group's 
+	//!index buffer, so drawing a group takes a single bind. Called by 
+	//!CreateBufferObjects(). Vertex arrays aren't shared between contexts,
+	//!so call it again when the context is re-created, the old names are
+	//!replaced without being deleted. Instances have to be attached again
+	//!afterwards.
+	GLvoid CreateVertexArrays();
+
+	//!@brief Reorders the triangles of every group for the post-transform
+	//!vertex cache
+	//!
+	//!The groups are reordered on multiple threads with 
+	//!VertexCache::Optimize(), the cache use before and after is recorded in
+	//!stats. Does nothing if the mesh was loaded from its binary cache.
+	GLvoid OptimizeIndices();
+
+	//!@brief Reorders the vertices in the order the groups first use them
+	//!
+	//!The normals, if calculated, and the texture coordinates, if there is
+	//!one per vertex, are reordered with the vertices and the indices of 
+	//!every group are rewritten, since all groups share the vertex array.
+	//!Vertices no group uses are moved to the end. The estimated vertex 
+	//!fetch cache misses before and after are recorded in stats. Does 
+	//!nothing if the mesh was loaded from its binary cache.
+	GLvoid RemapVertices();
+
+	//!@brief Splits every group into meshlets
+	//!
+	//!The groups are split on multiple threads with Meshlet::Build(). The
+	//!index arrays aren't changed, so this works for meshes loaded from 
+	//!their binary cache too.
+	GLvoid BuildMeshlets();
+
+	//!@brief Builds the simplified levels of detail of every group
+	//!
+	//!The groups are simplified on multiple threads with 
+	//!Simplifier::Simplify(), one group per task, so a mesh made of a
+	//!single large group is simplified on one thread. Vertices used by 
+	//!several groups, vertices sharing their position with another vertex
+	//!and vertices on open borders are kept, so the groups still meet, 
+	//!texture seams don't tear and holes don't grow. The levels use the 
+	//!same vertices as the full mesh, so they share its VBO. Call before
+	//!CreateBufferObjects(), which appends them to the index buffer 
+	//!objects.
+	GLvoid BuildLods();
+
+	//!@brief Selects the coarsest level of detail that looks like the full
+	//!mesh
+	//!
+	//!The error of a level is projected from the point of the bounding 
+	//!sphere nearest to the camera.
+	//!@param [in] camera - The position of the camera in model space
+	//!@param [in] pixelsPerUnit - The height in pixels of one unit at a 
+	//!distance of one unit, the viewport height divided by 2*tan(fovy/2)
+	//!@param [in] maxError - The largest error allowed on screen, in pixels
+	//!@return The selected level, also stored in lod
+	GLuint SelectLod(const Vector3 &camera, GLfloat pixelsPerUnit, 
+			GLfloat maxError=1.0f);
+
+	//!@brief Culls the meshlets that can't be seen
+	//!
+	//!Meshlets outside the view frustum or facing away from the camera are
+	//!culled, and the index ranges of the remaining meshlets are merged 
+	//!into as few ranges as possible. Draw() then only draws those ranges.
+	//!Groups without meshlets are drawn whole.
+	//!@param [in] modelviewprojection - The matrix the mesh is drawn with
+	//!@param [in] camera - The position of the camera in model space
+	//!@param [in] frontFace - The winding of front faces, GL_CCW or GL_CW
+	//!@return The number of meshlets and triangles culled
+	MeshletCullStats CullMeshlets(const Matrix4 &modelviewprojection, 
+			const Vector3 &camera, GLenum frontFace = GL_CCW);
+
+	//!@brief Finds the groups outside the view frustum
+	//!
+	//!The planes are extracted from the matrix, so the groups' bounds are
+	//!tested in model space. Each group's sphere is tested, then its box.
+	//!Draw() skips the groups that aren't visible, the groups stay culled
+	//!until the next call.
+	//!@param [in] modelviewprojection - The matrix the mesh is drawn with
+	//!@return The number of groups and triangles culled
+	GroupCullStats CullGroups(const Matrix4 &modelviewprojection);
+
+	//!@brief Adds the triangles of the largest groups on the screen to the
+	//!occluders of a culler
+	//!
+	//!Only the groups CullGroups() left visible are added, the largest 
+	//!first, as long as their triangles fit in the budget. Groups with 
+	//!levels of detail add the coarsest level whose error stays within 
+	//!MESH_OCCLUDER_LOD_ERROR pixels of the culler's depth buffer at the
+	//!group's nearest point, otherwise their own triangles. A coarser
+	//!level could cover pixels the group doesn't and hide objects that 
+	//!can be seen.
+	//!@param [in] culler - The culler
+	//!@param [in] modelviewprojection - The matrix the mesh is drawn with
+	//!@param [in] minSize - The smallest diameter, in pixels of the 
+	//!culler's depth buffer, of the bounding sphere of a group added
+	//!@param [in] maxTriangles - The most triangles added
+	//!@param [in] frontFace - The winding of front faces, GL_CCW or GL_CW
+	GLvoid AddOccluders(OcclusionCuller &culler, 
+			const Matrix4 &modelviewprojection, 
+			GLfloat minSize = MESH_OCCLUDER_MIN_SIZE,
+			size_t maxTriangles = MESH_OCCLUDER_TRIANGLES,
+			GLenum frontFace = GL_CCW) const;
+
+	//!@brief Finds the groups hidden behind the occluders of a culler
+	//!
+	//!Only the groups CullGroups() left visible are tested, the hidden 
+	//!ones are marked like the groups outside the frustum, so Draw() skips
+	//!them. The time spent and the hidden triangles are added to the 
+	//!culler's stats.
+	//!@param [in] culler - The culler, rasterized already
+	//!@param [in] modelviewprojection - The matrix the mesh is drawn with
+	//!@return The number of groups hidden
+	size_t CullOccluded(OcclusionCuller &culler, 
+			const Matrix4 &modelviewprojection);
 
 	//!@brief Calculates the vertex normals
 	//!
@@ -90,7 +500,12 @@ struct Mesh {
 	//!normalized weighted sum of the surface normals of the surrounding 
 	//!triangles/faces. Larger surfaces will produce larger normals which
 	//!influences the vertex normals towards that surface, this provides
-	//!the weighting.
+	//!the weighting. Does nothing if the normals were already calculated or
+	//!loaded from the binary cache.
+	//!
+	//!The triangle normals are calculated on multiple threads, then each 
+	//!vertex gathers the normals of the triangles around it, so no two 
+	//!threads add to the same vertex. The sums use the Simd operations.
 	GLvoid CalculateNormals();
 
 	//!@brief Deletes all vector containers and buffer objects
@@ -104,9 +519,54 @@ struct Mesh {
 	//!@brief Calls Close()
 	~Mesh();
 	
+	//!@brief Returns the Material block of a group in materialBuffer
+	//!@param [in] grp - The group
+	//!@return The index of the block, the block starts at the index times
+	//!materialStride
+	GLuint MaterialBlock(const TriangleGroup &grp) const;
+
+	//!@brief Issues the draw calls of one group
+	//!
+	//!Draws the selected level of detail, or the meshlets left by 
+	//!CullMeshlets(), like Draw(). The group's vertex array object and 
+	//!Material block have to be bound already, RenderQueue binds them only
+	//!when they change.
+	//!@param [in] grp - The group to draw
+	GLvoid DrawGroup(const TriangleGroup &grp) const;
+
 	//!@brief Temporary to test rendering of mesh
+	//!
+	//!Positions go to attribute 0, normals to attribute 1 and texture
+	//!coordinates, if the format has them, to attribute 2. Quantized 
+	//!positions arrive as fractions of the bounding box, to be scaled by
+	//!bounds.Size() and offset by bounds.min, and quantized normals arrive 
+	//!as the two octahedral components, scaled by 32767. Levels of detail
+	//!other than 0 are drawn whole, without culling. Each group is drawn 
+	//!by binding its vertex array object, see CreateBufferObjects(), and
+	//!the range of materialBuffer holding its material to 
+	//!UNIFORM_BLOCK_MATERIAL. Groups culled by CullGroups() are skipped.
 	//!@note This is temporary!
 	GLvoid Draw() const;
+
+	//!@brief Makes the vertex array objects of the groups read the 
+	//!instance attributes from the buffer
+	//!
+	//!The model matrix goes to attributes INSTANCE_ATTRIBUTE_MODEL to
+	//!INSTANCE_ATTRIBUTE_MODEL+3 and the color to INSTANCE_ATTRIBUTE_COLOR,
+	//!with a divisor of 1. Call after CreateBufferObjects() and after the
+	//!first InstanceBuffer::Upload(), which creates the buffer's VBO. The
+	//!attributes stay attached until the buffer objects are deleted.
+	//!@param [in] instances - The buffer holding the instances
+	GLvoid AttachInstances(const InstanceBuffer &instances);
+
+	//!@brief Draws copies of the mesh with one glDrawElementsInstanced()
+	//!per group
+	//!
+	//!Like Draw(), but the shader reads each copy's model matrix and color
+	//!from the attached InstanceBuffer. Culled groups and meshlets are 
+	//!ignored, they were culled for a single copy.
+	//!@param [in] count - The number of instances to draw
+	GLvoid DrawInstanced(GLsizei count) const;
 };
 
 #endif // __MESH__
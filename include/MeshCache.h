@@ -0,0 +1,130 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __MESHCACHE__
+#define __MESHCACHE__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <MappedFile.h>
+#include <Vector3.h>
+
+struct Mesh;
+
+//!@brief The version of the binary mesh cache format. Caches written with
+//!any other version are ignored and rewritten.
+#define MESH_CACHE_VERSION 6
+
+//!@brief The header at the start of a binary mesh cache file
+//!
+//!All offsets are in bytes from the start of the file and are aligned to
+//!16 bytes. The vertex array holds numVerts positions followed by numVerts
+//!normals, exactly like Mesh::v, and the texture coordinate array holds 
+//!numTexcoords entries, exactly like Mesh::vt. The materials are stored as
+//!names, the MTL file and the material name of each as NUL terminated 
+//!strings, like Mesh::materialNames.
+struct MeshCacheHeader {
+
+	GLchar magic[4]; //!<Always "MESH"
+	GLuint version; //!<MESH_CACHE_VERSION of the program that wrote the file
+	GLuint flags; //!<The MeshLoadFlags that affect the cached data
+	GLuint numVerts; //!<The number of vertices (and normals)
+	GLuint numGroups; //!<The number of triangle groups
+	GLuint numMaterials; //!<The number of materials
+	GLuint numTexcoords; //!<The number of texture coordinates
+	uint64_t sourceSize; //!<Size of the OBJ file the cache was built from
+	int64_t sourceTime; //!<Modification time of the OBJ file
+	uint64_t sourceHash; //!<Hash of the OBJ file, see MeshCache::Hash()
+	GLfloat min[3]; //!<The smallest corner of the mesh's bounding box
+	GLfloat max[3]; //!<The largest corner of the mesh's bounding box
+	GLfloat center[3]; //!<The center of the mesh's bounding sphere
+	GLfloat radius; //!<The radius of the mesh's bounding sphere
+	uint64_t vertexOffset; //!<Offset of the vertex/normal array
+	uint64_t groupOffset; //!<Offset of the MeshCacheGroup array
+	uint64_t materialOffset; //!<Offset of the material names
+	uint64_t materialSize; //!<Size of the material names in bytes
+	uint64_t texcoordOffset; //!<Offset of the texture coordinate array
+};
+
+//!@brief Describes one triangle group in a binary mesh cache file
+struct MeshCacheGroup {
+
+	uint64_t indexOffset; //!<Offset of the group's index array
+	GLuint count; //!<Number of indices in the group
+	GLuint mtl; //!<Index of the group's material, or NO_MATERIAL
+	GLfloat min[3]; //!<The smallest corner of the group's bounding box
+	GLfloat max[3]; //!<The largest corner of the group's bounding box
+	GLfloat center[3]; //!<The center of the group's bounding sphere
+	GLfloat radius; //!<The radius of the group's bounding sphere
+};
+
+//!@brief A binary cache of a fully loaded mesh
+//!
+//!The cache is written next to the OBJ file the first time the OBJ file is
+//!loaded, and is memory mapped when it's loaded again. The arrays are used
+//!straight from the mapping, nothing is parsed or copied. A cache is
+//!invalidated when the size, modification time or hash of the OBJ file 
+//!changes, or when it was written with different load flags. Only the 
+//!names of the materials are cached, they're looked up in their MTL files
+//!again, so edited MTL files are never stale.
+struct MeshCache {
+
+	MappedFile file; //!<The mapped cache file
+	const MeshCacheHeader *header; //!<The header, NULL if nothing is mapped
+	const Vector3 *vertices; //!<The vertex array followed by the normals
+	const MeshCacheGroup *groups; //!<The array of groups
+	std::vector<std::string> materialNames; //!<The MTL file and the name of
+	                                        //!<each material, one after 
+	                                        //!<the other
+	const Vec2f *texcoords; //!<The array of texture coordinates
+
+	//!@brief Constructs an empty cache
+	MeshCache();
+
+	//!@brief Returns the name of the cache file for an OBJ file
+	//!@param [in] source - The name of the OBJ file
+	//!@return The OBJ filename with the extension replaced by ".mesh"
+	static const std::string Filename(const std::string &source);
+
+	//!@brief Computes a hash identifying the contents of a file
+	//!
+	//!Only the size and the first and last megabyte of the file are hashed,
+	//!so validating the cache of a multi gigabyte file stays cheap. Edits
+	//!elsewhere in the file are caught by the modification time.
+	//!@param [in] source - The mapped file
+	//!@return The 64 bit FNV-1a hash
+	static uint64_t Hash(const MappedFile &source);
+
+	//!@brief Maps the cache file of the OBJ file and validates it
+	//!@param [in] source - The name of the OBJ file
+	//!@param [in] flags - The content affecting MeshLoadFlags
+	//!@return True if a valid cache was mapped, false otherwise
+	GLboolean Open(const std::string &source, GLuint flags);
+
+	//!@brief Returns the index array of a group
+	//!@param [in] group - The index of the group
+	//!@return A pointer into the mapped file
+	const GLuint* Indices(GLuint group) const;
+
+	//!@brief Writes the mesh to the cache file of the OBJ file
+	//!
+	//!The mesh's normals must have been calculated. The file is written 
+	//!under a temporary name and then renamed, so readers never see a 
+	//!partially written cache.
+	//!@param [in] mesh - The mesh to write
+	//!@param [in] source - The name of the OBJ file the mesh was loaded from
+	//!@param [in] flags - The content affecting MeshLoadFlags
+	//!@return True if the file was written, false otherwise
+	static GLboolean Write(const Mesh &mesh, const std::string &source,
+			GLuint flags);
+
+	//!@brief Unmaps the cache file
+	GLvoid Close();
+};
+
+#endif // __MESHCACHE__
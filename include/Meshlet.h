@@ -0,0 +1,104 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __MESHLET__
+#define __MESHLET__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+#include <vector>
+
+#include <Vector3.h>
+#include <Bounds.h>
+
+//!@brief The largest number of vertices in a meshlet
+#define MESHLET_MAX_VERTICES 64
+
+//!@brief The largest number of triangles in a meshlet
+#define MESHLET_MAX_TRIANGLES 124
+
+//!@brief A small cluster of neighbouring triangles of a group
+//!
+//!The triangles of a meshlet are a contiguous range of the group's index 
+//!array, so a meshlet can be drawn with one glDrawElements() call. Each
+//!meshlet also lists its vertices, and its triangles as 8 bit indices into
+//!that list. The bounding sphere and the cone containing the triangles'
+//!normals let whole meshlets be culled on the CPU.
+struct Meshlet {
+
+	GLuint indexOffset; //!<The first index of the meshlet in the group's
+	                    //!<index array
+	GLuint vertexOffset; //!<The first vertex of the meshlet in 
+	                     //!<TriangleGroup::meshletVertices
+	GLuint triangleOffset; //!<The first local index of the meshlet in
+	                       //!<TriangleGroup::meshletIndices
+	GLuint vertexCount; //!<The number of vertices, at most 
+	                    //!<MESHLET_MAX_VERTICES
+	GLuint triangleCount; //!<The number of triangles, at most
+	                      //!<MESHLET_MAX_TRIANGLES
+	Vector3 center; //!<The center of the bounding sphere
+	GLfloat radius; //!<The radius of the bounding sphere
+	Vector3 coneAxis; //!<The average direction of the triangles' normals
+	GLfloat coneCos; //!<Cosine of the cone's half angle, at most 0 if the 
+	                 //!<normals are too spread out to be culled together
+	GLfloat coneSin; //!<Sine of the cone's half angle
+
+	//!@brief Constructs an empty meshlet that is never culled
+	Meshlet();
+
+	//!@brief Checks if every triangle of the meshlet faces away from the
+	//!camera
+	//!
+	//!The cone holds the normals of counterclockwise triangles, the 
+	//!winding Mesh::CalculateNormals() uses. With GL_CW front faces the
+	//!axis is flipped. The test is conservative: a meshlet that is only 
+	//!partially back facing is never reported as back facing.
+	//!@param [in] camera - The position of the camera, in model space
+	//!@param [in] frontFace - The winding of front faces, GL_CCW or GL_CW
+	//!@return True if the meshlet can't be seen from the camera
+	GLboolean Backfacing(const Vector3 &camera, 
+			GLenum frontFace = GL_CCW) const;
+
+	//!@brief Splits a triangle list into meshlets
+	//!
+	//!The triangles are taken in order, a new meshlet is started whenever
+	//!the next triangle doesn't fit into the current one, so reordering 
+	//!the triangles for the vertex cache first gives compact meshlets.
+	//!@param [in] vertices - The vertex positions
+	//!@param [in] indices - The triangle list
+	//!@param [in] count - The number of indices, a multiple of three
+	//!@param [out] meshlets - Receives the meshlets
+	//!@param [out] meshletVertices - Receives the vertices of every meshlet
+	//!@param [out] meshletIndices - Receives the local indices of every
+	//!meshlet
+	static GLvoid Build(const Vector3 *vertices, const GLuint *indices, 
+			size_t count, std::vector<Meshlet> &meshlets, 
+			std::vector<GLuint> &meshletVertices, 
+			std::vector<GLubyte> &meshletIndices);
+};
+
+//!@brief Counters of a pass of meshlet culling
+struct MeshletCullStats {
+
+	size_t meshlets; //!<The number of meshlets tested
+	size_t triangles; //!<The number of triangles in those meshlets
+	size_t frustumCulled; //!<Meshlets outside the view frustum
+	size_t backfaceCulled; //!<Meshlets facing away from the camera
+	size_t culledTriangles; //!<Triangles in the culled meshlets
+
+	//!@brief Constructs zeroed counters
+	MeshletCullStats();
+
+	//!@brief Adds the counters of another pass
+	//!@param [in] s - The counters to add
+	GLvoid Add(const MeshletCullStats &s);
+
+	//!@brief Describes the counters
+	//!@return A string containing the number of meshlets and triangles 
+	//!tested and culled
+	const std::string ToString() const;
+};
+
+#endif // __MESHLET__
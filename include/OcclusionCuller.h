@@ -0,0 +1,123 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __OCCLUSIONCULLER__
+#define __OCCLUSIONCULLER__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+#include <vector>
+
+#include <Vector3.h>
+#include <Matrix4.h>
+#include <Bounds.h>
+
+//!@brief The default size of the depth buffer of an OcclusionCuller
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+
+//!@brief The rows of the depth buffer rasterized by one task
+#define OCCLUSION_BAND_ROWS 16
+
+//!@brief Counters and timings of a frame of occlusion culling
+struct OcclusionStats {
+
+	size_t occluderTriangles; //!<Triangles rasterized into the depth buffer
+	size_t tested; //!<Boxes tested against the pyramid
+	size_t occluded; //!<Boxes found to be hidden
+	size_t occludedTriangles; //!<Triangles of the hidden groups, counted by
+	                          //!<Mesh::CullOccluded()
+	GLfloat rasterTime; //!<Microseconds spent rasterizing and building the
+	                    //!<pyramid
+	GLfloat testTime; //!<Microseconds spent testing boxes, measured by
+	                  //!<Mesh::CullOccluded()
+
+	//!@brief Constructs zeroed counters
+	OcclusionStats();
+
+	//!@brief Adds the counters of another frame
+	//!@param [in] s - The counters to add
+	GLvoid Add(const OcclusionStats &s);
+
+	//!@brief Describes the counters
+	//!@return A string containing the objects tested and occluded, and the
+	//!time spent
+	const std::string ToString() const;
+};
+
+//!@brief Culls objects hidden behind occluders, on the CPU
+//!
+//!Occluder triangles are rasterized into a small depth buffer, a band of
+//!OCCLUSION_BAND_ROWS rows per task on multiple threads and four pixels
+//!at a time with the Simd operations. Each level of the hierarchical
+//!depth pyramid built from it holds the farthest depth of four texels of
+//!the level below. An object is hidden if the nearest point of its
+//!bounding box is farther than the farthest occluder depth in the
+//!rectangle the box covers on the screen, read from the level where that
+//!rectangle covers at most two by two texels.
+//!
+//!Depths are window depths, 0 at the near plane and 1 at the far plane.
+//!Triangles and boxes crossing the near plane are never occluders and
+//!never hidden. Back faces are never occluders either. Occluders are 
+//!sampled at the centers of the pixels, so objects seen only through 
+//!gaps narrower than a pixel may be culled.
+//!No OpenGL calls are made.
+struct OcclusionCuller {
+
+	GLuint width; //!<The width of the depth buffer, a multiple of 4
+	GLuint height; //!<The height of the depth buffer
+	std::vector<GLfloat> triangles; //!<The window x, y and depth of the
+	                                //!<corners of the occluder triangles
+	std::vector<GLuint> bins; //!<The triangles overlapping each band of
+	                          //!<rows, band after band
+	std::vector<GLuint> binStarts; //!<Where each band starts in bins, then
+	                               //!<the size of bins
+	std::vector< std::vector<GLfloat> > levels; //!<The depth buffer, then
+	                                            //!<each level of the pyramid
+	std::vector<GLuint> sizes; //!<The width and height of each level
+	OcclusionStats stats; //!<The counters since the last Clear()
+
+	//!@brief Constructs a culler with an OCCLUSION_WIDTH by
+	//!OCCLUSION_HEIGHT depth buffer
+	OcclusionCuller();
+
+	//!@brief Changes the size of the depth buffer
+	//!@param [in] width - The width in pixels, rounded up to a multiple of
+	//!4
+	//!@param [in] height - The height in pixels
+	GLvoid Resize(GLuint width, GLuint height);
+
+	//!@brief Removes the occluders and zeroes stats, to start a frame
+	GLvoid Clear();
+
+	//!@brief Transforms occluder triangles to the window and keeps them
+	//!for Rasterize()
+	//!
+	//!Back faces are left out, like OpenGL culls them. On an open mesh 
+	//!they may not hide what is seen through the opening.
+	//!@param [in] modelviewprojection - The matrix the triangles are drawn
+	//!with
+	//!@param [in] vertices - The vertex array
+	//!@param [in] indices - Three indices per triangle
+	//!@param [in] count - The number of indices
+	//!@param [in] frontFace - The winding of front faces, GL_CCW or GL_CW
+	GLvoid AddOccluder(const Matrix4 &modelviewprojection,
+			const Vector3 *vertices, const GLuint *indices, size_t count,
+			GLenum frontFace = GL_CCW);
+
+	//!@brief Rasterizes the occluders and builds the pyramid
+	GLvoid Rasterize();
+
+	//!@brief Tests a box against the pyramid
+	//!
+	//!Call Rasterize() first.
+	//!@param [in] modelviewprojection - The matrix the box is drawn with
+	//!@param [in] box - The box
+	//!@return True if the box is hidden behind the occluders
+	GLboolean Occluded(const Matrix4 &modelviewprojection,
+			const BoundingBox &box);
+};
+
+#endif // __OCCLUSIONCULLER__
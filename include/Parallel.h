@@ -0,0 +1,41 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __PARALLEL__
+#define __PARALLEL__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+
+//!@brief Runs independent tasks on multiple threads
+//!
+//!A task is a function taking the index of the task and a pointer to data
+//!shared by all tasks. Tasks are handed out to the threads one at a time, so
+//!the tasks should be coarse (at least tens of microseconds of work each).
+struct Parallel {
+
+	//!@brief The maximum number of threads to use, 0 uses one thread per
+	//!processor. Mostly useful to measure scaling.
+	static GLuint maxThreads;
+
+	//!@brief A task function
+	//!@param [in] index - The index of the task, from 0 to count-1
+	//!@param [in] data - The data pointer passed to For()
+	typedef GLvoid (*Task)(GLuint index, GLvoid *data);
+
+	//!@brief Returns the number of threads For() will use
+	//!@return The number of online processors, limited by maxThreads
+	static GLuint ThreadCount();
+
+	//!@brief Runs count tasks and waits for all of them to finish
+	//!
+	//!The calling thread runs tasks as well. If there is only one thread or
+	//!one task the tasks simply run in order on the calling thread.
+	//!@param [in] count - The number of tasks to run
+	//!@param [in] task - The function to call for each task
+	//!@param [in] data - Pointer passed to every call of the function
+	static GLvoid For(GLuint count, Task task, GLvoid *data);
+};
+
+#endif // __PARALLEL__
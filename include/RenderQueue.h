@@ -0,0 +1,142 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __RENDERQUEUE__
+#define __RENDERQUEUE__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <Matrix4.h>
+#include <Vec.h>
+#include <Shader.h>
+#include <Mesh.h>
+
+//!@brief The widths of the fields of a RenderQueue sort key
+//!
+//!From the most significant bits: the pass, the shader, the material, the
+//!mesh and the depth. Items are drawn in ascending key order, so all the
+//!items of a pass are drawn before the next pass, and within a pass the
+//!items sharing a shader, then a material, then a mesh are drawn together.
+#define RENDER_KEY_PASS_BITS 4
+#define RENDER_KEY_SHADER_BITS 8
+#define RENDER_KEY_MATERIAL_BITS 16
+#define RENDER_KEY_MESH_BITS 12
+#define RENDER_KEY_DEPTH_BITS 24
+
+//!@brief One group of a mesh waiting to be drawn
+struct RenderItem {
+
+	Shader *shader; //!<The shader to draw with
+	const Mesh *mesh; //!<The mesh the group belongs to
+	GLuint group; //!<The index of the group in Mesh::g
+	GLuint transform; //!<The index of the matrices in RenderQueue
+};
+
+//!@brief An item's sort key and its index in RenderQueue::items
+struct RenderSortEntry {
+
+	uint64_t key; //!<The packed sort key
+	GLuint item; //!<The index of the item
+};
+
+//!@brief Counts the state changes and draws of a frame
+struct RenderQueueStats {
+
+	size_t items; //!<Items drawn
+	size_t programChanges; //!<Calls to glUseProgram()
+	size_t materialChanges; //!<Material blocks bound
+	size_t vaoChanges; //!<Vertex array objects bound
+	size_t transformChanges; //!<Model and normal matrices set
+
+	//!@brief Constructs zeroed counters
+	RenderQueueStats();
+
+	//!@brief Returns the number of state changes of all kinds
+	//!@return The sum of the changes
+	size_t Changes() const;
+
+	//!@brief Describes the counters
+	//!@return A string containing the items and the changes of each kind
+	const std::string ToString() const;
+};
+
+//!@brief Collects the draws of a frame and draws them sorted by their keys
+//!
+//!Submitters push one item per group with a sort key built by Key().
+//!Execute() sorts the items with a radix sort over the 64 bit keys and
+//!draws them, only changing the program, the Material block, the vertex
+//!array object and the "model" and "normalmatrix" uniforms when they
+//!differ from the previous item's. Items with equal keys keep the order
+//!they were submitted in.
+struct RenderQueue {
+
+	std::vector<RenderItem> items; //!<The items, in submission order
+	std::vector<Mat4f> transforms; //!<Pairs of model and normal matrices
+	std::vector<RenderSortEntry> order; //!<The keys and items, sorted by
+	                                    //!<Sort()
+	std::vector<RenderSortEntry> scratch; //!<The other buffer of the sort
+	RenderQueueStats stats; //!<The changes made by the last Execute()
+
+	//!@brief Packs the fields of a sort key
+	//!
+	//!Fields wider than their bits in the key are cut to the lowest bits.
+	//!@param [in] pass - The pass, like opaque or transparent
+	//!@param [in] shader - An identifier of the shader
+	//!@param [in] material - An identifier of the material
+	//!@param [in] mesh - An identifier of the mesh
+	//!@param [in] depth - The distance from the camera, from 0 to 1. Pass
+	//!1-depth to draw back to front.
+	//!@return The key
+	static uint64_t Key(GLuint pass, GLuint shader, GLuint material,
+			GLuint mesh, GLfloat depth);
+
+	//!@brief Removes all the items and matrices, to submit the next frame
+	GLvoid Clear();
+
+	//!@brief Adds the matrices of an object, shared by the items of all
+	//!its groups
+	//!@param [in] model - The model matrix
+	//!@param [in] normal - The normal matrix
+	//!@return The index to pass to Submit()
+	GLuint AddTransform(const Matrix4 &model, const Matrix4 &normal);
+
+	//!@brief Adds an item
+	//!@param [in] key - The sort key, built by Key()
+	//!@param [in] shader - The shader to draw with
+	//!@param [in] mesh - The mesh, its buffer objects must have been
+	//!created
+	//!@param [in] group - The index of the group in mesh->g
+	//!@param [in] transform - The index returned by AddTransform()
+	GLvoid Submit(uint64_t key, Shader *shader, const Mesh *mesh,
+			GLuint group, GLuint transform);
+
+	//!@brief Sorts the items by their keys
+	//!
+	//!A least significant digit radix sort, one byte per pass. Passes on
+	//!bytes that are the same in every key are skipped.
+	GLvoid Sort();
+
+	//!@brief Counts the state changes drawing the items in their current
+	//!order would make, without calling OpenGL
+	//!@return The counters
+	RenderQueueStats Simulate() const;
+
+	//!@brief Sorts and draws the items
+	//!@return The changes made, also stored in stats
+	RenderQueueStats Execute();
+
+	private:
+
+		//!@brief Walks the items in their current order, counting the
+		//!state changes and, if draw is set, making them and drawing
+		//!@param [in] draw - Call OpenGL
+		//!@return The counters
+		RenderQueueStats Walk(GLboolean draw) const;
+};
+
+#endif // __RENDERQUEUE__
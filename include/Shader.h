@@ -10,13 +10,80 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <map>
+
+//!@brief The most floats a uniform's value cache holds, enough for a mat4.
+//!Larger uniforms, like arrays, are uploaded every time.
+#define SHADER_UNIFORM_CACHE 16
+
+//!@brief Uniforms set while drawing by code that doesn't know the shader,
+//!like RenderQueue. Their handles are looked up once by QueryVariables()
+//!and kept in Shader::slots.
+enum ShaderUniformSlots {
+	SHADER_UNIFORM_MODEL = 0, //!<The "model" matrix
+	SHADER_UNIFORM_NORMALMATRIX = 1, //!<The "normalmatrix" matrix
+	SHADER_UNIFORM_SLOTS = 2 //!<The number of slots
+};
+
+//!@brief An active vertex attribute of a linked program
+struct ShaderAttribute {
+
+	std::string name; //!<The name of the attribute
+	GLint location; //!<The location to pass to glVertexAttribPointer()
+	GLenum type; //!<The GL type, like GL_FLOAT_VEC4
+	GLint size; //!<The number of array elements, 1 if not an array
+};
+
+//!@brief An active uniform of a linked program and the last value uploaded
+//!to it
+struct ShaderUniform {
+
+	std::string name; //!<The name of the uniform, without a trailing [0]
+	GLint location; //!<The location to pass to glUniform*()
+	GLenum type; //!<The GL type, like GL_FLOAT_MAT4
+	GLint size; //!<The number of array elements, 1 if not an array
+	GLboolean cached; //!<value holds what was last uploaded
+	GLfloat value[SHADER_UNIFORM_CACHE]; //!<The last value uploaded, ints
+	                                     //!<are stored bit for bit
+};
+
+//!@brief Counts the uniform uploads of a shader
+struct ShaderUniformStats {
+
+	size_t issued; //!<Values that were uploaded with glUniform*()
+	size_t skipped; //!<Values that equaled the last upload and were skipped
+
+	//!@brief Constructs zeroed counters
+	ShaderUniformStats();
+
+	//!@brief Describes the counters
+	//!@return A string containing the uploads issued and skipped
+	const std::string ToString() const;
+};
 
 //!@brief Creates a shader program
+//!
+//!After linking, the program's active uniforms and attributes are listed
+//!once, so they aren't looked up by name while drawing. Uniform() returns 
+//!a handle for the SetUniform() methods, which only call glUniform*() if 
+//!the value differs from the one last uploaded.
 struct Shader {
 
 	std::vector<GLuint> shaderObjects; //!<A list of handles to shader objects
 	GLuint program; //!<A handle to the shader program
 	std::string errString; //!<Stores the error message
+	std::vector<ShaderUniform> uniforms; //!<The active uniforms
+	std::vector<ShaderAttribute> attributes; //!<The active attributes
+	std::map<std::string, GLint> uniformLookup; //!<Maps names to indices 
+	                                             //!<into uniforms
+	GLint slots[SHADER_UNIFORM_SLOTS]; //!<The handles of the uniforms in
+	                                   //!<ShaderUniformSlots, -1 if the 
+	                                   //!<program hasn't got them
+	ShaderUniformStats uniformStats; //!<Uploads issued and skipped by the
+	                                 //!<SetUniform() methods
+
+	//!@brief Constructs a shader without a program
+	Shader();
 
 	//!@brief Loads multiple shaders from the specified file, compiles and
 	//!links them
@@ -68,14 +135,76 @@ struct Shader {
 	//!@brief Creates a shader program with the shader objects
 	//!
 	//!CompileShader must have been called at least once for this method to 
-	//!have any effect
+	//!have any effect. The active uniforms and attributes of the program
+	//!are then listed with QueryVariables().
 	//!@return The handle to the shader program
 	GLuint LinkShaderObjects();
 
+	//!@brief Lists the active uniforms and attributes of the program
+	//!
+	//!Fills uniforms, attributes, uniformLookup and slots, and forgets the
+	//!values uploaded to the previous program.
+	GLvoid QueryVariables();
+
+	//!@brief Looks up an active uniform
+	//!@param [in] name - The name of the uniform
+	//!@return The handle for SetUniform(), or -1 if the program has no 
+	//!active uniform of that name
+	GLint Uniform(const std::string &name) const;
+
+	//!@brief Looks up the location of an active attribute
+	//!@param [in] name - The name of the attribute
+	//!@return The location, or -1 if the program has no active attribute
+	//!of that name
+	GLint Attribute(const std::string &name) const;
+
+	//!@brief Connects a uniform block of the program to a binding point
+	//!
+	//!Programs that bind the same block to the same point share the 
+	//!buffer bound there, see UniformBlockBindings.
+	//!@param [in] name - The name of the block
+	//!@param [in] binding - The binding point
+	//!@return True if the program has an active block of that name, false
+	//!otherwise
+	GLboolean BindUniformBlock(const std::string &name, GLuint binding);
+
+	//!@brief Sets an int, bool or sampler uniform. The program must be in 
+	//!use, like for glUniform*(). Invalid handles are ignored.
+	//!@param [in] handle - The handle returned by Uniform()
+	//!@param [in] x - The value
+	GLvoid SetUniform(GLint handle, GLint x);
+
+	//!@brief Sets a float uniform
+	//!@param [in] handle - The handle returned by Uniform()
+	//!@param [in] x - The value
+	GLvoid SetUniform(GLint handle, GLfloat x);
+
+	//!@brief Sets a vec3 uniform
+	//!@param [in] handle - The handle returned by Uniform()
+	//!@param [in] x - The first component
+	//!@param [in] y - The second component
+	//!@param [in] z - The third component
+	GLvoid SetUniform(GLint handle, GLfloat x, GLfloat y, GLfloat z);
+
+	//!@brief Sets a vec4 uniform
+	//!@param [in] handle - The handle returned by Uniform()
+	//!@param [in] x - The first component
+	//!@param [in] y - The second component
+	//!@param [in] z - The third component
+	//!@param [in] w - The fourth component
+	GLvoid SetUniform(GLint handle, GLfloat x, GLfloat y, GLfloat z, 
+			GLfloat w);
+
+	//!@brief Sets a mat4 uniform
+	//!@param [in] handle - The handle returned by Uniform()
+	//!@param [in] m - The 16 elements, column major like Matrix4::mat
+	GLvoid SetUniformMatrix(GLint handle, const GLfloat *m);
+
 	//!@brief Deletes the list of shader objects
 	GLvoid DeleteShaderObjects();
 
-	//!@brief Deletes the shader program and all shader objects
+	//!@brief Deletes the shader program and all shader objects, and 
+	//!clears the uniform and attribute tables
 	GLvoid Close();
 
 	//!@brief Calls Close()
@@ -0,0 +1,324 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __SIMD__
+#define __SIMD__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <cmath>
+
+//Select the instruction set at compile time. SIMD_SSE, SIMD_NEON or
+//SIMD_SCALAR is defined, and SIMD_AVX as well if AVX is available.
+//Defining SIMD_FORCE_SCALAR builds the plain C++ operations on any 
+//processor, to check them against the others.
+#if defined(SIMD_FORCE_SCALAR)
+#define SIMD_SCALAR
+#elif defined(__SSE__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMD_SSE
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#define SIMD_AVX
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON
+#include <arm_neon.h>
+#else
+#define SIMD_SCALAR
+#endif
+
+#if defined(SIMD_SSE)
+typedef __m128 Simd4;
+#elif defined(SIMD_NEON)
+typedef float32x4_t Simd4;
+#else
+//!@brief Four floats, operated on one at a time
+struct Simd4 {
+	GLfloat f[4]; //!<The x, y, z and w components
+};
+#endif
+
+//!@brief Operations on four floats at a time
+//!
+//!Maps onto SSE, NEON or plain C++. Loads and stores don't require any
+//!alignment, since the vertex arrays are std::vectors of Vector3, which
+//!aren't guaranteed to be 16 byte aligned. The operations round like the
+//!scalar code they replace, sums are added left to right, so the results
+//!are the same on every instruction set.
+struct Simd {
+
+	//!@brief Loads four floats
+	//!@param [in] p - Pointer to the floats
+	//!@return The vector (p[0], p[1], p[2], p[3])
+	static inline Simd4 Load(const GLfloat *p)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_loadu_ps(p));
+#elif defined(SIMD_NEON)
+		return(vld1q_f32(p));
+#else
+		Simd4 a = {{p[0], p[1], p[2], p[3]}};
+		return(a);
+#endif
+	}
+
+	//!@brief Stores four floats
+	//!@param [out] p - Pointer to the floats
+	//!@param [in] a - The vector to store
+	static inline GLvoid Store(GLfloat *p, Simd4 a)
+	{
+#if defined(SIMD_SSE)
+		_mm_storeu_ps(p, a);
+#elif defined(SIMD_NEON)
+		vst1q_f32(p, a);
+#else
+		p[0] = a.f[0], p[1] = a.f[1], p[2] = a.f[2], p[3] = a.f[3];
+#endif
+	}
+
+	//!@brief Copies one float into all four components
+	//!@param [in] k - The float
+	//!@return The vector (k, k, k, k)
+	static inline Simd4 Splat(GLfloat k)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_set1_ps(k));
+#elif defined(SIMD_NEON)
+		return(vdupq_n_f32(k));
+#else
+		Simd4 a = {{k, k, k, k}};
+		return(a);
+#endif
+	}
+
+	//!@return The component wise sum a+b
+	static inline Simd4 Add(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_add_ps(a, b));
+#elif defined(SIMD_NEON)
+		return(vaddq_f32(a, b));
+#else
+		for(GLuint i = 0; i < 4; i++) a.f[i] += b.f[i];
+		return(a);
+#endif
+	}
+
+	//!@return The component wise difference a-b
+	static inline Simd4 Sub(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_sub_ps(a, b));
+#elif defined(SIMD_NEON)
+		return(vsubq_f32(a, b));
+#else
+		for(GLuint i = 0; i < 4; i++) a.f[i] -= b.f[i];
+		return(a);
+#endif
+	}
+
+	//!@return The component wise product a*b
+	static inline Simd4 Mul(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_mul_ps(a, b));
+#elif defined(SIMD_NEON)
+		return(vmulq_f32(a, b));
+#else
+		for(GLuint i = 0; i < 4; i++) a.f[i] *= b.f[i];
+		return(a);
+#endif
+	}
+
+	//!@return The component wise quotient a/b
+	static inline Simd4 Div(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_div_ps(a, b));
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+		return(vdivq_f32(a, b));
+#else
+		GLfloat f[4], g[4];
+		Store(f, a), Store(g, b);
+		for(GLuint i = 0; i < 4; i++) f[i] /= g[i];
+		return(Load(f));
+#endif
+	}
+
+	//!@return The component wise square root of a
+	static inline Simd4 Sqrt(Simd4 a)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_sqrt_ps(a));
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+		return(vsqrtq_f32(a));
+#else
+		GLfloat f[4];
+		Store(f, a);
+		for(GLuint i = 0; i < 4; i++) f[i] = sqrtf(f[i]);
+		return(Load(f));
+#endif
+	}
+
+	//!@return The component wise absolute value of a
+	static inline Simd4 Abs(Simd4 a)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_andnot_ps(_mm_set1_ps(-0.0f), a));
+#elif defined(SIMD_NEON)
+		return(vabsq_f32(a));
+#else
+		for(GLuint i = 0; i < 4; i++) a.f[i] = fabsf(a.f[i]);
+		return(a);
+#endif
+	}
+
+	//!@return The component wise minimum of a and b
+	static inline Simd4 Min(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_min_ps(a, b));
+#elif defined(SIMD_NEON)
+		return(vminq_f32(a, b));
+#else
+		for(GLuint i = 0; i < 4; i++) 
+			a.f[i] = (b.f[i] < a.f[i]) ? b.f[i] : a.f[i];
+		return(a);
+#endif
+	}
+
+	//!@return The component wise maximum of a and b
+	static inline Simd4 Max(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_max_ps(a, b));
+#elif defined(SIMD_NEON)
+		return(vmaxq_f32(a, b));
+#else
+		for(GLuint i = 0; i < 4; i++) 
+			a.f[i] = (b.f[i] > a.f[i]) ? b.f[i] : a.f[i];
+		return(a);
+#endif
+	}
+
+	//!@brief Compares the components, for Select()
+	//!@return A mask with the components where a is less than b set
+	static inline Simd4 LessThan(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_cmplt_ps(a, b));
+#elif defined(SIMD_NEON)
+		return(vreinterpretq_f32_u32(vcltq_f32(a, b)));
+#else
+		for(GLuint i = 0; i < 4; i++) a.f[i] = (a.f[i] < b.f[i]) ? 1.0f : 0.0f;
+		return(a);
+#endif
+	}
+
+	//!@brief Picks each component from one of two vectors
+	//!@param [in] mask - A mask built by LessThan()
+	//!@param [in] a - The components where the mask is set
+	//!@param [in] b - The components where the mask is clear
+	//!@return The blended vector
+	static inline Simd4 Select(Simd4 mask, Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)));
+#elif defined(SIMD_NEON)
+		return(vbslq_f32(vreinterpretq_u32_f32(mask), a, b));
+#else
+		for(GLuint i = 0; i < 4; i++) 
+			a.f[i] = (mask.f[i] != 0.0f) ? a.f[i] : b.f[i];
+		return(a);
+#endif
+	}
+
+	//!@brief Checks the signs of all four components at once
+	//!@return True if any component is less than zero
+	static inline GLboolean AnyNegative(Simd4 a)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_movemask_ps(_mm_cmplt_ps(a, _mm_setzero_ps())) != 0);
+#elif defined(SIMD_NEON)
+		uint32x4_t m = vcltq_f32(a, vdupq_n_f32(0.0f));
+		uint32x2_t h = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+		return((vget_lane_u32(h, 0) | vget_lane_u32(h, 1)) != 0);
+#else
+		return(a.f[0] < 0.0f || a.f[1] < 0.0f || a.f[2] < 0.0f || 
+			a.f[3] < 0.0f);
+#endif
+	}
+
+	//!@brief Rotates the x, y and z components, w stays in place
+	//!@return The vector (a.y, a.z, a.x, a.w)
+	static inline Simd4 RotateXYZ(Simd4 a)
+	{
+#if defined(SIMD_SSE)
+		return(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)));
+#elif defined(SIMD_NEON)
+		float32x2_t xy = vget_low_f32(a), zw = vget_high_f32(a);
+		return(vcombine_f32(vext_f32(xy, zw, 1),
+			vset_lane_f32(vget_lane_f32(xy, 0), zw, 0)));
+#else
+		Simd4 r = {{a.f[1], a.f[2], a.f[0], a.f[3]}};
+		return(r);
+#endif
+	}
+
+	//!@brief Returns one component
+	//!@param [in] a - The vector
+	//!@param [in] i - The component, 0 for x to 3 for w
+	//!@return The component
+	static inline GLfloat Get(Simd4 a, GLuint i)
+	{
+#if defined(SIMD_SSE)
+		GLfloat f[4];
+		_mm_storeu_ps(f, a);
+		return(f[i]);
+#elif defined(SIMD_NEON)
+		GLfloat f[4];
+		vst1q_f32(f, a);
+		return(f[i]);
+#else
+		return(a.f[i]);
+#endif
+	}
+
+	//!@brief Calculates the dot product of the x, y and z components
+	//!@return a.x*b.x+a.y*b.y+a.z*b.z
+	static inline GLfloat Dot3(Simd4 a, Simd4 b)
+	{
+#if defined(SIMD_SSE)
+		__m128 p = _mm_mul_ps(a, b);
+		return(_mm_cvtss_f32(_mm_add_ss(_mm_add_ss(p,
+			_mm_shuffle_ps(p, p, 1)), _mm_shuffle_ps(p, p, 2))));
+#elif defined(SIMD_NEON)
+		float32x4_t p = vmulq_f32(a, b);
+		return(vgetq_lane_f32(p, 0)+vgetq_lane_f32(p, 1)+
+			vgetq_lane_f32(p, 2));
+#else
+		return(a.f[0]*b.f[0]+a.f[1]*b.f[1]+a.f[2]*b.f[2]);
+#endif
+	}
+
+	//!@brief Calculates the cross product of the x, y and z components
+	//!@return The cross product, with w zeroed if a.w*b.w is finite
+	static inline Simd4 Cross3(Simd4 a, Simd4 b)
+	{
+		//(a.x*b.y-a.y*b.x, a.y*b.z-a.z*b.y, a.z*b.x-a.x*b.z) lands one
+		//component off, rotating it puts it in place
+		return(RotateXYZ(Sub(Mul(a, RotateXYZ(b)), Mul(RotateXYZ(a), b))));
+	}
+
+	//!@brief Divides the x, y and z components by their length
+	//!@return The unit vector, w is divided as well
+	static inline Simd4 Normalize3(Simd4 a)
+	{
+		return(Div(a, Splat(sqrtf(Dot3(a, a)))));
+	}
+};
+
+#endif // __SIMD__
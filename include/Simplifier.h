@@ -0,0 +1,46 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __SIMPLIFIER__
+#define __SIMPLIFIER__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <vector>
+
+#include <Vector3.h>
+
+//!@brief Reduces the number of triangles of a triangle list
+//!
+//!Uses quadric error metrics: every vertex has a quadric measuring the 
+//!squared distance to the planes of its triangles, and the edges whose 
+//!collapse adds the least error are collapsed first. Edges are collapsed
+//!onto one of their vertices, so the simplified triangles use the original
+//!vertex array.
+struct Simplifier {
+
+	//!@brief Simplifies a triangle list down to several target sizes
+	//!
+	//!Vertices on open borders and locked vertices never move. Collapses 
+	//!that would flip a triangle are skipped. The error of a level is the
+	//!largest distance of an original vertex from the simplified triangles
+	//!around the vertex it was collapsed onto, and never less than the 
+	//!error of the level before. Runs on the calling thread.
+	//!@param [in] vertices - The vertex positions
+	//!@param [in] locked - One byte per vertex, non zero for vertices that
+	//!must not be collapsed. May be NULL.
+	//!@param [in] indices - The triangle list
+	//!@param [in] count - The number of indices, a multiple of three
+	//!@param [in] targets - The index counts to simplify to, largest first
+	//!@param [out] lods - Receives one triangle list per target, with at 
+	//!most target indices unless too many vertices are locked
+	//!@param [out] errors - Receives the error of each triangle list
+	static GLvoid Simplify(const Vector3 *vertices, const GLubyte *locked,
+			const GLuint *indices, size_t count, 
+			const std::vector<size_t> &targets, 
+			std::vector<std::vector<GLuint> > &lods,
+			std::vector<GLfloat> &errors);
+};
+
+#endif // __SIMPLIFIER__
@@ -0,0 +1,119 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __STREAMBUFFER__
+#define __STREAMBUFFER__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+#include <deque>
+
+//!@brief The number of frames a StreamBuffer holds, the frame being written
+//!and the frames the GPU may still be reading
+#define STREAM_BUFFER_FRAMES 3
+
+//!@brief Counts the data streamed in a frame and the time spent waiting
+struct StreamBufferStats {
+
+	size_t bytes; //!<Bytes written through Map()
+	size_t allocations; //!<Calls to Map()
+	size_t waits; //!<Fences waited on because the ring was full
+	GLfloat waitTime; //!<Time spent waiting on fences in milliseconds
+	size_t orphans; //!<Times the storage was orphaned, without buffer
+	                //!<storage
+
+	//!@brief Constructs zeroed counters
+	StreamBufferStats();
+
+	//!@brief Describes the counters
+	//!@return A string containing the bytes streamed and the waits
+	const std::string ToString() const;
+};
+
+//!@brief A fence after the data of a frame
+struct StreamFence {
+
+	GLsync sync; //!<Signaled when the GPU is done with the frame
+	GLintptr start; //!<The offset of the frame's first byte
+	GLintptr end; //!<The offset after the frame's last byte
+};
+
+//!@brief A ring buffer for data written once a frame, like uniform blocks
+//!and instance transforms
+//!
+//!Map() hands out consecutive ranges of one buffer object, wrapping to the
+//!start when the end is reached. With GL_ARB_buffer_storage the buffer is
+//!mapped once, persistently and coherently, and EndFrame() fences the
+//!frame's ranges. Map() only waits on a fence when a range would overwrite
+//!data the GPU may still read, which means the CPU is about
+//!STREAM_BUFFER_FRAMES frames ahead. Without buffer storage each range is
+//!mapped unsynchronized, and the storage is orphaned with glBufferData()
+//!when the ring wraps, instead of fencing.
+struct StreamBuffer {
+
+	GLuint buffer; //!<The identifier for the buffer object
+	GLenum target; //!<The target the buffer is bound to for mapping
+	GLsizeiptr size; //!<The size of the ring in bytes
+	GLboolean persistent; //!<True if the buffer is mapped persistently
+	GLubyte *mapped; //!<The persistent mapping, or the range mapped by
+	                 //!<Map() without buffer storage, or NULL
+	GLintptr head; //!<The offset of the next free byte
+	GLintptr frameStart; //!<The offset of the current frame's first byte
+	std::deque<StreamFence> fences; //!<The frames the GPU may still read,
+	                                //!<oldest first
+	StreamBufferStats stats; //!<The counters of the current frame
+	StreamBufferStats lastFrame; //!<The counters of the last EndFrame()
+
+	//!@brief Constructs an empty ring without a buffer object
+	StreamBuffer();
+
+	//!@brief Creates the buffer object
+	//!@param [in] target - The target to bind the buffer to, like
+	//!GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER
+	//!@param [in] frameSize - The bytes streamed in a frame, the ring holds
+	//!STREAM_BUFFER_FRAMES times as many
+	//!@param [in] allowPersistent - False to use the mapping and orphaning
+	//!path even if buffer storage is supported
+	//!@return True if the buffer could be created and mapped
+	GLboolean Create(GLenum target, GLsizeiptr frameSize,
+			GLboolean allowPersistent);
+
+	//!@brief Returns a range to write the data of this frame to
+	//!
+	//!The range may be written until the next Map() or EndFrame(), and
+	//!then drawn from. Unmap() must be called before drawing.
+	//!@param [in] bytes - The size of the range
+	//!@param [in] alignment - The alignment of the offset, like
+	//!GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform blocks
+	//!@param [out] offset - The offset of the range in the buffer
+	//!@return A pointer to the range, NULL if it is larger than the ring
+	GLvoid *Map(GLsizeiptr bytes, GLsizeiptr alignment, GLintptr &offset);
+
+	//!@brief Ends writing to the range returned by Map()
+	//!
+	//!Does nothing when the buffer is mapped persistently, as the mapping
+	//!is coherent.
+	GLvoid Unmap();
+
+	//!@brief Fences the ranges mapped since the last EndFrame(), after the
+	//!frame's draw calls were made, and starts counting the next frame
+	GLvoid EndFrame();
+
+	//!@brief Deletes the fences, unmaps and deletes the buffer object
+	GLvoid Close();
+
+	//!@brief Calls Close()
+	~StreamBuffer();
+
+	private:
+
+		//!@brief Waits until the GPU is done with every fenced frame that
+		//!overlaps a range
+		//!@param [in] start - The offset of the range
+		//!@param [in] end - The offset after the range
+		GLvoid WaitFor(GLintptr start, GLintptr end);
+};
+
+#endif // __STREAMBUFFER__
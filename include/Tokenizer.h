@@ -0,0 +1,78 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __TOKENIZER__
+#define __TOKENIZER__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+//!@brief A pointer based tokenizer for Wavefront OBJ and MTL text
+//!
+//!Walks over a range of characters, usually a memory mapped file, without
+//!copying lines out of it. Numbers are parsed in place and independently of
+//!the C/C++ locale, so nothing is allocated per line or per token.
+//!Lines are terminated by '\n', a trailing '\r' is treated as whitespace.
+struct Tokenizer {
+
+	const GLchar *pos; //!<The current read position
+	const GLchar *end; //!<One past the last character that may be read
+
+	//!@brief Creates a tokenizer over the specified range of characters
+	//!@param [in] begin - Pointer to the first character
+	//!@param [in] end - Pointer to one past the last character
+	Tokenizer(const GLchar *begin, const GLchar *end);
+
+	//!@brief Checks if all the characters have been consumed
+	//!@return True if there is nothing left to read
+	GLboolean Done() const;
+
+	//!@brief Skips spaces and tabs, but not line breaks
+	GLvoid SkipSpaces();
+
+	//!@brief Skips the current token, i.e. everything up to the next 
+	//!whitespace character
+	GLvoid SkipToken();
+
+	//!@brief Moves the read position to the start of the next line
+	GLvoid NextLine();
+
+	//!@brief Checks if there are any more tokens on the current line
+	//!
+	//!Skips spaces and tabs before checking.
+	//!@return True if the end of the line (or the range) was reached
+	GLboolean EndOfLine();
+
+	//!@brief Consumes the keyword if the read position is at that keyword
+	//!
+	//!The keyword must be followed by whitespace or the end of the line, so
+	//!"v" does not match "vt".
+	//!@param [in] keyword - The null terminated keyword, e.g. "usemtl"
+	//!@return True if the keyword matched and was consumed
+	GLboolean Keyword(const GLchar *keyword);
+
+	//!@brief Parses a floating point number at the read position
+	//!
+	//!Leading spaces are skipped. The result is correctly rounded, i.e. it is
+	//!the same value operator>> on a stream would produce.
+	//!@return The number, or 0 if there is no number at the read position
+	GLfloat ReadFloat();
+
+	//!@brief Parses a signed integer at the read position
+	//!
+	//!Leading spaces are skipped. Parsing stops at the first character that
+	//!is not a digit, such as the '/' in an OBJ face index triple.
+	//!@return The number, or 0 if there is no number at the read position
+	GLint ReadInt();
+
+	//!@brief Copies the rest of the line, without the line break, into a 
+	//!string
+	//!
+	//!Leading spaces are skipped, trailing '\r' characters are dropped.
+	//!@return The rest of the line
+	const std::string ReadLine();
+};
+
+#endif // __TOKENIZER__
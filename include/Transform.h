@@ -0,0 +1,110 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __TRANSFORM__
+#define __TRANSFORM__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+#include <Vector3.h>
+#include <Matrix4.h>
+
+//!@brief A rotation stored as a unit quaternion
+//!
+//!A rotation by an angle around a unit axis is the quaternion
+//!(axis*sin(angle/2), cos(angle/2)). Unlike a rotation matrix it takes four
+//!floats, rotations are combined with 16 multiplications and two rotations
+//!can be interpolated smoothly with Slerp(). Angles are in degrees, like
+//!Matrix4::Perspective() and glRotatef().
+struct Quaternion {
+
+	GLfloat x; //!<The x component of the axis times sin(angle/2)
+	GLfloat y; //!<The y component of the axis times sin(angle/2)
+	GLfloat z; //!<The z component of the axis times sin(angle/2)
+	GLfloat w; //!<cos(angle/2)
+
+	//!@brief Constructs the identity rotation, which rotates by 0 degrees
+	Quaternion();
+
+	//!@brief Constructs a quaternion from its components
+	//!@param [in] x - The x component of the vector part
+	//!@param [in] y - The y component of the vector part
+	//!@param [in] z - The z component of the vector part
+	//!@param [in] w - The scalar part
+	Quaternion(GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+	//!@brief Constructs a rotation around an axis
+	//!
+	//!Rotates counterclockwise when looking down the axis towards the
+	//!origin, the same rotation as glRotatef().
+	//!@param [in] axis - The axis, it doesn't have to be a unit vector
+	//!@param [in] angle - The angle in degrees
+	//!@return The rotation
+	static Quaternion FromAxisAngle(const Vector3 &axis, GLfloat angle);
+
+	//!@brief Scales the quaternion to unit length, which rounding errors
+	//!drift away from after many multiplications
+	//!@return The unit quaternion
+	Quaternion Normalize() const;
+
+	//!@brief Calculates the opposite rotation
+	//!@return The conjugate (-x, -y, -z, w), the inverse of a unit
+	//!quaternion
+	Quaternion Conjugate() const;
+
+	//!@brief Interpolates between this rotation and another one along the
+	//!shortest arc, at a constant angular speed
+	//!@param [in] q - The rotation at t=1
+	//!@param [in] t - The fraction of the way from this rotation to q
+	//!@return The interpolated unit quaternion
+	Quaternion Slerp(const Quaternion &q, GLfloat t) const;
+
+	//!@brief Converts the rotation to a matrix
+	//!@return The rotation matrix, without translation
+	Matrix4 ToMatrix() const;
+
+	//!@brief Combines two rotations
+	//!@param [in] q - The rotation applied first
+	//!@return The rotation by q followed by this rotation
+	Quaternion operator*(const Quaternion &q) const;
+
+	//!@brief Rotates a vector
+	//!@param [in] v - The vector, w is kept as is
+	//!@return The rotated vector
+	Vector3 operator*(const Vector3 &v) const;
+
+	//!@brief Describes the quaternion
+	//!@return A string containing the components
+	const std::string ToString() const;
+};
+
+//!@brief The position, orientation and size of an object
+//!
+//!Builds the matrices of an object directly from its parts, without going
+//!through Matrix4::Translate() and matrix products or the OpenGL matrix
+//!stack.
+struct Transform {
+
+	Vector3 position; //!<The translation
+	Quaternion rotation; //!<The rotation, applied before the translation
+	Vector3 scale; //!<The scale along each axis, applied first
+
+	//!@brief Constructs the identity transform
+	Transform();
+
+	//!@brief Calculates the matrix that moves points from the object's
+	//!space into its parent's space
+	//!@return The matrix, translation*rotation*scale
+	Matrix4 ToMatrix() const;
+
+	//!@brief Calculates the matrix that moves points from the parent's
+	//!space into the object's space
+	//!@return The inverse of ToMatrix(), or the identity matrix if a scale
+	//!is 0
+	Matrix4 InverseMatrix() const;
+};
+
+#endif // __TRANSFORM__
@@ -0,0 +1,118 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __UNIFORMBUFFER__
+#define __UNIFORMBUFFER__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <vector>
+
+//!@brief The binding points of the uniform blocks shared by the shaders
+//!
+//!Every shader declaring one of these blocks binds it to the same point
+//!with Shader::BindUniformBlock(), so one buffer feeds all of them.
+enum UniformBlockBindings {
+	UNIFORM_BLOCK_FRAME = 0, //!<The Frame block: mat4 projection and
+	                         //!<mat4 view, bound once per frame
+	UNIFORM_BLOCK_MATERIAL = 1 //!<The Material block: vec4 ka, kd and ks,
+	                           //!<float ns and d, bound per group
+};
+
+//!@brief Packs values into a buffer following the std140 layout rules
+//!
+//!Scalars are aligned to 4 bytes, and vec3, vec4 and the columns of
+//!matrices to 16 bytes. A vec3 takes 12 bytes, so a scalar may follow it
+//!in the same 16 bytes. Values have to be added in the order the block
+//!declares them.
+struct Std140 {
+
+	std::vector<GLubyte> data; //!<The packed block
+
+	//!@brief Pads the data with zeros up to a multiple of the alignment
+	//!@param [in] alignment - The alignment in bytes, a power of two
+	GLvoid Align(GLuint alignment);
+
+	//!@brief Adds a float
+	//!@param [in] x - The value
+	GLvoid AddFloat(GLfloat x);
+
+	//!@brief Adds an int, or a bool as 0 or 1
+	//!@param [in] x - The value
+	GLvoid AddInt(GLint x);
+
+	//!@brief Adds a vec3
+	//!@param [in] v - The three components
+	GLvoid AddVec3(const GLfloat *v);
+
+	//!@brief Adds a vec4
+	//!@param [in] x - The first component
+	//!@param [in] y - The second component
+	//!@param [in] z - The third component
+	//!@param [in] w - The fourth component
+	GLvoid AddVec4(GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+	//!@brief Adds a mat4
+	//!@param [in] m - The 16 elements, column major like Matrix4::mat
+	GLvoid AddMat4(const GLfloat *m);
+
+	//!@brief Returns the size of the block, which std140 rounds up to a
+	//!multiple of 16 bytes
+	//!@return The size in bytes after padding
+	GLsizeiptr Size();
+
+	//!@brief Discards the packed values, to pack the next block
+	GLvoid Clear();
+};
+
+//!@brief A uniform buffer object holding one or more uniform blocks
+//!
+//!Several blocks, like the blocks of all the materials of a mesh, can share
+//!one buffer. Each block then starts at a multiple of Stride() and is
+//!bound on its own with BindRange().
+struct UniformBuffer {
+
+	GLuint ubo; //!<The identifier for the uniform buffer object
+	GLsizeiptr size; //!<The size of the buffer in bytes
+
+	//!@brief Constructs an empty buffer without a uniform buffer object
+	UniformBuffer();
+
+	//!@brief Creates the uniform buffer object and fills it
+	//!@param [in] size - The size in bytes
+	//!@param [in] data - The contents, or NULL to leave them undefined
+	//!@param [in] usage - GL_STATIC_DRAW for blocks that never change,
+	//!GL_DYNAMIC_DRAW for blocks updated every frame
+	GLvoid Create(GLsizeiptr size, const GLvoid *data, GLenum usage);
+
+	//!@brief Replaces part of the contents
+	//!@param [in] offset - The offset in bytes
+	//!@param [in] size - The number of bytes to replace
+	//!@param [in] data - The new contents
+	GLvoid Update(GLintptr offset, GLsizeiptr size, const GLvoid *data);
+
+	//!@brief Binds the whole buffer to a binding point
+	//!@param [in] binding - The UniformBlockBindings value
+	GLvoid BindBase(GLuint binding) const;
+
+	//!@brief Binds one block of the buffer to a binding point
+	//!@param [in] binding - The UniformBlockBindings value
+	//!@param [in] offset - The offset of the block, a multiple of Stride()
+	//!@param [in] size - The size of the block
+	GLvoid BindRange(GLuint binding, GLintptr offset, GLsizeiptr size) const;
+
+	//!@brief Deletes the uniform buffer object
+	GLvoid Close();
+
+	//!@brief Calls Close()
+	~UniformBuffer();
+
+	//!@brief Returns the distance between blocks sharing a buffer
+	//!@param [in] size - The size of a block
+	//!@return The size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+	//!which is queried the first time
+	static GLsizeiptr Stride(GLsizeiptr size);
+};
+
+#endif // __UNIFORMBUFFER__
@@ -0,0 +1,205 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __VEC__
+#define __VEC__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+
+//The operations can be evaluated at compile time when the compiler supports
+//C++14 constexpr functions, otherwise they are plain inline functions
+#if __cplusplus >= 201402L
+#define VEC_CONSTEXPR constexpr
+#else
+#define VEC_CONSTEXPR inline
+#endif
+
+//!@brief A vector of N components of type T
+//!
+//!Vec has no constructors, virtual functions or padding, so it is an
+//!aggregate that is trivially copyable: it is initialized with braces, as in
+//!Vec2f t = {{0.5f, 1.0f}}, arrays of it can be copied with memcpy, and a
+//!static const Vec initialized with constants is built at compile time.
+//!Unlike Vector3 it only holds the components it needs, a Vec2f takes 8
+//!bytes and a Vec3f 12 bytes.
+template<GLuint N, typename T = GLfloat>
+struct Vec {
+
+	T v[N]; //!<The components, x, y, z and w for N up to 4
+
+	//!@brief Returns a component
+	//!@param [in] i - The component, from 0 to N-1
+	//!@return A reference to the component
+	VEC_CONSTEXPR T& operator[](GLuint i) {return(v[i]);}
+
+	//!@brief Returns a component
+	//!@param [in] i - The component, from 0 to N-1
+	//!@return A reference to the component
+	VEC_CONSTEXPR const T& operator[](GLuint i) const {return(v[i]);}
+
+	//!@brief Adds the two vectors
+	//!@param [in] b - The vector to add
+	//!@return The component wise sum
+	VEC_CONSTEXPR Vec operator+(const Vec &b) const
+	{
+		Vec r = *this;
+		for(GLuint i = 0; i < N; i++) r.v[i] += b.v[i];
+		return(r);
+	}
+
+	//!@brief Subtracts a vector from this vector
+	//!@param [in] b - The vector to subtract
+	//!@return The component wise difference
+	VEC_CONSTEXPR Vec operator-(const Vec &b) const
+	{
+		Vec r = *this;
+		for(GLuint i = 0; i < N; i++) r.v[i] -= b.v[i];
+		return(r);
+	}
+
+	//!@brief Scales the vector
+	//!@param [in] k - The scale factor
+	//!@return The scaled vector
+	VEC_CONSTEXPR Vec operator*(T k) const
+	{
+		Vec r = *this;
+		for(GLuint i = 0; i < N; i++) r.v[i] *= k;
+		return(r);
+	}
+
+	//!@brief Calculates the dot product of the two vectors
+	//!@param [in] b - The other vector
+	//!@return The sum of the products of the components
+	VEC_CONSTEXPR T Dot(const Vec &b) const
+	{
+		T d = v[0]*b.v[0];
+		for(GLuint i = 1; i < N; i++) d += v[i]*b.v[i];
+		return(d);
+	}
+
+	//!@brief Checks if all the components of two vectors are equal
+	//!@param [in] b - The vector to compare with
+	//!@return True if equal or false if not equal
+	VEC_CONSTEXPR GLboolean operator==(const Vec &b) const
+	{
+		for(GLuint i = 0; i < N; i++) if(v[i] != b.v[i]) return(false);
+		return(true);
+	}
+
+	//!@brief Checks if any component of two vectors differs
+	//!@param [in] b - The vector to compare with
+	//!@return True if not equal or false if equal
+	VEC_CONSTEXPR GLboolean operator!=(const Vec &b) const
+	{
+		return(!(*this == b));
+	}
+};
+
+//!@brief A matrix of R rows and C columns of type T
+//!
+//!Like Vec, Mat is a trivially copyable aggregate. The elements are stored
+//!column after column, like Matrix4 and OpenGL, so a Mat<4, 4> has the
+//!same layout as a Matrix4.
+template<GLuint R, GLuint C, typename T = GLfloat>
+struct Mat {
+
+	T m[R*C]; //!<The elements, column major
+
+	//!@brief Returns an identity matrix, ones on the diagonal and zeros
+	//!everywhere else
+	//!@return The identity matrix
+	static VEC_CONSTEXPR Mat Identity()
+	{
+		Mat r = {};
+		for(GLuint i = 0; i < R && i < C; i++) r.m[i*R+i] = 1;
+		return(r);
+	}
+
+	//!@brief Returns an element
+	//!@param [in] row - The row of the element
+	//!@param [in] column - The column of the element
+	//!@return A reference to the element
+	VEC_CONSTEXPR T& operator()(GLuint row, GLuint column)
+	{
+		return(m[column*R+row]);
+	}
+
+	//!@brief Returns an element
+	//!@param [in] row - The row of the element
+	//!@param [in] column - The column of the element
+	//!@return A reference to the element
+	VEC_CONSTEXPR const T& operator()(GLuint row, GLuint column) const
+	{
+		return(m[column*R+row]);
+	}
+
+	//!@brief Returns a column of the matrix
+	//!@param [in] column - The column, from 0 to C-1
+	//!@return The column as a vector
+	VEC_CONSTEXPR Vec<R, T> Column(GLuint column) const
+	{
+		Vec<R, T> r = {};
+		for(GLuint i = 0; i < R; i++) r.v[i] = m[column*R+i];
+		return(r);
+	}
+
+	//!@brief Calculates the transpose of the matrix
+	//!@return The matrix with the rows and columns swapped
+	VEC_CONSTEXPR Mat<C, R, T> Transpose() const
+	{
+		Mat<C, R, T> t = {};
+		for(GLuint c = 0; c < C; c++)
+			for(GLuint r = 0; r < R; r++) t.m[r*C+c] = m[c*R+r];
+		return(t);
+	}
+
+	//!@brief Multiplies the matrix with a vector
+	//!@param [in] b - The vector, with one component per column
+	//!@return The sum of the columns scaled by the components
+	VEC_CONSTEXPR Vec<R, T> operator*(const Vec<C, T> &b) const
+	{
+		Vec<R, T> r = {};
+		for(GLuint c = 0; c < C; c++)
+			for(GLuint i = 0; i < R; i++) r.v[i] += m[c*R+i]*b.v[c];
+		return(r);
+	}
+
+	//!@brief Multiplies the matrix with another matrix
+	//!@param [in] b - The matrix, with one row per column of this matrix
+	//!@return The product
+	template<GLuint K>
+	VEC_CONSTEXPR Mat<R, K, T> operator*(const Mat<C, K, T> &b) const
+	{
+		Mat<R, K, T> p = {};
+		for(GLuint k = 0; k < K; k++)
+			for(GLuint c = 0; c < C; c++)
+				for(GLuint i = 0; i < R; i++)
+					p.m[k*R+i] += m[c*R+i]*b.m[k*C+c];
+		return(p);
+	}
+
+	//!@brief Checks if all the elements of two matrices are equal
+	//!@param [in] b - The matrix to compare with
+	//!@return True if equal or false if not equal
+	VEC_CONSTEXPR GLboolean operator==(const Mat &b) const
+	{
+		for(GLuint i = 0; i < R*C; i++) if(m[i] != b.m[i]) return(false);
+		return(true);
+	}
+};
+
+typedef Vec<2> Vec2f; //!<Texture coordinates
+typedef Vec<3> Vec3f; //!<Packed positions and normals
+typedef Vec<4> Vec4f; //!<Homogeneous coordinates, the layout of Vector3
+typedef Mat<3, 3> Mat3f; //!<Rotations and normal matrices
+typedef Mat<4, 4> Mat4f; //!<Homogeneous transformations, the layout of
+                         //!<Matrix4
+
+//Fails to compile if the compiler pads the types
+typedef char Vec2fIsPacked[(sizeof(Vec2f) == 8) ? 1 : -1];
+typedef char Vec3fIsPacked[(sizeof(Vec3f) == 12) ? 1 : -1];
+typedef char Mat4fIsPacked[(sizeof(Mat4f) == 64) ? 1 : -1];
+
+#endif // __VEC__
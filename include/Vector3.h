@@ -9,6 +9,8 @@
 #include <SFML/Window.hpp>
 #include <string>
 
+#include <Vec.h>
+
 //!@brief Defines a 3D vector.
 //!
 //!Create a 3D vector. Manipulate vectors using vector operations.
@@ -17,6 +19,8 @@
 //!a 3D vector class.
 //!@note All overloaded assignment operators (i.e. =, +=, -=, ...) return
 //!a reference to a vector object so that the operators can be chained
+//!@note The vector is trivially copyable, arrays of it can be copied with
+//!memcpy
 struct Vector3 {
 
 	GLfloat x; //!<Represents the x component of the vector 
@@ -41,9 +45,21 @@ struct Vector3 {
 	//!@param [in] w - The homogenous coordinate.
 	Vector3(GLfloat x, GLfloat y, GLfloat z, GLfloat w);
 
-	//!@brief Create a vector with the same coordinates as the specified vector
-	//!@param [in] v - A reference to another vector
-	Vector3(const Vector3 &v);
+	//!@brief Create a vector from a packed vector, with w=1
+	//!@param [in] v - The x, y and z coordinates
+	Vector3(const Vec3f &v);
+
+	//!@brief Create a vector from a packed homogeneous vector
+	//!@param [in] v - The x, y, z and w coordinates
+	Vector3(const Vec4f &v);
+
+	//!@brief Packs the x, y and z coordinates
+	//!@return The coordinates without w
+	Vec3f ToVec3() const;
+
+	//!@brief Packs the coordinates
+	//!@return The x, y, z and w coordinates
+	Vec4f ToVec4() const;
 
 	//!@brief Calculates the distance between two vectors.
 	//!@param [in] v - A reference to the other vector
@@ -101,12 +117,6 @@ struct Vector3 {
 	//!@return The negated vector
 	Vector3 operator-() const;
 
-	//!@brief Assigns a vector to this vector. The w coordinate
-	//!is copied.
-	//!@param [in] v - A reference to the vector to copy
-	//!@return A reference to the new vector
-	Vector3& operator=(const Vector3 &v);
-
 	//!@brief Checks if two vectors are equal, does not consider the w
 	//!coordinate
 	//!@param [in] v - A reference to the vector to compare with
@@ -0,0 +1,109 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __VERTEXCACHE__
+#define __VERTEXCACHE__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+//!@brief The number of entries of the FIFO post-transform cache simulated by
+//!VertexCache::Measure(), typical of desktop GPUs
+#define VERTEX_CACHE_FIFO_SIZE 16
+
+//!@brief The number of entries of the LRU cache modelled by 
+//!VertexCache::Optimize()
+#define VERTEX_CACHE_LRU_SIZE 32
+
+//!@brief The size of the lines of the cache simulated by 
+//!VertexCache::MeasureFetch(), in bytes
+#define VERTEX_FETCH_LINE_SIZE 64
+
+//!@brief The number of lines of the cache simulated by 
+//!VertexCache::MeasureFetch(), a few kilobytes like a GPU's first level cache
+#define VERTEX_FETCH_LINES 64
+
+//!@brief How well an index buffer uses the post-transform vertex cache
+struct VertexCacheStats {
+
+	size_t triangles; //!<The number of triangles drawn
+	size_t vertices; //!<The number of distinct vertices referenced
+	size_t transforms; //!<The number of vertex shader invocations, i.e.
+	                   //!<cache misses
+
+	//!@brief Constructs zeroed statistics
+	VertexCacheStats();
+
+	//!@brief Adds the statistics of another index buffer
+	//!@param [in] s - The statistics to add
+	GLvoid Add(const VertexCacheStats &s);
+
+	//!@brief Calculates the average cache miss ratio
+	//!@return The vertex transforms per triangle, between 0.5 at best and 3
+	GLfloat ACMR() const;
+
+	//!@brief Calculates the average transform to vertex ratio
+	//!@return The vertex transforms per distinct vertex, 1 at best
+	GLfloat ATVR() const;
+
+	//!@brief Describes the statistics
+	//!@return A string containing the ACMR and ATVR
+	const std::string ToString() const;
+};
+
+//!@brief How well the vertices fetched by an index buffer use the memory
+//!cache
+struct VertexFetchStats {
+
+	size_t fetches; //!<The number of vertices read, one per transform
+	size_t misses; //!<The number of cache lines read from memory
+
+	//!@brief Constructs zeroed statistics
+	VertexFetchStats();
+
+	//!@brief Calculates the estimated cache miss ratio
+	//!@return The cache lines read from memory per vertex fetched
+	GLfloat MissRatio() const;
+};
+
+//!@brief Reorders triangles for the post-transform vertex cache
+struct VertexCache {
+
+	//!@brief Simulates drawing the triangles through a FIFO vertex cache
+	//!@param [in] indices - The triangle list
+	//!@param [in] count - The number of indices, a multiple of three
+	//!@param [in] cacheSize - The number of entries of the cache
+	//!@return The number of triangles, vertices and transforms
+	static VertexCacheStats Measure(const GLuint *indices, size_t count,
+			GLuint cacheSize=VERTEX_CACHE_FIFO_SIZE);
+
+	//!@brief Simulates fetching the vertices drawn by the triangles 
+	//!through a memory cache
+	//!
+	//!Only vertices missing the FIFO post-transform cache are fetched. The
+	//!memory cache is an LRU cache of VERTEX_FETCH_LINES lines of
+	//!VERTEX_FETCH_LINE_SIZE bytes.
+	//!@param [in] indices - The triangle list
+	//!@param [in] count - The number of indices, a multiple of three
+	//!@param [in] vertexSize - The size of a vertex in bytes
+	//!@return The number of vertices fetched and lines read
+	static VertexFetchStats MeasureFetch(const GLuint *indices, size_t count,
+			GLuint vertexSize);
+
+	//!@brief Reorders the triangles so that consecutive triangles share 
+	//!vertices
+	//!
+	//!Uses Tom Forsyth's linear-speed vertex cache optimisation: each 
+	//!vertex is scored by its position in a modelled LRU cache and by how 
+	//!many of its triangles are left, and the triangle with the highest
+	//!score is drawn next. The triangles themselves, including their 
+	//!winding, are unchanged. If the original order already makes fewer 
+	//!transforms with the simulated FIFO cache it is kept.
+	//!@param [in,out] indices - The triangle list
+	//!@param [in] count - The number of indices, a multiple of three
+	static GLvoid Optimize(GLuint *indices, size_t count);
+};
+
+#endif // __VERTEXCACHE__
@@ -0,0 +1,91 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifndef __VERTEXFORMAT__
+#define __VERTEXFORMAT__
+
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <string>
+
+#include <Vector3.h>
+#include <Bounds.h>
+
+//!@brief The layouts a mesh's vertex buffer object can use
+enum VertexFormats {
+	VERTEX_FORMAT_FLOAT = 0, //!<All the positions followed by all the 
+	                         //!<normals, four floats each (32 bytes/vertex)
+	VERTEX_FORMAT_QUANTIZED = 1 //!<Interleaved QuantizedVertex structs
+	                            //!<(16 bytes/vertex)
+};
+
+//!@brief A vertex of the VERTEX_FORMAT_QUANTIZED layout
+//!
+//!Positions are stored as 16 bit fractions of the mesh's bounding box, 
+//!normals are octahedral encoded into two 16 bit values and texture 
+//!coordinates are half floats. The vertex shader decodes all of them.
+struct QuantizedVertex {
+
+	GLushort position[4]; //!<x, y, z within the bounds, w is always 65535
+	GLshort normal[2]; //!<The octahedral encoded normal
+	GLushort texcoord[2]; //!<The s and t texture coordinates as half floats
+};
+
+//!@brief Converts vertices between the supported vertex formats
+struct VertexFormat {
+
+	//!@brief Returns the number of bytes each vertex takes up in the VBO
+	//!@param [in] format - The VertexFormats value
+	//!@return The size of a vertex in bytes
+	static GLsizei Size(GLuint format);
+
+	//!@brief Returns the name of a format
+	//!@param [in] format - The VertexFormats value
+	//!@return "float" or "quantized"
+	static const std::string Name(GLuint format);
+
+	//!@brief Describes the vertex memory used by the format compared to
+	//!VERTEX_FORMAT_FLOAT
+	//!@param [in] format - The VertexFormats value
+	//!@param [in] count - The number of vertices
+	//!@return A string with the bytes per vertex and the memory saved
+	static const std::string Report(GLuint format, size_t count);
+
+	//!@brief Converts a float to a half float, rounding to nearest even
+	//!@param [in] f - The float
+	//!@return The 16 bits of the half float
+	static GLushort FloatToHalf(GLfloat f);
+
+	//!@brief Converts a half float to a float
+	//!@param [in] h - The 16 bits of the half float
+	//!@return The float
+	static GLfloat HalfToFloat(GLushort h);
+
+	//!@brief Encodes a unit vector by projecting it onto an octahedron and
+	//!unfolding the octahedron into a square
+	//!@param [in] n - The unit vector
+	//!@param [out] e - The two signed normalized components
+	static GLvoid OctEncode(const Vector3 &n, GLshort e[2]);
+
+	//!@brief Decodes an octahedral encoded unit vector
+	//!@param [in] e - The two signed normalized components
+	//!@return The unit vector
+	static Vector3 OctDecode(const GLshort e[2]);
+
+	//!@brief Converts vertices into the VERTEX_FORMAT_QUANTIZED layout
+	//!
+	//!Runs on multiple threads for large arrays.
+	//!@param [in] positions - The vertex positions
+	//!@param [in] normals - The normals, NULL if there are none
+	//!@param [in] texcoords - The texture coordinates, NULL if there are
+	//!none
+	//!@param [in] count - The number of vertices
+	//!@param [in] bounds - The bounding box of the positions
+	//!@param [out] out - Array receiving count vertices
+	static GLvoid Quantize(const Vector3 *positions, const Vector3 *normals,
+			const Vec2f *texcoords, size_t count, 
+			const BoundingBox &bounds, QuantizedVertex *out);
+};
+
+#endif // __VERTEXFORMAT__
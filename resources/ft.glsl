@@ -4,16 +4,81 @@
 #version 330
 
 layout(location=0) in vec4 inPosition;
+layout(location=1) in vec4 inNormal;
+layout(location=2) in vec2 inTexcoord;
 
-uniform mat4 modelviewprojection;
-uniform vec4 fColor;
+//Per instance attributes of Mesh::DrawInstanced(), read when instanced is
+//set instead of model and normalmatrix
+layout(location=3) in mat4 inModel;
+layout(location=7) in vec4 inColor;
+
+//Shared by all the shaders, bound once per frame
+layout(std140) uniform Frame
+{
+	mat4 projection;
+	mat4 view;
+};
+
+//The material of the group being drawn
+layout(std140) uniform Material
+{
+	vec4 ka;
+	vec4 kd;
+	vec4 ks;
+	float ns;
+	float d;
+} material;
+
+uniform mat4 model;
+uniform mat4 normalmatrix;
+uniform bool instanced;
+
+//Set for VERTEX_FORMAT_QUANTIZED vertices, positions are fractions of the
+//bounding box and normals are octahedral encoded
+uniform bool quantized;
+uniform vec3 positionScale;
+uniform vec3 positionBias;
 
 flat out vec4 oColor;
+smooth out vec3 oNormal;
+smooth out vec2 oTexcoord;
+
+//Unfolds an octahedral encoded unit vector
+vec3 OctDecode(vec2 e)
+{
+	vec3 n=vec3(e, 1.0-abs(e.x)-abs(e.y));
+	float t=max(-n.z, 0.0);
+	n.x+=(n.x>=0.0)?-t:t;
+	n.y+=(n.y>=0.0)?-t:t;
+	return(normalize(n));
+}
 
 void main()
 {
-	gl_Position=modelviewprojection*inPosition;
-	oColor=fColor;
+	vec4 position=inPosition;
+	vec3 normal=inNormal.xyz;
+	if(quantized)
+	{
+		position=vec4(inPosition.xyz*positionScale+positionBias, 1.0);
+		normal=OctDecode(inNormal.xy/32767.0);
+	}
+
+	//Instances are only scaled uniformly, so the normal matrix is the 
+	//modelview without translation
+	mat4 m=model;
+	mat3 nm=mat3(normalmatrix);
+	vec4 color=vec4(1.0);
+	if(instanced)
+	{
+		m=inModel;
+		nm=mat3(view*inModel);
+		color=inColor;
+	}
+
+	gl_Position=projection*(view*(m*position));
+	oNormal=normalize(nm*normal);
+	oTexcoord=inTexcoord;
+	oColor=vec4(material.kd.rgb, material.d)*color;
 }
 
 #endif //__VERTEX
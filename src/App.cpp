@@ -4,30 +4,71 @@
 
 #include <SFML/System/Clock.hpp>
 #include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
 
 #include <App.h>
 #include <Matrix4.h>
+#include <Transform.h>
+#include <Camera.h>
 #include <Shader.h>
 #include <Mesh.h>
+#include <UniformBuffer.h>
+#include <InstanceBuffer.h>
+#include <RenderQueue.h>
+#include <GLState.h>
+#include <StreamBuffer.h>
+#include <OcclusionCuller.h>
 
 using namespace std;
 
-typedef struct {
-	GLfloat hstep;
-	GLfloat vstep;
-	GLfloat dstep;
-} camera_t;
-
-camera_t camera = {0, 0, 0};
-
 GLboolean App::keys[sf::Keyboard::KeyCount];
 string App::objectFilename;
+GLuint App::loadFlags = MESH_LOAD_STREAM;
+GLuint App::vertexFormat = VERTEX_FORMAT_FLOAT;
+GLboolean App::cullMeshlets = false;
+GLboolean App::selectLods = false;
+GLboolean App::cullOccluded = false;
+GLboolean App::printStats = false;
+GLuint App::instanceCount = 0;
 sf::Window App::window;
 
 GLuint vbo[2];
 Shader meshshader;
 Mesh mesh;
 Matrix4 projection, model, view;
+Camera camera;
+GLfloat pixelsPerUnit = 1.0f;
+GLfloat farPlane = 10000.0f;
+OcclusionCuller occlusion;
+
+//Blender exports vertices clockwise, the CPU culling follows the winding
+//GL culls with. The model is drawn as a wireframe.
+const GLenum frontFace = GL_CW;
+const GLenum polygonMode = GL_LINE;
+
+//Culling counters summed over the frames, printed with -stats
+GLuint cullFrames = 0;
+MeshletCullStats cullStats;
+GroupCullStats groupStats;
+OcclusionStats occlusionStats;
+
+//Handles of the mesh shader's uniforms, looked up once after linking. The
+//render queue sets the model and normal matrices.
+GLint quantizedUniform = -1, scaleUniform = -1, biasUniform = -1;
+GLint instancedUniform = -1;
+
+//The Frame block shared by the shaders, streamed through a ring so a new
+//block never waits for the GPU to finish with the last one
+StreamBuffer frameStream;
+Std140 frameBlock;
+
+//The copies of the mesh drawn with -instances
+InstanceBuffer instances;
+
+//The draws of a frame, sorted to share state
+RenderQueue queue;
 
 GLvoid App::Run()
 {
@@ -92,45 +133,46 @@ GLboolean App::Init()
     //Resize the viewport and set up the proper projection matrix
 	App::Resize(window.getSize().x, window.getSize().y);
 
-	//Set the clear values for each buffer
-    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-    glClearDepth(1.0f);
-	glClearStencil(0.0f);
+	App::SetState();
 
-	//Set the orientation of the polygons. We want the polygons to be
-	//front-facing when the vertices are wound clockwise.
-	//Blender exports vertices clockwise!
-    //glCullFace enables culling of back faces
-	glFrontFace(GL_CW);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-
-	//Enable pixel blending. This will enable blending of colours to be drawn
-	//with the colors already in the framebuffer. If it's disabled then the 
-	//new color simply replaces the color in the framebuffer.
-	//We have selected a blend function that just replaces all colors but
-	//allows for transparency.
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	//Enable depth testing; GL_LEQUAL means the depth test passes if the
-	//incoming depth value is less than or equal to the stored depth value. 
-	//GL_DEPTH_CLAMP Enables depth clamping, i.e. no near or far clip planes, 
-	//z values are clamped; Basically if z>-znear, then z=-znear; if z<-zfar,
-	//then z=-zfar. glDepthMask enables writing the new depth value to the
-	//depth buffer if the depth test passes. glDepthRange specifies the range
-	//that depth values can have, the full range is between 0 and 1.
-	glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-	glEnable(GL_DEPTH_CLAMP);
-	glDepthMask(GL_TRUE);
-	glDepthRange(0.0f, 1.0f);
+	//Lines hide nothing, the groups behind the occluders can be seen 
+	//between them
+	if(cullOccluded && polygonMode != GL_FILL)
+	{
+		cerr << "-occlusion needs filled polygons, ignored" << endl;
+		cullOccluded = false;
+	}
 
 	//////////////////////////////////////////////////
 	meshshader.Open("ft.glsl");
-	mesh.Open(objectFilename);
+	quantizedUniform = meshshader.Uniform("quantized");
+	scaleUniform = meshshader.Uniform("positionScale");
+	biasUniform = meshshader.Uniform("positionBias");
+	instancedUniform = meshshader.Uniform("instanced");
+	meshshader.BindUniformBlock("Frame", UNIFORM_BLOCK_FRAME);
+	meshshader.BindUniformBlock("Material", UNIFORM_BLOCK_MATERIAL);
+	frameStream.Create(GL_UNIFORM_BUFFER, 
+		UniformBuffer::Stride(32*sizeof(GLfloat)), true);
+	mesh.Open(objectFilename, loadFlags);
+	if(printStats) cout << mesh.stats.ToString() << endl;
 	mesh.CalculateNormals();
-	mesh.CreateBufferObjects();
+	if(selectLods) mesh.BuildLods();
+	mesh.CreateBufferObjects(vertexFormat);
+	if(printStats) 
+		cout << VertexFormat::Report(vertexFormat, mesh.numVerts) << endl;
+	if(cullMeshlets) mesh.BuildMeshlets();
+
+	//The copies stand on a square grid far enough away to see all of them
+	if(instanceCount > 0)
+	{
+		Vector3 size = mesh.bounds.Size();
+		GLfloat spacing = 1.5f*max(size.x, max(size.y, size.z));
+		GLfloat side = ceilf(sqrtf((GLfloat)instanceCount))*spacing;
+		instances.Resize(instanceCount);
+		instances.FillGrid(Vector3(0.0f, 0.0f, -10.0f-side), spacing);
+		instances.Upload();
+		mesh.AttachInstances(instances);
+	}
 	//cout << mesh.ToString() << endl;
     
 	return(true);
@@ -161,6 +203,17 @@ GLvoid App::Events(sf::Event &event)
 				window.create(sf::VideoMode::getDesktopMode(),"Test",
 						style,
 						sf::ContextSettings(24, 8, 2, 3, 3));
+
+				//The new context starts out with the default state, so
+				//nothing GLState remembers is set anymore
+				GLState::Invalidate();
+				App::Resize(window.getSize().x, window.getSize().y);
+				App::SetState();
+
+				//Buffers and programs are shared with the new context,
+				//vertex array objects aren't
+				mesh.CreateVertexArrays();
+				if(instanceCount > 0) mesh.AttachInstances(instances);
 				keys[sf::Keyboard::F11] = false;
 			}
             break;
@@ -187,12 +240,12 @@ GLvoid App::Events(sf::Event &event)
 
 GLvoid App::Update()
 {
-	if(keys[sf::Keyboard::Right]) camera.hstep+=0.0005;
-	if(keys[sf::Keyboard::Left]) camera.hstep-=0.0005;
-	if(keys[sf::Keyboard::Up]) camera.vstep+=0.0005;
-	if(keys[sf::Keyboard::Down]) camera.vstep-=0.0005;
-	if(keys[sf::Keyboard::Q]) camera.dstep-=0.0005;
-	if(keys[sf::Keyboard::A]) camera.dstep+=0.0005;
+	if(keys[sf::Keyboard::Right]) camera.Yaw(-0.005f);
+	if(keys[sf::Keyboard::Left]) camera.Yaw(0.005f);
+	if(keys[sf::Keyboard::Up]) camera.Pitch(0.005f);
+	if(keys[sf::Keyboard::Down]) camera.Pitch(-0.005f);
+	if(keys[sf::Keyboard::Q]) camera.Dolly(0.0005f);
+	if(keys[sf::Keyboard::A]) camera.Dolly(-0.0005f);
 }
 
 GLvoid App::Render()
@@ -202,33 +255,92 @@ GLvoid App::Render()
 
 	static GLfloat rot = 0.2f;
 
-	glUseProgram(meshshader.program);
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-	view.LoadIdentity();
-	view.Translate(camera.hstep, camera.vstep, camera.dstep);
-	model.LoadIdentity();
-	model.Translate(0.0f, 0.0f, -10.0f);
-	
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	glRotatef(rot, 0.0f, 1.0f, 0.0f);
+	//The state calls of a frame are counted from here. The program and the
+	//polygon mode are left set at the end of the frame, so after the first
+	//frame these calls are dropped.
+	GLState::ResetStats();
+	GLState::UseProgram(meshshader.program);
+	GLState::PolygonMode(polygonMode);
+
+	//The model spins around its y axis in front of the camera. All the 
+	//matrices are built here, nothing is read back from OpenGL.
+	Transform object;
+	object.position = Vector3(0.0f, 0.0f, -10.0f);
+	object.rotation = Quaternion::FromAxisAngle(Vector3(0.0f, 1.0f, 0.0f),
+		rot);
 	rot+=0.2f;
 	if(rot > 360.0f) rot = 0.2f;
-	Matrix4 rotate;
-	glGetFloatv(GL_MODELVIEW_MATRIX, rotate.mat);
-	model*=rotate;
-	Matrix4 modelview = view.Inverse()*model;
+	model = object.ToMatrix();
+	view = camera.ViewMatrix();
+	Matrix4 modelview = view*model;
+
+	//The camera sits at the origin of eye space, the modelview only
+	//rotates and translates
+	Vector3 eye = modelview.RigidInverse()*Vector3(0.0f, 0.0f, 0.0f);
+	//Groups outside the view, or hidden behind the mesh itself, are left
+	//out of the queue
+	Matrix4 modelviewprojection = projection*modelview;
+	groupStats.Add(mesh.CullGroups(modelviewprojection));
+	if(cullOccluded)
+	{
+		occlusion.Clear();
+		mesh.AddOccluders(occlusion, modelviewprojection, 
+			MESH_OCCLUDER_MIN_SIZE, MESH_OCCLUDER_TRIANGLES, frontFace);
+		occlusion.Rasterize();
+		mesh.CullOccluded(occlusion, modelviewprojection);
+		occlusionStats.Add(occlusion.stats);
+	}
+	if(cullMeshlets) 
+		cullStats.Add(mesh.CullMeshlets(modelviewprojection, eye, 
+			frontFace));
+	cullFrames++;
+	if(selectLods) mesh.SelectLod(eye, pixelsPerUnit);
+
+	//The camera goes into the Frame block, one upload for every shader
+	frameBlock.Clear();
+	frameBlock.AddMat4(projection.mat);
+	frameBlock.AddMat4(view.mat);
+	GLintptr frameOffset = 0;
+	GLvoid *frameData = frameStream.Map(frameBlock.Size(), 
+		UniformBuffer::Stride(1), frameOffset);
+	if(frameData != NULL)
+	{
+		memcpy(frameData, &frameBlock.data.front(), frameBlock.Size());
+		frameStream.Unmap();
+		GLState::BindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_FRAME, 
+			frameStream.buffer, frameOffset, frameBlock.Size());
+	}
 
-	GLint mvpl=glGetUniformLocation(meshshader.program,"modelviewprojection");
-	glUniformMatrix4fv(mvpl,1,GL_FALSE,(projection*modelview).mat);
-	
-	GLint color=glGetUniformLocation(meshshader.program, "fColor");
-	glUniform4f(color, 1.0f, 0.0f, 0.0f, 1.0f);
+	//Quantized positions are decoded relative to the bounding box
+	meshshader.SetUniform(quantizedUniform, 
+		(GLint)(mesh.format == VERTEX_FORMAT_QUANTIZED));
+	Vector3 scale = mesh.bounds.Size();
+	meshshader.SetUniform(scaleUniform, scale.x, scale.y, scale.z);
+	meshshader.SetUniform(biasUniform, mesh.bounds.min.x, mesh.bounds.min.y, 
+		mesh.bounds.min.z);
+
+	meshshader.SetUniform(instancedUniform, (GLint)(instanceCount > 0));
+	if(instanceCount > 0) mesh.DrawInstanced(instanceCount);
+	else
+	{
+		//The groups are drawn through the queue, grouped by material. 
+		//Meshes sharing a material would be drawn front to back.
+		queue.Clear();
+		GLuint transform = queue.AddTransform(model, 
+			modelview.NormalMatrix());
+		GLfloat depth = -(modelview*mesh.bounds.Center()).z/farPlane;
+		for(GLuint i = 0; i < mesh.g.size(); i++)
+		{
+			if(!mesh.g[i].visible) continue;
+			uint64_t key = RenderQueue::Key(0, 0, 
+				mesh.MaterialBlock(mesh.g[i]), 0, depth);
+			queue.Submit(key, &meshshader, &mesh, i, transform);
+		}
+		queue.Execute();
+	}
 
-	mesh.Draw();
-	
-	glUseProgram(0);
+	//The frame's draw calls are made, the ring can fence them
+	frameStream.EndFrame();
 	
     window.display();
 }
@@ -247,18 +359,59 @@ GLvoid App::Resize(GLsizei w, GLsizei h)
 	glViewport(0, 0, w, h);
 
 	//Enable scissor test and set scissor box to the size of the window.
-	glEnable(GL_SCISSOR_TEST);
+	GLState::Enable(GL_SCISSOR_TEST);
 	glScissor(0, 0, w, h);
 
 	//Setup a projection matrix, load identities into the other matrices
 	projection.LoadIdentity();
-	projection.Perspective(60.0f, ((GLfloat)w)/((GLfloat)h), 1.0f, 10000.0f);
+	//The levels of detail are selected by their size in pixels, which 
+	//depends on the field of view
+	const GLfloat fovy = 60.0f;
+	projection.Perspective(fovy, ((GLfloat)w)/((GLfloat)h), 1.0f, farPlane);
+	pixelsPerUnit = h/(2.0f*tan((fovy*(3.14159265f/180.0f))/2.0f));
 	//projection.Orthographic(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
 	//projection.Frustum(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 100.0f);
 	model.LoadIdentity();
 	view.LoadIdentity();
 }
 
+GLvoid App::SetState()
+{
+	//Set the clear values for each buffer
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClearDepth(1.0f);
+	glClearStencil(0.0f);
+
+	//Set the orientation of the polygons. We want the polygons to be
+	//front-facing when the vertices are wound clockwise.
+	//Blender exports vertices clockwise!
+    //glCullFace enables culling of back faces
+	GLState::FrontFace(frontFace);
+	GLState::Enable(GL_CULL_FACE);
+	GLState::CullFace(GL_BACK);
+
+	//Enable pixel blending. This will enable blending of colours to be drawn
+	//with the colors already in the framebuffer. If it's disabled then the 
+	//new color simply replaces the color in the framebuffer.
+	//We have selected a blend function that just replaces all colors but
+	//allows for transparency.
+    GLState::Enable(GL_BLEND);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	//Enable depth testing; GL_LEQUAL means the depth test passes if the
+	//incoming depth value is less than or equal to the stored depth value. 
+	//GL_DEPTH_CLAMP Enables depth clamping, i.e. no near or far clip planes, 
+	//z values are clamped; Basically if z>-znear, then z=-znear; if z<-zfar,
+	//then z=-zfar. glDepthMask enables writing the new depth value to the
+	//depth buffer if the depth test passes. glDepthRange specifies the range
+	//that depth values can have, the full range is between 0 and 1.
+	GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LEQUAL);
+	GLState::Enable(GL_DEPTH_CLAMP);
+	GLState::DepthMask(GL_TRUE);
+	glDepthRange(0.0f, 1.0f);
+}
+
 GLvoid App::CheckErrors()
 {
 	//Check for opengl errors every loop until there are no more errors
@@ -299,6 +452,21 @@ GLvoid App::CheckErrors()
 
 GLvoid App::Cleanup()
 {
+	//Culling results summed over all of the frames
+	if(printStats && window.isOpen()) 
+		cout << "CULLED FRAMES  : " << cullFrames << endl;
+	if(printStats && cullMeshlets && window.isOpen()) 
+		cout << cullStats.ToString() << endl;
+	if(printStats && window.isOpen()) 
+	{
+		cout << groupStats.ToString() << endl;
+		if(cullOccluded) cout << occlusionStats.ToString() << endl;
+		cout << meshshader.uniformStats.ToString() << endl;
+		cout << queue.stats.ToString() << endl;
+		cout << GLState::stats.ToString() << endl;
+		cout << frameStream.lastFrame.ToString() << endl;
+	}
+
 	//Just close the window
     window.close();
 }
@@ -0,0 +1,220 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <algorithm>
+
+#include <BatchTransform.h>
+#include <Parallel.h>
+#include <Simd.h>
+
+using namespace std;
+
+//Sums the columns of m scaled by the components of each vector, the same
+//sum Matrix4::operator*() calculates
+static GLvoid TransformVectors(const Matrix4 &m, const Vector3 *in,
+		Vector3 *out, size_t count)
+{
+	Simd4 c0 = Simd::Load(m.mat), c1 = Simd::Load(m.mat+4);
+	Simd4 c2 = Simd::Load(m.mat+8), c3 = Simd::Load(m.mat+12);
+	for(size_t i = 0; i < count; i++)
+	{
+		const Vector3 &v = in[i];
+		Simd4 r = Simd::Mul(c0, Simd::Splat(v.x));
+		r = Simd::Add(r, Simd::Mul(c1, Simd::Splat(v.y)));
+		r = Simd::Add(r, Simd::Mul(c2, Simd::Splat(v.z)));
+		r = Simd::Add(r, Simd::Mul(c3, Simd::Splat(v.w)));
+		Simd::Store(&out[i].x, r);
+	}
+}
+
+//Like TransformVectors(), but n is already the normal matrix and the
+//results are normalized
+static GLvoid TransformNormals(const Matrix4 &n, const Vector3 *in,
+		Vector3 *out, size_t count)
+{
+	Simd4 c0 = Simd::Load(n.mat), c1 = Simd::Load(n.mat+4);
+	Simd4 c2 = Simd::Load(n.mat+8);
+	for(size_t i = 0; i < count; i++)
+	{
+		const Vector3 &v = in[i];
+		Simd4 r = Simd::Mul(c0, Simd::Splat(v.x));
+		r = Simd::Add(r, Simd::Mul(c1, Simd::Splat(v.y)));
+		r = Simd::Add(r, Simd::Mul(c2, Simd::Splat(v.z)));
+		Simd::Store(&out[i].x, Simd::Normalize3(r));
+		out[i].w = 1.0f;
+	}
+}
+
+//Transforms four points of the streams at a time, every component of the
+//registers belongs to a different point
+static GLvoid TransformPointStreams(const Matrix4 &m, const GLfloat *x,
+		const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+		GLfloat *oz, size_t count)
+{
+	const GLfloat *a = m.mat;
+	Simd4 s[12];
+	for(GLuint k = 0; k < 12; k++) s[k] = Simd::Splat(a[k+k/3]);
+	size_t i = 0;
+	for(; i+4 <= count; i += 4)
+	{
+		Simd4 px = Simd::Load(x+i), py = Simd::Load(y+i);
+		Simd4 pz = Simd::Load(z+i);
+		Simd4 r[3];
+		for(GLuint k = 0; k < 3; k++)
+		{
+			r[k] = Simd::Add(Simd::Mul(s[k], px), Simd::Mul(s[3+k], py));
+			r[k] = Simd::Add(r[k], Simd::Mul(s[6+k], pz));
+			r[k] = Simd::Add(r[k], s[9+k]);
+		}
+		Simd::Store(ox+i, r[0]), Simd::Store(oy+i, r[1]);
+		Simd::Store(oz+i, r[2]);
+	}
+	for(; i < count; i++)
+	{
+		GLfloat px = x[i], py = y[i], pz = z[i];
+		ox[i] = a[0]*px+a[4]*py+a[8]*pz+a[12];
+		oy[i] = a[1]*px+a[5]*py+a[9]*pz+a[13];
+		oz[i] = a[2]*px+a[6]*py+a[10]*pz+a[14];
+	}
+}
+
+//Like TransformPointStreams(), but n is already the normal matrix and the
+//results are normalized
+static GLvoid TransformNormalStreams(const Matrix4 &n, const GLfloat *x,
+		const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+		GLfloat *oz, size_t count)
+{
+	const GLfloat *a = n.mat;
+	Simd4 s[9];
+	for(GLuint k = 0; k < 9; k++) s[k] = Simd::Splat(a[k+k/3]);
+	size_t i = 0;
+	for(; i+4 <= count; i += 4)
+	{
+		Simd4 px = Simd::Load(x+i), py = Simd::Load(y+i);
+		Simd4 pz = Simd::Load(z+i);
+		Simd4 r[3];
+		for(GLuint k = 0; k < 3; k++)
+		{
+			r[k] = Simd::Add(Simd::Mul(s[k], px), Simd::Mul(s[3+k], py));
+			r[k] = Simd::Add(r[k], Simd::Mul(s[6+k], pz));
+		}
+		Simd4 l = Simd::Add(Simd::Mul(r[0], r[0]), Simd::Mul(r[1], r[1]));
+		l = Simd::Sqrt(Simd::Add(l, Simd::Mul(r[2], r[2])));
+		Simd::Store(ox+i, Simd::Div(r[0], l));
+		Simd::Store(oy+i, Simd::Div(r[1], l));
+		Simd::Store(oz+i, Simd::Div(r[2], l));
+	}
+	for(; i < count; i++)
+	{
+		GLfloat px = x[i], py = y[i], pz = z[i];
+		GLfloat nx = a[0]*px+a[4]*py+a[8]*pz;
+		GLfloat ny = a[1]*px+a[5]*py+a[9]*pz;
+		GLfloat nz = a[2]*px+a[6]*py+a[10]*pz;
+		GLfloat l = sqrtf(nx*nx+ny*ny+nz*nz);
+		ox[i] = nx/l, oy[i] = ny/l, oz[i] = nz/l;
+	}
+}
+
+//One call to a Parallel function, either in and out or the streams are
+//used
+struct TransformJob {
+	Matrix4 m; //The matrix, already the normal matrix for normals
+	GLboolean normals;
+	const Vector3 *in;
+	Vector3 *out;
+	const GLfloat *x, *y, *z;
+	GLfloat *ox, *oy, *oz;
+	size_t count;
+};
+
+//Transforms one block of TRANSFORM_BLOCK_SIZE vectors
+static GLvoid TransformBlock(GLuint index, GLvoid *data)
+{
+	TransformJob *job = (TransformJob*)data;
+	size_t first = (size_t)index*TRANSFORM_BLOCK_SIZE;
+	size_t count = min((size_t)TRANSFORM_BLOCK_SIZE, job->count-first);
+	if(job->in != NULL && job->normals)
+		TransformNormals(job->m, job->in+first, job->out+first, count);
+	else if(job->in != NULL)
+		TransformVectors(job->m, job->in+first, job->out+first, count);
+	else if(job->normals)
+	{
+		TransformNormalStreams(job->m, job->x+first, job->y+first,
+			job->z+first, job->ox+first, job->oy+first, job->oz+first,
+			count);
+	}
+	else
+	{
+		TransformPointStreams(job->m, job->x+first, job->y+first,
+			job->z+first, job->ox+first, job->oy+first, job->oz+first,
+			count);
+	}
+}
+
+//Runs the blocks of a job on all threads
+static GLvoid RunJob(TransformJob &job)
+{
+	GLuint blocks = (job.count+TRANSFORM_BLOCK_SIZE-1)/TRANSFORM_BLOCK_SIZE;
+	Parallel::For(blocks, &TransformBlock, &job);
+}
+
+GLvoid BatchTransform::Points(const Matrix4 &m, const Vector3 *in,
+		Vector3 *out, size_t count)
+{
+	TransformVectors(m, in, out, count);
+}
+
+GLvoid BatchTransform::Points(const Matrix4 &m, const GLfloat *x,
+		const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+		GLfloat *oz, size_t count)
+{
+	TransformPointStreams(m, x, y, z, ox, oy, oz, count);
+}
+
+GLvoid BatchTransform::Normals(const Matrix4 &m, const Vector3 *in,
+		Vector3 *out, size_t count)
+{
+	TransformNormals(m.NormalMatrix(), in, out, count);
+}
+
+GLvoid BatchTransform::Normals(const Matrix4 &m, const GLfloat *x,
+		const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+		GLfloat *oz, size_t count)
+{
+	TransformNormalStreams(m.NormalMatrix(), x, y, z, ox, oy, oz, count);
+}
+
+GLvoid BatchTransform::ParallelPoints(const Matrix4 &m, const Vector3 *in,
+		Vector3 *out, size_t count)
+{
+	TransformJob job = {m, false, in, out, NULL, NULL, NULL, NULL, NULL,
+		NULL, count};
+	RunJob(job);
+}
+
+GLvoid BatchTransform::ParallelPoints(const Matrix4 &m, const GLfloat *x,
+		const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+		GLfloat *oz, size_t count)
+{
+	TransformJob job = {m, false, NULL, NULL, x, y, z, ox, oy, oz, count};
+	RunJob(job);
+}
+
+GLvoid BatchTransform::ParallelNormals(const Matrix4 &m, const Vector3 *in,
+		Vector3 *out, size_t count)
+{
+	TransformJob job = {m.NormalMatrix(), true, in, out, NULL, NULL, NULL,
+		NULL, NULL, NULL, count};
+	RunJob(job);
+}
+
+GLvoid BatchTransform::ParallelNormals(const Matrix4 &m, const GLfloat *x,
+		const GLfloat *y, const GLfloat *z, GLfloat *ox, GLfloat *oy,
+		GLfloat *oz, size_t count)
+{
+	TransformJob job = {m.NormalMatrix(), true, NULL, NULL, x, y, z, ox,
+		oy, oz, count};
+	RunJob(job);
+}
@@ -0,0 +1,2407 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include <SFML/System/Clock.hpp>
+
+#include <Benchmark.h>
+#include <Mesh.h>
+#include <Parallel.h>
+#include <Matrix4.h>
+#include <Simd.h>
+#include <BatchTransform.h>
+#include <Transform.h>
+#include <Camera.h>
+#include <Shader.h>
+#include <UniformBuffer.h>
+#include <InstanceBuffer.h>
+#include <RenderQueue.h>
+#include <GLState.h>
+#include <StreamBuffer.h>
+
+using namespace std;
+
+//Number of times each timed operation is repeated, the best run is reported
+#define RUNS 5
+
+//Builds an n by n grid of quads, two triangles each. The triangles of a
+//shuffled grid are in random order, like the faces of a scanned mesh.
+static GLvoid Grid(GLuint n, GLboolean shuffle, vector<GLuint> &indices)
+{
+	indices.clear();
+	for(GLuint y = 0; y < n; y++)
+	{
+		for(GLuint x = 0; x < n; x++)
+		{
+			GLuint a = y*(n+1)+x, b = a+1, c = a+n+1, d = c+1;
+			indices.push_back(a), indices.push_back(c), indices.push_back(b);
+			indices.push_back(b), indices.push_back(c), indices.push_back(d);
+		}
+	}
+
+	//Fisher-Yates with a fixed LCG, so every run shuffles the same way
+	if(!shuffle) return;
+	uint32_t seed = 12345;
+	for(size_t t = indices.size()/3-1; t > 0; t--)
+	{
+		seed = seed*1664525u+1013904223u;
+		size_t r = seed%(t+1);
+		for(GLuint c = 0; c < 3; c++) swap(indices[3*t+c], indices[3*r+c]);
+	}
+}
+
+//Lists the position and normal of every corner of every triangle
+static GLvoid Corners(const Mesh &mesh, vector<Vector3> &corners)
+{
+	corners.clear();
+	for(GLuint i = 0; i < mesh.g.size(); i++)
+	{
+		const vector<GLuint> &indices = mesh.g[i].indices;
+		for(GLuint k = 0; k < indices.size(); k++)
+		{
+			corners.push_back(mesh.v[indices[k]]);
+			corners.push_back(mesh.v[indices[k]+mesh.numVerts]);
+		}
+	}
+}
+
+//Builds a view matrix for a camera at eye looking at target
+static Matrix4 LookAt(const Vector3 &eye, const Vector3 &target, 
+		const Vector3 &up)
+{
+	Vector3 f = (target-eye).Normalize();
+	Vector3 s = f.CrossProduct(up).Normalize();
+	Vector3 u = s.CrossProduct(f);
+
+	Matrix4 m;
+	m.mat[0] = s.x, m.mat[4] = s.y, m.mat[8] = s.z, m.mat[12] = -(s*eye);
+	m.mat[1] = u.x, m.mat[5] = u.y, m.mat[9] = u.z, m.mat[13] = -(u*eye);
+	m.mat[2] = -f.x, m.mat[6] = -f.y, m.mat[10] = -f.z, m.mat[14] = f*eye;
+	return(m);
+}
+
+//Builds a unit sphere out of stacks*slices*2 triangles, wound so that the
+//normals Mesh::CalculateNormals() calculates point outwards
+static GLvoid Sphere(GLuint stacks, GLuint slices, Mesh &mesh)
+{
+	mesh.v.clear();
+	for(GLuint i = 0; i <= stacks; i++)
+	{
+		GLfloat theta = 3.14159265f*i/stacks;
+		for(GLuint j = 0; j <= slices; j++)
+		{
+			GLfloat phi = 2.0f*3.14159265f*j/slices;
+			mesh.v.push_back(Vector3(sinf(theta)*cosf(phi), cosf(theta),
+				sinf(theta)*sinf(phi)));
+		}
+	}
+	mesh.numVerts = mesh.v.size();
+
+	mesh.g.resize(1);
+	vector<GLuint> &indices = mesh.g[0].indices;
+	for(GLuint i = 0; i < stacks; i++)
+	{
+		for(GLuint j = 0; j < slices; j++)
+		{
+			GLuint a = i*(slices+1)+j, b = a+1, c = a+slices+1, d = c+1;
+			GLuint tris[6] = {a, b, c, b, d, c};
+			for(GLuint t = 0; t < 6; t += 3)
+			{
+				//Flip the triangles whose normal points inwards
+				const Vector3 &p = mesh.v[tris[t]], &q = mesh.v[tris[t+1]];
+				const Vector3 &r = mesh.v[tris[t+2]];
+				if((p-r).CrossProduct(q-r)*(p+q+r) < 0.0f) 
+					swap(tris[t+1], tris[t+2]);
+				indices.insert(indices.end(), tris+t, tris+t+3);
+			}
+		}
+	}
+	mesh.g[0].count = indices.size();
+	mesh.CalculateBounds();
+}
+
+//Checks that two triangle lists hold the same triangles with the same 
+//winding, in any order
+static GLboolean SameTriangles(const vector<GLuint> &a, 
+		const vector<GLuint> &b)
+{
+	if(a.size() != b.size()) return(false);
+
+	//Rotate every triangle so its smallest index comes first
+	vector<vector<GLuint> > lists(2);
+	for(GLuint l = 0; l < 2; l++)
+	{
+		const vector<GLuint> &in = (l == 0) ? a : b;
+		vector<GLuint> &out = lists[l];
+		out.resize(in.size());
+		for(size_t t = 0; t < in.size(); t += 3)
+		{
+			GLuint r = (in[t+1] < in[t]) ? 1 : 0;
+			if(in[t+2] < in[t+r]) r = 2;
+			for(GLuint c = 0; c < 3; c++) out[t+c] = in[t+(r+c)%3];
+		}
+	}
+
+	//Then sort the triangles
+	vector<uint64_t> keys[2];
+	for(GLuint l = 0; l < 2; l++)
+	{
+		const vector<GLuint> &in = lists[l];
+		for(size_t t = 0; t < in.size(); t += 3)
+		{
+			keys[l].push_back(((uint64_t)in[t]<<32) | in[t+1]);
+			keys[l].push_back(in[t+2]);
+		}
+	}
+	vector<pair<uint64_t, uint64_t> > sorted[2];
+	for(GLuint l = 0; l < 2; l++)
+	{
+		for(size_t k = 0; k < keys[l].size(); k += 2)
+			sorted[l].push_back(make_pair(keys[l][k], keys[l][k+1]));
+		sort(sorted[l].begin(), sorted[l].end());
+	}
+	return(sorted[0] == sorted[1]);
+}
+
+//The Matrix4 and Vector3 kernels as they were before they used the Simd 
+//operations
+static Matrix4 OldMultiply(const Matrix4 &b, const Matrix4 &m)
+{
+	Matrix4 a;
+	for(GLuint i=0, offset=0, ii=0; i<16; i++, ii++)
+	{
+		a.mat[i]=0, offset=((i%4==0) ? i : offset), ii=((ii>3) ? 0 : ii);
+		for(GLuint j=0, mult=0; j<4; mult++, j++)
+		{
+			a.mat[i]+=b.mat[ii+mult*4]*m.mat[offset+j];
+		}
+	}
+	return(a);
+}
+
+static Vector3 OldTransform(const Matrix4 &m, const Vector3 &v)
+{
+	Vector3 u;
+	u.x = m.mat[0]*v.x+m.mat[4]*v.y+m.mat[8]*v.z+m.mat[12]*v.w;
+	u.y = m.mat[1]*v.x+m.mat[5]*v.y+m.mat[9]*v.z+m.mat[13]*v.w;
+	u.z = m.mat[2]*v.x+m.mat[6]*v.y+m.mat[10]*v.z+m.mat[14]*v.w;
+	u.w = m.mat[3]*v.x+m.mat[7]*v.y+m.mat[11]*v.z+m.mat[15]*v.w;
+	return(u);
+}
+
+static GLfloat OldDot(const Vector3 &u, const Vector3 &v)
+{
+	return(u.x*v.x+u.y*v.y+u.z*v.z);
+}
+
+static Vector3 OldCross(const Vector3 &u, const Vector3 &v)
+{
+	return(Vector3(u.y*v.z-u.z*v.y, u.z*v.x-u.x*v.z, u.x*v.y-u.y*v.x));
+}
+
+static Vector3 OldNormalize(const Vector3 &u)
+{
+	GLfloat k = sqrt(u.x*u.x+u.y*u.y+u.z*u.z);
+	return(Vector3(u.x/k, u.y/k, u.z/k));
+}
+
+//Like the members they were, the old kernels are called out of line
+static Matrix4 (*volatile oldMultiply)(const Matrix4&, const Matrix4&) = 
+	&OldMultiply;
+static Vector3 (*volatile oldTransform)(const Matrix4&, const Vector3&) = 
+	&OldTransform;
+static GLfloat (*volatile oldDot)(const Vector3&, const Vector3&) = &OldDot;
+static Vector3 (*volatile oldCross)(const Vector3&, const Vector3&) = 
+	&OldCross;
+static Vector3 (*volatile oldNormalize)(const Vector3&) = &OldNormalize;
+
+//Both versions of every kernel with the same signature, the results go to
+//out
+typedef GLvoid (*MathKernel)(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out);
+
+//Copies a vector's components to out
+static GLvoid StoreVector(const Vector3 &r, GLfloat *out)
+{
+	out[0] = r.x, out[1] = r.y, out[2] = r.z, out[3] = r.w;
+}
+
+static GLvoid ScalarMatrixMatrix(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	Matrix4 m = oldMultiply(a, b);
+	memcpy(out, m.mat, sizeof(m.mat));
+}
+
+static GLvoid ScalarMatrixVector(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	StoreVector(oldTransform(a, u), out);
+}
+
+static GLvoid ScalarDot(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	out[0] = oldDot(u, v);
+}
+
+static GLvoid ScalarCross(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	StoreVector(oldCross(u, v), out);
+}
+
+static GLvoid ScalarNormalize(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	StoreVector(oldNormalize(u), out);
+}
+
+static GLvoid SimdMatrixMatrix(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	Matrix4 m = a*b;
+	memcpy(out, m.mat, sizeof(m.mat));
+}
+
+static GLvoid SimdMatrixVector(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	StoreVector(a*u, out);
+}
+
+static GLvoid SimdDot(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	out[0] = u*v;
+}
+
+static GLvoid SimdCross(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	StoreVector(u.CrossProduct(v), out);
+}
+
+static GLvoid SimdNormalize(const Matrix4 &a, const Matrix4 &b, 
+		const Vector3 &u, const Vector3 &v, GLfloat *out)
+{
+	StoreVector(u.Normalize(), out);
+}
+
+//Matrix4::Inverse() as it was before it was written out in closed form
+static Matrix4 OldInverse(const Matrix4 &a)
+{
+	Matrix4 m;
+	GLfloat det = a.mat[3]*a.Cofactor(0, 3)+a.mat[7]*a.Cofactor(1, 3)+
+		a.mat[11]*a.Cofactor(2, 3)+a.mat[15]*a.Cofactor(3, 3);
+	if(fabs(det) < 0.000001f) return(m);
+	for(GLuint c=0; c<4; c++)
+		for(GLuint r=0; r<4; r++)
+			m.mat[c*4+r]=a.Cofactor(c, r)/det;
+	return(m.Transpose());
+}
+
+static Matrix4 (*volatile oldInverse)(const Matrix4&) = &OldInverse;
+
+//Every way of inverting a matrix, old and new, with the same signature
+typedef Matrix4 (*InverseKernel)(const Matrix4 &m);
+
+static Matrix4 ScalarInverse(const Matrix4 &m)
+{
+	return(oldInverse(m));
+}
+
+//The normal matrix is the inverse transpose without the translation
+static Matrix4 ScalarNormalMatrix(const Matrix4 &m)
+{
+	Matrix4 n = oldInverse(m).Transpose();
+	n.mat[3] = n.mat[7] = n.mat[11] = 0.0f;
+	n.mat[12] = n.mat[13] = n.mat[14] = 0.0f;
+	return(n);
+}
+
+static Matrix4 FastInverse(const Matrix4 &m)
+{
+	return(m.Inverse());
+}
+
+static Matrix4 FastAffineInverse(const Matrix4 &m)
+{
+	return(m.AffineInverse());
+}
+
+static Matrix4 FastRigidInverse(const Matrix4 &m)
+{
+	return(m.RigidInverse());
+}
+
+static Matrix4 FastNormalMatrix(const Matrix4 &m)
+{
+	return(m.NormalMatrix());
+}
+
+//Runs BatchTransform's points (kernel 0) or normals (kernel 1) function on
+//the vectors, or on the streams if there are any
+static GLvoid BatchKernel(GLuint kernel, GLboolean parallel, 
+		const Matrix4 &m, const vector<Vector3> &in, vector<Vector3> &out,
+		const vector<GLfloat> *streams, vector<GLfloat> *outStreams)
+{
+	size_t n = in.size();
+	if(streams == NULL && kernel == 0 && parallel)
+		BatchTransform::ParallelPoints(m, &in.front(), &out.front(), n);
+	else if(streams == NULL && kernel == 0)
+		BatchTransform::Points(m, &in.front(), &out.front(), n);
+	else if(streams == NULL && parallel)
+		BatchTransform::ParallelNormals(m, &in.front(), &out.front(), n);
+	else if(streams == NULL)
+		BatchTransform::Normals(m, &in.front(), &out.front(), n);
+	else
+	{
+		const GLfloat *x = &streams[0].front(), *y = &streams[1].front();
+		const GLfloat *z = &streams[2].front();
+		GLfloat *ox = &outStreams[0].front(), *oy = &outStreams[1].front();
+		GLfloat *oz = &outStreams[2].front();
+		if(kernel == 0 && parallel)
+			BatchTransform::ParallelPoints(m, x, y, z, ox, oy, oz, n);
+		else if(kernel == 0)
+			BatchTransform::Points(m, x, y, z, ox, oy, oz, n);
+		else if(parallel)
+			BatchTransform::ParallelNormals(m, x, y, z, ox, oy, oz, n);
+		else
+			BatchTransform::Normals(m, x, y, z, ox, oy, oz, n);
+	}
+}
+
+//The matrix glRotatef() multiplies with, as the OpenGL specification
+//defines it
+static Matrix4 RotateMatrix(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+	GLfloat l = sqrtf(x*x+y*y+z*z);
+	x /= l, y /= l, z /= l;
+	GLfloat a = angle*(3.14159265f/180.0f), c = cosf(a), s = sinf(a);
+	Matrix4 m;
+	m.mat[0] = x*x*(1-c)+c, m.mat[4] = x*y*(1-c)-z*s;
+	m.mat[8] = x*z*(1-c)+y*s;
+	m.mat[1] = y*x*(1-c)+z*s, m.mat[5] = y*y*(1-c)+c;
+	m.mat[9] = y*z*(1-c)-x*s;
+	m.mat[2] = x*z*(1-c)-y*s, m.mat[6] = y*z*(1-c)+x*s;
+	m.mat[10] = z*z*(1-c)+c;
+	return(m);
+}
+
+//Returns the largest difference between the elements of two matrices
+static GLfloat MatrixError(const Matrix4 &a, const Matrix4 &b)
+{
+	GLfloat error = 0.0f;
+	for(GLuint i = 0; i < 16; i++) 
+		error = max(error, fabsf(a.mat[i]-b.mat[i]));
+	return(error);
+}
+
+//Compares the boxes and the spheres exactly
+static GLboolean SameBounds(const BoundingBox &a, const BoundingSphere &s,
+	const BoundingBox &b, const BoundingSphere &t)
+{
+	return(a.min == b.min && a.max == b.max && s.center == t.center && 
+		s.radius == t.radius);
+}
+
+//Calculates the vertex normals one triangle at a time, adding each 
+//triangle's normal to its vertices
+static GLvoid ReferenceNormals(const Mesh &mesh, vector<Vector3> &normals)
+{
+	normals.assign(mesh.numVerts, Vector3(0.0f, 0.0f, 0.0f));
+	for(GLuint k = 0; k < mesh.g.size(); k++)
+	{
+		const vector<GLuint> &i = mesh.g[k].indices;
+		for(size_t t = 0; t+2 < i.size(); t += 3)
+		{
+			Vector3 normal = (mesh.v[i[t]]-mesh.v[i[t+2]]).CrossProduct(
+				mesh.v[i[t+1]]-mesh.v[i[t+2]]);
+			normals[i[t]] += normal;
+			normals[i[t+1]] += normal;
+			normals[i[t+2]] += normal;
+		}
+	}
+	for(GLuint i = 0; i < normals.size(); i++) 
+		normals[i] = normals[i].Normalize();
+}
+
+GLboolean Benchmark::Run(const string &name, const string &filename)
+{
+	GLboolean all = (name == "all"), found = false, status = true;
+
+	if(all || name == "math") 
+	{
+		found = true;
+		status = MathKernels() && status;
+	}
+
+	if(all || name == "inverse") 
+	{
+		found = true;
+		status = MatrixInverse() && status;
+	}
+
+	if(all || name == "transform") 
+	{
+		found = true;
+		status = VectorTransform() && status;
+	}
+
+	if(all || name == "camera") 
+	{
+		found = true;
+		status = FrameMatrices() && status;
+	}
+
+	if(all || name == "load") 
+	{
+		found = true;
+		status = MeshLoad(filename) && status;
+	}
+
+	if(all || name == "cache") 
+	{
+		found = true;
+		status = MeshCacheLoad(filename) && status;
+	}
+
+	if(all || name == "format") 
+	{
+		found = true;
+		status = VertexQuantize(filename) && status;
+	}
+
+	if(all || name == "normals") 
+	{
+		found = true;
+		status = MeshNormals(filename) && status;
+	}
+
+	if(all || name == "vcache") 
+	{
+		found = true;
+		status = VertexCacheOrder(filename) && status;
+	}
+
+	if(all || name == "fetch") 
+	{
+		found = true;
+		status = VertexFetchOrder(filename) && status;
+	}
+
+	if(all || name == "meshlet") 
+	{
+		found = true;
+		status = MeshletCull(filename) && status;
+	}
+
+	if(all || name == "lod") 
+	{
+		found = true;
+		status = MeshSimplify(filename) && status;
+	}
+
+	if(all || name == "instance") 
+	{
+		found = true;
+		status = InstancedDraw() && status;
+	}
+
+	if(all || name == "queue") 
+	{
+		found = true;
+		status = RenderQueueSort() && status;
+	}
+
+	if(all || name == "stream") 
+	{
+		found = true;
+		status = StreamUpload() && status;
+	}
+
+	if(all || name == "frustum") 
+	{
+		found = true;
+		status = FrustumCull() && status;
+	}
+
+	if(all || name == "occlusion") 
+	{
+		found = true;
+		status = OcclusionCull() && status;
+	}
+
+	if(!found) cerr << "Unknown benchmark: " << name << endl;
+	return(found && status);
+}
+
+GLboolean Benchmark::MathKernels()
+{
+#if defined(SIMD_AVX)
+	cout << "MATH KERNELS (AVX)" << endl;
+#elif defined(SIMD_SSE)
+	cout << "MATH KERNELS (SSE)" << endl;
+#elif defined(SIMD_NEON)
+	cout << "MATH KERNELS (NEON)" << endl;
+#else
+	cout << "MATH KERNELS (scalar)" << endl;
+#endif
+
+	//Random matrices and vectors from a fixed LCG, few enough to stay in 
+	//the cache
+	const GLuint count = 4096, repeats = 64;
+	vector<Matrix4> matrices(count);
+	vector<Vector3> vectors(count);
+	uint32_t seed = 12345;
+	for(GLuint i = 0; i < count; i++)
+	{
+		GLfloat f[20];
+		for(GLuint k = 0; k < 20; k++)
+		{
+			seed = seed*1664525u+1013904223u;
+			f[k] = (seed>>8)/(GLfloat)(1<<24)*2.0f-1.0f;
+		}
+		memcpy(matrices[i].mat, f, sizeof(matrices[i].mat));
+		vectors[i] = Vector3(f[16], f[17], f[18], f[19]);
+	}
+
+	const GLuint kernels = 5;
+	const char *names[kernels] = {"mat*mat", "mat*vec", "dot", "cross", 
+		"normalize"};
+	GLuint sizes[kernels] = {16, 4, 1, 4, 4};
+	MathKernel scalar[kernels] = {&ScalarMatrixMatrix, &ScalarMatrixVector,
+		&ScalarDot, &ScalarCross, &ScalarNormalize};
+	MathKernel simd[kernels] = {&SimdMatrixMatrix, &SimdMatrixVector, 
+		&SimdDot, &SimdCross, &SimdNormalize};
+
+	GLboolean status = true;
+	vector<GLfloat> out[2];
+	for(GLuint k = 0; k < kernels; k++)
+	{
+		//The kernels are called through a volatile pointer, so neither 
+		//version is inlined into the loop
+		GLfloat best[2] = {0.0f, 0.0f};
+		for(GLuint version = 0; version < 2; version++)
+		{
+			MathKernel volatile kernel = version ? simd[k] : scalar[k];
+			out[version].assign(count*sizes[k], 0.0f);
+			GLfloat *o = &out[version].front();
+			for(GLuint r = 0; r < RUNS; r++)
+			{
+				sf::Clock timer;
+				for(GLuint n = 0; n < repeats; n++)
+				{
+					for(GLuint i = 0; i < count; i++)
+					{
+						GLuint j = (i+1)%count;
+						kernel(matrices[i], matrices[j], vectors[i], 
+							vectors[j], o+i*sizes[k]);
+					}
+				}
+				GLfloat time = timer.getElapsedTime().asSeconds();
+				if(r == 0 || time < best[version]) best[version] = time;
+			}
+		}
+
+		GLboolean same = (out[0] == out[1]);
+		status = status && same;
+		GLfloat calls = (GLfloat)count*repeats;
+		cout << left << setw(14) << names[k] << ": " << setw(10) << 
+			best[0]*1e9f/calls << " ns -> " << setw(10) << 
+			best[1]*1e9f/calls << " ns  " << setw(10) << 
+			(best[1] > 0.0f ? best[0]/best[1] : 0.0f) << "x  " << 
+			(same ? "identical" : "DIFFERENT") << endl;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::MatrixInverse()
+{
+	cout << "MATRIX INVERSE" << endl;
+
+	//Views of random cameras, the same scaled unevenly, and projections of
+	//them, like the matrices the renderer inverts
+	const GLuint count = 4096, repeats = 16;
+	vector<Matrix4> matrices[3];
+	uint32_t seed = 12345;
+	for(GLuint i = 0; i < count; i++)
+	{
+		GLfloat f[9];
+		for(GLuint k = 0; k < 9; k++)
+		{
+			seed = seed*1664525u+1013904223u;
+			f[k] = (seed>>8)/(GLfloat)(1<<24);
+		}
+		Vector3 eye(f[0]*20.0f-10.0f, f[1]*20.0f-10.0f, f[2]*20.0f-10.0f);
+		Vector3 target(f[3]-0.5f, f[4]-0.5f, f[5]-0.5f);
+		Matrix4 rigid = LookAt(eye, target, Vector3(0.0f, 1.0f, 0.0f));
+		Matrix4 scale;
+		scale.mat[0] = 0.5f+f[6]*1.5f, scale.mat[5] = 0.5f+f[7]*1.5f;
+		scale.mat[10] = 0.5f+f[8]*1.5f;
+		Matrix4 projection;
+		projection.Perspective(30.0f+f[6]*60.0f, 1.0f+f[7], 1.0f, 100.0f);
+		matrices[0].push_back(rigid);
+		matrices[1].push_back(rigid*scale);
+		matrices[2].push_back(projection*rigid);
+	}
+
+	const GLuint kernels = 4;
+	const char *names[kernels] = {"inverse", "affine", "rigid", "normal"};
+	GLuint inputs[kernels] = {2, 1, 0, 1};
+	InverseKernel scalar[kernels] = {&ScalarInverse, &ScalarInverse, 
+		&ScalarInverse, &ScalarNormalMatrix};
+	InverseKernel fast[kernels] = {&FastInverse, &FastAffineInverse, 
+		&FastRigidInverse, &FastNormalMatrix};
+
+	GLboolean status = true;
+	vector<Matrix4> out[2];
+	for(GLuint k = 0; k < kernels; k++)
+	{
+		const vector<Matrix4> &in = matrices[inputs[k]];
+		GLfloat best[2] = {0.0f, 0.0f};
+		for(GLuint version = 0; version < 2; version++)
+		{
+			InverseKernel volatile kernel = version ? fast[k] : scalar[k];
+			out[version].resize(count);
+			for(GLuint r = 0; r < RUNS; r++)
+			{
+				sf::Clock timer;
+				for(GLuint n = 0; n < repeats; n++)
+				{
+					for(GLuint i = 0; i < count; i++) 
+						out[version][i] = kernel(in[i]);
+				}
+				GLfloat time = timer.getElapsedTime().asSeconds();
+				if(r == 0 || time < best[version]) best[version] = time;
+			}
+		}
+
+		//Relative to the size of the elements, the inverses of the 
+		//projections hold elements near 100
+		GLfloat error = 0.0f;
+		for(GLuint i = 0; i < count; i++)
+		{
+			for(GLuint e = 0; e < 16; e++)
+			{
+				GLfloat a = out[0][i].mat[e], b = out[1][i].mat[e];
+				error = max(error, fabsf(a-b)/max(1.0f, fabsf(a)));
+			}
+		}
+		GLboolean close = (error < 0.0001f);
+		status = status && close;
+		GLfloat calls = (GLfloat)count*repeats;
+		cout << left << setw(14) << names[k] << ": " << setw(10) << 
+			best[0]*1e9f/calls << " ns -> " << setw(10) << 
+			best[1]*1e9f/calls << " ns  " << setw(10) << 
+			(best[1] > 0.0f ? best[0]/best[1] : 0.0f) << "x  error " << 
+			setw(12) << error << (close ? "ok" : "WRONG") << endl;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::VectorTransform()
+{
+	//Far more vectors than fit in the caches, the transforms should be 
+	//limited by the memory bandwidth
+	const size_t count = 1<<22;
+	cout << "VECTOR TRANSFORM (" << count << " vectors)" << endl;
+
+	vector<Vector3> in(count), out(count), reference[2];
+	vector<GLfloat> streams[3], outStreams[3];
+	uint32_t seed = 12345;
+	for(size_t i = 0; i < count; i++)
+	{
+		GLfloat f[3];
+		for(GLuint k = 0; k < 3; k++)
+		{
+			seed = seed*1664525u+1013904223u;
+			f[k] = (seed>>8)/(GLfloat)(1<<24)*2.0f-1.0f;
+		}
+		in[i] = Vector3(f[0], f[1], f[2]);
+	}
+	for(GLuint k = 0; k < 3; k++)
+	{
+		streams[k].resize(count), outStreams[k].resize(count);
+		for(size_t i = 0; i < count; i++) streams[k][i] = (&in[i].x)[k];
+	}
+	Matrix4 m = LookAt(Vector3(3.0f, 2.0f, 1.0f), Vector3(0.0f, 0.0f, 0.0f),
+		Vector3(0.0f, 1.0f, 0.0f));
+	Matrix4 scale;
+	scale.mat[0] = 2.0f, scale.mat[5] = 0.5f, scale.mat[10] = 1.5f;
+	m *= scale;
+
+	Parallel::maxThreads = 0;
+	GLuint processors = Parallel::ThreadCount();
+
+	GLboolean status = true;
+	const char *names[2] = {"points", "normals"};
+	for(GLuint kernel = 0; kernel < 2; kernel++)
+	{
+		//One vector at a time, as before there was a batch API
+		Matrix4 normal = m.NormalMatrix();
+		GLfloat loop = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			reference[kernel].resize(count);
+			Vector3 *o = &reference[kernel].front();
+			sf::Clock timer;
+			if(kernel == 0) for(size_t i = 0; i < count; i++) o[i] = m*in[i];
+			else 
+			{
+				for(size_t i = 0; i < count; i++) 
+					o[i] = (normal*in[i]).Normalize();
+			}
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < loop) loop = time;
+		}
+		string name = string(names[kernel])+" loop";
+		cout << left << setw(14) << name << ": " << setw(10) << 
+			loop*1000.0f << " ms  " << setw(10) << 
+			32.0f*count/loop/1e9f << " GB/s" << endl;
+
+		//Vectors read and written take 32 bytes, streams 24 bytes. The
+		//serial function runs first, followed by the Parallel function 
+		//on 1, 2, 4... threads.
+		for(GLuint layout = 0; layout < 2; layout++)
+		{
+			for(GLuint t = 0; t < processors*2; t = (t == 0) ? 1 : t*2)
+			{
+				Parallel::maxThreads = (t < processors) ? t : processors;
+				GLfloat best = 0.0f;
+				for(GLuint r = 0; r < RUNS; r++)
+				{
+					out.assign(count, Vector3(0.0f, 0.0f, 0.0f, 0.0f));
+					for(GLuint k = 0; k < 3; k++)
+						outStreams[k].assign(count, 0.0f);
+					sf::Clock timer;
+					BatchKernel(kernel, t > 0, m, in, out, 
+						layout ? streams : NULL, outStreams);
+					GLfloat time = timer.getElapsedTime().asSeconds();
+					if(r == 0 || time < best) best = time;
+				}
+
+				GLboolean same = true;
+				const vector<Vector3> &ref = reference[kernel];
+				for(size_t i = 0; same && i < count; i++)
+				{
+					if(layout == 0)
+					{
+						same = (out[i].x == ref[i].x && out[i].y == ref[i].y &&
+							out[i].z == ref[i].z && out[i].w == ref[i].w);
+					}
+					else 
+					{
+						same = (outStreams[0][i] == ref[i].x && 
+							outStreams[1][i] == ref[i].y &&
+							outStreams[2][i] == ref[i].z);
+					}
+				}
+				status = status && same;
+
+				ostringstream name(ostringstream::out);
+				name << "  " << (layout ? "streams" : "vectors");
+				if(t > 0) name << " x" << Parallel::ThreadCount();
+				GLfloat bytes = (layout ? 24.0f : 32.0f)*count;
+				cout << left << setw(14) << name.str() << ": " << setw(10) << 
+					best*1000.0f << " ms  " << setw(10) << 
+					bytes/best/1e9f << " GB/s  " << setw(10) << 
+					(best > 0.0f ? loop/best : 0.0f) << "x  " << 
+					(same ? "identical" : "DIFFERENT") << endl;
+			}
+		}
+		Parallel::maxThreads = 0;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::FrameMatrices()
+{
+	cout << "FRAME MATRICES" << endl;
+
+	//Random rotations, checked against the matrices glRotatef() builds
+	uint32_t seed = 12345;
+	GLfloat rotation = 0.0f, rotated = 0.0f, slerp = 0.0f, inverse = 0.0f;
+	for(GLuint i = 0; i < 4096; i++)
+	{
+		GLfloat f[8];
+		for(GLuint k = 0; k < 8; k++)
+		{
+			seed = seed*1664525u+1013904223u;
+			f[k] = (seed>>8)/(GLfloat)(1<<24)*2.0f-1.0f;
+		}
+		Vector3 axis(f[0], f[1], f[2]), v(f[3], f[4], f[5]);
+		if(axis.Length() < 0.01f) continue;
+		Quaternion q = Quaternion::FromAxisAngle(axis, f[6]*180.0f);
+		Matrix4 m = q.ToMatrix();
+		rotation = max(rotation, MatrixError(m, 
+			RotateMatrix(f[6]*180.0f, axis.x, axis.y, axis.z)));
+		rotated = max(rotated, ((q*v)-(m*v)).Length());
+
+		//Halfway between two rotations around the same axis, less than
+		//180 degrees apart, is the rotation by the average angle
+		Quaternion a = Quaternion::FromAxisAngle(axis, f[6]*90.0f);
+		Quaternion b = Quaternion::FromAxisAngle(axis, f[7]*90.0f);
+		Quaternion h = Quaternion::FromAxisAngle(axis, (f[6]+f[7])*45.0f);
+		slerp = max(slerp, MatrixError(a.Slerp(b, 0.5f).ToMatrix(), 
+			h.ToMatrix()));
+
+		Transform t;
+		t.position = v*10.0f, t.rotation = q;
+		t.scale = Vector3(1.5f+f[3], 1.5f+f[4], 1.5f+f[5]);
+		inverse = max(inverse, MatrixError(t.ToMatrix()*t.InverseMatrix(),
+			Matrix4()));
+	}
+	GLboolean status = (rotation < 1e-5f && rotated < 1e-5f && 
+		slerp < 1e-4f && inverse < 1e-4f);
+	cout << left << setw(14) << "rotation" << ": error " << setw(12) << 
+		rotation << "vector " << setw(12) << rotated << "slerp " << 
+		setw(12) << slerp << "inverse " << setw(12) << inverse << 
+		(status ? "ok" : "WRONG") << endl;
+
+	//The matrices of a frame of App::Render() built the way it used to be,
+	//with glRotatef()'s matrix built on the CPU instead of read back from
+	//the driver, and with a Transform and a Camera. Both give the 
+	//modelviewprojection, the normal matrix and the eye position.
+	const GLuint frames = 1<<16;
+	Matrix4 projection;
+	projection.Perspective(60.0f, 16.0f/9.0f, 1.0f, 10000.0f);
+	Camera camera;
+	camera.position = Vector3(0.5f, 0.25f, 2.0f);
+	vector<Matrix4> out[2];
+	vector<Vector3> eyes[2];
+	GLfloat best[2] = {0.0f, 0.0f};
+	for(GLuint version = 0; version < 2; version++)
+	{
+		out[version].resize(2*frames), eyes[version].resize(frames);
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			sf::Clock timer;
+			for(GLuint i = 0; i < frames; i++)
+			{
+				GLfloat rot = (i%1800)*0.2f;
+				Matrix4 modelview;
+				if(version == 0)
+				{
+					Matrix4 view, model;
+					view.Translate(camera.position);
+					model.Translate(0.0f, 0.0f, -10.0f);
+					model *= RotateMatrix(rot, 0.0f, 1.0f, 0.0f);
+					modelview = view.RigidInverse()*model;
+				}
+				else
+				{
+					Transform object;
+					object.position = Vector3(0.0f, 0.0f, -10.0f);
+					object.rotation = Quaternion::FromAxisAngle(
+						Vector3(0.0f, 1.0f, 0.0f), rot);
+					modelview = camera.ViewMatrix()*object.ToMatrix();
+				}
+				eyes[version][i] = modelview.RigidInverse()*
+					Vector3(0.0f, 0.0f, 0.0f);
+				out[version][2*i] = projection*modelview;
+				out[version][2*i+1] = modelview.NormalMatrix();
+			}
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < best[version]) best[version] = time;
+		}
+	}
+
+	GLfloat error = 0.0f;
+	for(GLuint i = 0; i < frames; i++)
+	{
+		error = max(error, MatrixError(out[0][2*i], out[1][2*i]));
+		error = max(error, MatrixError(out[0][2*i+1], out[1][2*i+1]));
+		error = max(error, (eyes[0][i]-eyes[1][i]).Length());
+	}
+	GLboolean good = (error < 1e-4f);
+	status = status && good;
+	const char *names[2] = {"glRotatef", "transform"};
+	for(GLuint version = 0; version < 2; version++)
+	{
+		cout << left << setw(14) << names[version] << ": " << setw(10) << 
+			best[version]*1e9f/frames << " ns/frame";
+		if(version == 1)
+		{
+			cout << "  " << setw(10) << (best[1] > 0.0f ? best[0]/best[1] :
+				0.0f) << "x  error " << setw(12) << error << 
+				(good ? "ok" : "WRONG");
+		}
+		cout << endl;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::MeshLoad(const string &filename)
+{
+	cout << "OBJ PARSE THROUGHPUT (" << filename << ")" << endl;
+
+	//The stream parser is the reference every other mode is checked against
+	Mesh reference;
+	if(!reference.Open(filename, MESH_LOAD_STREAM))
+	{
+		cerr << "Could not open " << filename << endl;
+		return(false);
+	}
+
+	//Every load path, the parallel one with 1, 2, 4... threads up to the
+	//number of processors
+	vector<GLuint> modes, threads;
+	modes.push_back(MESH_LOAD_STREAM), threads.push_back(1);
+	modes.push_back(MESH_LOAD_MAPPED), threads.push_back(1);
+	Parallel::maxThreads = 0;
+	GLuint processors = Parallel::ThreadCount();
+	for(GLuint t = 1; t < processors*2; t *= 2)
+	{
+		modes.push_back(MESH_LOAD_PARALLEL);
+		threads.push_back((t < processors) ? t : processors);
+	}
+
+	GLboolean status = true;
+	for(GLuint m = 0; m < modes.size(); m++)
+	{
+		Parallel::maxThreads = threads[m];
+
+		Mesh mesh;
+		GLfloat best = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			mesh.Open(filename, modes[m]);
+			if(r == 0 || mesh.stats.parseTime < best) 
+				best = mesh.stats.parseTime;
+		}
+		mesh.stats.parseTime = best;
+
+		//Compare the result with the reference mesh
+		GLboolean same = (mesh.v == reference.v && mesh.vt == reference.vt &&
+			mesh.g.size() == reference.g.size() && 
+			mesh.materials == reference.materials);
+		for(GLuint i = 0; same && i < mesh.g.size(); i++)
+		{
+			same = (mesh.g[i].indices == reference.g[i].indices &&
+				mesh.g[i].mtl == reference.g[i].mtl);
+		}
+		status = status && same;
+
+		ostringstream name(ostringstream::out);
+		if(modes[m] == MESH_LOAD_STREAM) name << "stream";
+		else if(modes[m] == MESH_LOAD_MAPPED) name << "mapped";
+		else name << "parallel x" << mesh.stats.threads;
+
+		cout << left << setw(14) << name.str() << ": " << setw(10) 
+			<< mesh.stats.Throughput() << " MB/s  " << setw(10) 
+			<< best*1000.0f << " ms  " << (same ? "identical" : "DIFFERENT")
+			<< endl;
+	}
+	Parallel::maxThreads = 0;
+
+	return(status);
+}
+
+GLboolean Benchmark::MeshCacheLoad(const string &filename)
+{
+	cout << "MESH CACHE LOAD (" << filename << ")" << endl;
+
+	//Load from the OBJ file, the way it's done without a cache
+	Mesh reference;
+	GLfloat best = 0.0f;
+	for(GLuint r = 0; r < RUNS; r++)
+	{
+		sf::Clock timer;
+		if(!reference.Open(filename, MESH_LOAD_PARALLEL))
+		{
+			cerr << "Could not open " << filename << endl;
+			return(false);
+		}
+		reference.CalculateNormals();
+		GLfloat time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < best) best = time;
+	}
+	cout << left << setw(14) << "obj+normals" << ": " << setw(10) 
+		<< best*1000.0f << " ms" << endl;
+
+	//The first load writes the cache unless it's already up to date
+	Mesh mesh;
+	mesh.Open(filename, MESH_LOAD_CACHE | MESH_LOAD_PARALLEL);
+	cout << left << setw(14) << "first load" << ": " << setw(10) 
+		<< mesh.stats.parseTime*1000.0f << " ms  " << (mesh.stats.fromCache ?
+			"cache was valid" : (mesh.stats.cacheWritten ? "cache written" :
+				"CACHE NOT WRITTEN")) << endl;
+
+	for(GLuint r = 0; r < RUNS; r++)
+	{
+		sf::Clock timer;
+		mesh.Open(filename, MESH_LOAD_CACHE | MESH_LOAD_PARALLEL);
+		mesh.CalculateNormals();
+		GLfloat time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < best) best = time;
+	}
+
+	//The cached arrays must be exactly the arrays of the loaded mesh
+	GLboolean same = mesh.stats.fromCache && 
+		mesh.numVerts == reference.numVerts && 
+		mesh.g.size() == reference.g.size() &&
+		memcmp(mesh.Vertices(), reference.Vertices(), 
+			reference.v.size()*sizeof(Vector3)) == 0 &&
+		mesh.cache.header->numTexcoords == reference.vt.size() &&
+		(reference.vt.empty() || memcmp(mesh.cache.texcoords, 
+			&reference.vt.front(), reference.vt.size()*sizeof(Vec2f)) == 0) &&
+		SameBounds(mesh.bounds, mesh.sphere, reference.bounds, 
+			reference.sphere) && mesh.materials == reference.materials &&
+		mesh.materialNames == reference.materialNames;
+	for(GLuint i = 0; same && i < mesh.g.size(); i++)
+	{
+		const vector<GLuint> &indices = reference.g[i].indices;
+		same = (mesh.g[i].count == (GLsizei)indices.size() &&
+			mesh.g[i].mtl == reference.g[i].mtl && (indices.empty() ||
+			memcmp(mesh.cache.Indices(i), &indices.front(), 
+				indices.size()*sizeof(GLuint)) == 0) &&
+			SameBounds(mesh.g[i].bounds, mesh.g[i].sphere, 
+				reference.g[i].bounds, reference.g[i].sphere));
+	}
+
+	cout << left << setw(14) << "cached" << ": " << setw(10) 
+		<< best*1000.0f << " ms  " << (same ? "identical" : "DIFFERENT")
+		<< endl;
+
+	return(same);
+}
+
+GLboolean Benchmark::VertexQuantize(const string &filename)
+{
+	cout << "VERTEX QUANTIZATION (" << filename << ")" << endl;
+
+	//Welding gives every vertex its own texture coordinate
+	Mesh mesh;
+	if(!mesh.Open(filename, MESH_LOAD_PARALLEL | MESH_LOAD_WELD))
+	{
+		cerr << "Could not open " << filename << endl;
+		return(false);
+	}
+	mesh.CalculateNormals();
+
+	const Vector3 *positions = mesh.Vertices();
+	const Vector3 *normals = positions+mesh.numVerts;
+	const Vec2f *texcoords = mesh.Texcoords();
+	vector<QuantizedVertex> quantized(mesh.numVerts);
+	if(quantized.empty()) return(true);
+
+	GLfloat best = 0.0f;
+	for(GLuint r = 0; r < RUNS; r++)
+	{
+		sf::Clock timer;
+		VertexFormat::Quantize(positions, normals, texcoords, mesh.numVerts,
+			mesh.bounds, &quantized.front());
+		GLfloat time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < best) best = time;
+	}
+
+	//Decode every vertex the way the vertex shader does. Position errors 
+	//are relative to the size of the bounding box, normal errors are angles.
+	Vector3 size = mesh.bounds.Size();
+	GLfloat extent = max(size.x, max(size.y, size.z));
+	GLfloat position = 0.0f, angle = 0.0f, texcoord = 0.0f;
+	size_t overflows = 0;
+	for(GLuint i = 0; i < mesh.numVerts; i++)
+	{
+		const QuantizedVertex &q = quantized[i];
+		Vector3 p(q.position[0]/65535.0f*size.x+mesh.bounds.min.x,
+			q.position[1]/65535.0f*size.y+mesh.bounds.min.y,
+			q.position[2]/65535.0f*size.z+mesh.bounds.min.z);
+		Vector3 d = p-positions[i];
+		GLfloat e = max(fabsf(d.x), max(fabsf(d.y), fabsf(d.z)));
+		if(extent > 0.0f) position = max(position, e/extent);
+
+		//Degenerate triangles leave zero normals. The angle comes from the
+		//cross product, acos of a float is too coarse near zero.
+		if(normals[i].Length() > 0.0f)
+		{
+			Vector3 n = normals[i].Normalize();
+			Vector3 c = VertexFormat::OctDecode(q.normal).CrossProduct(n);
+			GLfloat a = asinf(min(c.Length(), 1.0f))*180.0f/3.14159265f;
+			angle = max(angle, a);
+		}
+
+		if(texcoords != NULL)
+		{
+			for(GLuint k = 0; k < 2; k++)
+			{
+				GLfloat t = texcoords[i][k];
+				if(fabsf(t) > 65504.0f) {overflows++; continue;}
+				GLfloat h = VertexFormat::HalfToFloat(q.texcoord[k]);
+				texcoord = max(texcoord, fabsf(h-t)/max(fabsf(t), 1.0f));
+			}
+		}
+	}
+
+	GLsizei full = VertexFormat::Size(VERTEX_FORMAT_FLOAT);
+	GLsizei compact = VertexFormat::Size(VERTEX_FORMAT_QUANTIZED);
+	cout << left << setw(14) << "vertices" << ": " << mesh.numVerts << 
+		(texcoords != NULL ? " with" : " without") << " texcoords" << endl;
+	cout << left << setw(14) << "quantize" << ": " << setw(10) 
+		<< best*1000.0f << " ms  x" << Parallel::ThreadCount() << endl;
+	cout << left << setw(14) << "bytes/vertex" << ": " << full << " -> " 
+		<< compact << endl;
+	cout << left << setw(14) << "position err" << ": " << position 
+		<< " of the largest extent" << endl;
+	cout << left << setw(14) << "normal err" << ": " << angle << " degrees"
+		<< endl;
+	cout << left << setw(14) << "texcoord err" << ": " << texcoord;
+	if(overflows > 0) cout << " (" << overflows << " beyond the half range)";
+	cout << endl;
+
+	//Half a quantization step for positions, the octahedral grid of 16 bit
+	//components is finer than a hundredth of a degree, half floats keep 11
+	//bits of the mantissa. Texture coordinates too large for half floats 
+	//are reported but don't fail the benchmark.
+	GLboolean good = position <= 0.5f/65535.0f*1.001f+1e-6f && 
+		angle < 0.01f && texcoord <= 1.0f/2048.0f;
+	cout << left << setw(14) << "result" << ": " << (good ? "within "
+		"precision" : "TOO INACCURATE") << endl;
+	return(good);
+}
+
+GLboolean Benchmark::MeshNormals(const string &filename)
+{
+	cout << "VERTEX NORMALS (" << filename << ")" << endl;
+
+	vector<string> names;
+	vector<Mesh*> meshes;
+	Mesh *mesh = new Mesh();
+	if(mesh->Open(filename, MESH_LOAD_PARALLEL))
+	{
+		names.push_back(filename);
+		meshes.push_back(mesh);
+	}
+	else
+	{
+		cerr << "Could not open " << filename << endl;
+		delete mesh;
+	}
+	mesh = new Mesh();
+	Sphere(1024, 2048, *mesh);
+	names.push_back("sphere");
+	meshes.push_back(mesh);
+
+	Parallel::maxThreads = 0;
+	GLuint processors = Parallel::ThreadCount();
+
+	GLboolean status = true;
+	for(GLuint m = 0; m < meshes.size(); m++)
+	{
+		mesh = meshes[m];
+		size_t triangles = 0;
+		for(GLuint i = 0; i < mesh->g.size(); i++)
+			triangles += mesh->g[i].indices.size()/3;
+		cout << names[m] << ": " << mesh->numVerts << " vertices, " << 
+			triangles << " triangles" << endl;
+
+		//The normals summed one triangle at a time on one thread
+		vector<Vector3> reference;
+		GLfloat serial = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			sf::Clock timer;
+			ReferenceNormals(*mesh, reference);
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < serial) serial = time;
+		}
+		cout << left << setw(14) << "  serial" << ": " << setw(10) << 
+			serial*1000.0f << " ms" << endl;
+
+		for(GLuint t = 1; t < processors*2; t *= 2)
+		{
+			Parallel::maxThreads = (t < processors) ? t : processors;
+			GLfloat best = 0.0f;
+			for(GLuint r = 0; r < RUNS; r++)
+			{
+				mesh->v.resize(mesh->numVerts);
+				sf::Clock timer;
+				mesh->CalculateNormals();
+				GLfloat time = timer.getElapsedTime().asSeconds();
+				if(r == 0 || time < best) best = time;
+			}
+
+			//Normals of vertices without triangles are NaN either way
+			GLfloat error = 0.0f;
+			GLboolean good = (mesh->v.size() == 2*mesh->numVerts);
+			for(GLuint i = 0; good && i < mesh->numVerts; i++)
+			{
+				const Vector3 &a = mesh->v[mesh->numVerts+i];
+				const Vector3 &b = reference[i];
+				if(a.x != a.x && b.x != b.x) continue;
+				error = max(error, (a-b).Length());
+			}
+			good = good && error <= 1e-5f;
+			status = status && good;
+
+			ostringstream name(ostringstream::out);
+			name << "  x" << Parallel::ThreadCount();
+			cout << left << setw(14) << name.str() << ": " << setw(10) << 
+				best*1000.0f << " ms  " << setw(10) << 
+				(best > 0.0f ? serial/best : 0.0f) << "x  error " << 
+				setw(10) << error << (good ? "ok" : "WRONG") << endl;
+		}
+		Parallel::maxThreads = 0;
+		delete mesh;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::VertexCacheOrder(const string &filename)
+{
+	cout << "VERTEX CACHE ORDER (" << filename << ", FIFO of " << 
+		VERTEX_CACHE_FIFO_SIZE << ")" << endl;
+
+	//The groups of the file are drawn one after the other, so they're 
+	//measured as one index buffer
+	vector<string> names;
+	vector<vector<GLuint> > lists;
+	Mesh mesh;
+	if(mesh.Open(filename, MESH_LOAD_PARALLEL))
+	{
+		names.push_back(filename);
+		lists.push_back(vector<GLuint>());
+		for(GLuint i = 0; i < mesh.g.size(); i++)
+		{
+			lists.back().insert(lists.back().end(), mesh.g[i].indices.begin(),
+				mesh.g[i].indices.end());
+		}
+	}
+	else cerr << "Could not open " << filename << endl;
+
+	names.push_back("grid 256");
+	lists.push_back(vector<GLuint>());
+	Grid(256, false, lists.back());
+	names.push_back("shuffled 256");
+	lists.push_back(vector<GLuint>());
+	Grid(256, true, lists.back());
+
+	GLboolean status = true;
+	for(GLuint m = 0; m < lists.size(); m++)
+	{
+		const vector<GLuint> &indices = lists[m];
+		if(indices.empty()) continue;
+
+		vector<GLuint> optimized;
+		GLfloat best = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			optimized = indices;
+			sf::Clock timer;
+			VertexCache::Optimize(&optimized.front(), optimized.size());
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < best) best = time;
+		}
+
+		VertexCacheStats before = VertexCache::Measure(&indices.front(), 
+			indices.size());
+		VertexCacheStats after = VertexCache::Measure(&optimized.front(),
+			optimized.size());
+		GLboolean good = SameTriangles(indices, optimized) && 
+			after.ACMR() <= before.ACMR();
+		status = status && good;
+
+		cout << left << setw(14) << names[m] << ": ACMR " << setw(8) << 
+			before.ACMR() << " -> " << setw(8) << after.ACMR() << " ATVR " 
+			<< setw(8) << before.ATVR() << " -> " << setw(8) << after.ATVR()
+			<< setw(10) << best*1000.0f << " ms  " << (good ? "ok" : 
+				"WRONG") << endl;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::VertexFetchOrder(const string &filename)
+{
+	cout << "VERTEX FETCH ORDER (" << filename << ", " << VERTEX_FETCH_LINES
+		<< " lines of " << VERTEX_FETCH_LINE_SIZE << " bytes)" << endl;
+
+	vector<string> names;
+	vector<Mesh*> meshes;
+	Mesh *mesh = new Mesh();
+	if(mesh->Open(filename, MESH_LOAD_PARALLEL))
+	{
+		names.push_back(filename);
+		meshes.push_back(mesh);
+	}
+	else
+	{
+		cerr << "Could not open " << filename << endl;
+		delete mesh;
+	}
+
+	//A grid with both its triangles and its vertices in random order
+	GLuint n = 256;
+	mesh = new Mesh();
+	mesh->numVerts = (n+1)*(n+1);
+	mesh->g.resize(1);
+	Grid(n, true, mesh->g[0].indices);
+	vector<GLuint> order(mesh->numVerts);
+	for(GLuint i = 0; i < order.size(); i++) order[i] = i;
+	uint32_t seed = 54321;
+	for(GLuint i = order.size()-1; i > 0; i--)
+	{
+		seed = seed*1664525u+1013904223u;
+		swap(order[i], order[seed%(i+1)]);
+	}
+	mesh->v.resize(mesh->numVerts);
+	for(GLuint i = 0; i < order.size(); i++) 
+		mesh->v[order[i]] = Vector3(i%(n+1), i/(n+1), 0.0f);
+	vector<GLuint> &indices = mesh->g[0].indices;
+	for(GLuint i = 0; i < indices.size(); i++) indices[i] = order[indices[i]];
+	names.push_back("shuffled 256");
+	meshes.push_back(mesh);
+
+	GLboolean status = true;
+	for(GLuint m = 0; m < meshes.size(); m++)
+	{
+		mesh = meshes[m];
+		mesh->CalculateNormals();
+
+		//The file order is what the reordered triangles are measured 
+		//against
+		vector<GLuint> original, optimized;
+		for(GLuint i = 0; i < mesh->g.size(); i++)
+		{
+			original.insert(original.end(), mesh->g[i].indices.begin(), 
+				mesh->g[i].indices.end());
+		}
+		VertexFetchStats fetch = original.empty() ? VertexFetchStats() :
+			VertexCache::MeasureFetch(&original.front(), original.size(),
+				sizeof(Vector3));
+
+		//Reordering the triangles keeps the triangles, moving the vertices
+		//keeps the position and normal of every corner
+		mesh->OptimizeIndices();
+		for(GLuint i = 0; i < mesh->g.size(); i++)
+		{
+			optimized.insert(optimized.end(), mesh->g[i].indices.begin(), 
+				mesh->g[i].indices.end());
+		}
+		vector<Vector3> before, after;
+		Corners(*mesh, before);
+		mesh->RemapVertices();
+		Corners(*mesh, after);
+		//Degenerate triangles have NaN normals, so compare the bytes
+		GLboolean good = SameTriangles(original, optimized) && 
+			before.size() == after.size() && (before.empty() || 
+			memcmp(&before.front(), &after.front(), 
+				before.size()*sizeof(Vector3)) == 0);
+		status = status && good;
+
+		cout << left << setw(14) << names[m] << ": " << setw(9) << 
+			fetch.MissRatio() << " -> " << setw(9) << 
+			mesh->stats.fetchBefore.MissRatio() << " -> " << setw(9) << 
+			mesh->stats.fetchAfter.MissRatio() << " lines/vertex " << 
+			setw(10) << mesh->stats.remapTime*1000.0f << " ms  " << 
+			(good ? "ok" : "WRONG") << endl;
+		delete mesh;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::MeshletCull(const string &filename)
+{
+	cout << "MESHLET CULLING (" << filename << ")" << endl;
+
+	//The file is culled with the clockwise front faces App draws with,
+	//the sphere with either winding
+	vector<string> names;
+	vector<Mesh*> meshes;
+	vector<GLenum> windings;
+	Mesh *mesh = new Mesh();
+	if(mesh->Open(filename, MESH_LOAD_PARALLEL | MESH_LOAD_OPTIMIZE))
+	{
+		names.push_back(filename);
+		meshes.push_back(mesh);
+		windings.push_back(GL_CW);
+	}
+	else
+	{
+		cerr << "Could not open " << filename << endl;
+		delete mesh;
+	}
+	for(GLuint w = 0; w < 2; w++)
+	{
+		mesh = new Mesh();
+		Sphere(256, 512, *mesh);
+		vector<GLuint> &indices = mesh->g[0].indices;
+		for(size_t i = 0; w == 1 && i+2 < indices.size(); i += 3)
+			swap(indices[i+1], indices[i+2]);
+		mesh->OptimizeIndices();
+		names.push_back((w == 0) ? "sphere" : "clockwise sphere");
+		meshes.push_back(mesh);
+		windings.push_back((w == 0) ? GL_CCW : GL_CW);
+	}
+
+	GLboolean status = true;
+	for(GLuint m = 0; m < meshes.size(); m++)
+	{
+		mesh = meshes[m];
+		GLfloat best = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			sf::Clock timer;
+			mesh->BuildMeshlets();
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < best) best = time;
+		}
+
+		size_t count = 0, vertices = 0, triangles = 0;
+		for(GLuint i = 0; i < mesh->g.size(); i++)
+		{
+			const vector<Meshlet> &meshlets = mesh->g[i].meshlets;
+			count += meshlets.size();
+			for(GLuint k = 0; k < meshlets.size(); k++)
+			{
+				vertices += meshlets[k].vertexCount;
+				triangles += meshlets[k].triangleCount;
+			}
+		}
+		cout << names[m] << ": " << count << " meshlets, " << 
+			(count ? (GLfloat)vertices/count : 0.0f) << " vertices and " << 
+			(count ? (GLfloat)triangles/count : 0.0f) << " triangles each, "
+			<< best*1000.0f << " ms to build" << endl;
+
+		//Cameras on a ring around the mesh, far enough to see all of it 
+		//and close enough to see a part of it
+		Vector3 center = mesh->bounds.Center();
+		GLfloat radius = mesh->bounds.Size().Length()*0.5f;
+		const Vector3 *v = mesh->Vertices();
+		GLfloat distances[2] = {2.5f, 0.8f};
+		for(GLuint d = 0; d < 2; d++)
+		{
+			MeshletCullStats total;
+			GLfloat time = 0.0f;
+			GLboolean good = true;
+			GLuint views = 8;
+			for(GLuint k = 0; k < views; k++)
+			{
+				GLfloat angle = 2.0f*3.14159265f*k/views;
+				Vector3 eye = center+Vector3(cosf(angle), 0.3f, sinf(angle))*
+					(distances[d]*radius);
+				Matrix4 projection;
+				projection.Perspective(60.0f, 1.0f, 0.01f*radius, 
+					10.0f*radius);
+				Matrix4 mvp = projection*LookAt(eye, center, 
+					Vector3(0.0f, 1.0f, 0.0f));
+
+				sf::Clock timer;
+				MeshletCullStats stats = mesh->CullMeshlets(mvp, eye, 
+					windings[m]);
+				time += timer.getElapsedTime().asSeconds();
+				total.Add(stats);
+
+				//Every triangle of a culled meshlet must be outside one 
+				//plane of the frustum or face away from the camera
+				Frustum frustum(mvp);
+				for(GLuint i = 0; good && i < mesh->g.size(); i++)
+				{
+					const TriangleGroup &grp = mesh->g[i];
+					for(GLuint l = 0; good && l < grp.meshlets.size(); l++)
+					{
+						const Meshlet &ml = grp.meshlets[l];
+						GLboolean outside = !frustum.Intersects(ml.center, 
+							ml.radius);
+						if(!outside && !ml.Backfacing(eye, windings[m])) 
+							continue;
+
+						const GLuint *tri = &grp.indices[ml.indexOffset];
+						for(GLuint t = 0; good && t < ml.triangleCount; 
+								t++, tri += 3)
+						{
+							const Vector3 &a = v[tri[0]], &b = v[tri[1]];
+							const Vector3 &c = v[tri[2]];
+							if(!outside)
+							{
+								Vector3 n = (a-c).CrossProduct(b-c);
+								if(windings[m] == GL_CW) n = -n;
+								good = n*(a-eye) >= 
+									-1e-4f*n.Length()*(a-eye).Length();
+								continue;
+							}
+							good = false;
+							for(GLuint p = 0; !good && p < 6; p++)
+							{
+								const Vector3 &q = frustum.planes[p];
+								good = (q*a+q.w < 0.0f && q*b+q.w < 0.0f && 
+									q*c+q.w < 0.0f);
+							}
+						}
+					}
+				}
+			}
+			status = status && good;
+
+			GLfloat percent = (total.triangles > 0) ? 
+				(100.0f*total.culledTriangles)/total.triangles : 0.0f;
+			cout << left << setw(14) << (d == 0 ? "  far" : "  near") << 
+				": " << total.frustumCulled/views << " outside, " << 
+				total.backfaceCulled/views << " back facing, " << percent <<
+				"% of the triangles culled, " << time*1e6f/views << 
+				" us/view  " << (good ? "ok" : "WRONG") << endl;
+		}
+		delete mesh;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::MeshSimplify(const string &filename)
+{
+	cout << "LEVEL OF DETAIL SIMPLIFICATION (" << filename << ")" << endl;
+
+	vector<string> names;
+	vector<Mesh*> meshes;
+	Mesh *mesh = new Mesh();
+	if(mesh->Open(filename, MESH_LOAD_PARALLEL))
+	{
+		names.push_back(filename);
+		meshes.push_back(mesh);
+	}
+	else
+	{
+		cerr << "Could not open " << filename << endl;
+		delete mesh;
+	}
+	mesh = new Mesh();
+	Sphere(512, 1024, *mesh);
+	names.push_back("sphere");
+	meshes.push_back(mesh);
+
+	GLboolean status = true;
+	for(GLuint m = 0; m < meshes.size(); m++)
+	{
+		mesh = meshes[m];
+		GLfloat best = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			sf::Clock timer;
+			mesh->BuildLods();
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < best) best = time;
+		}
+
+		size_t triangles = 0;
+		for(GLuint i = 0; i < mesh->g.size(); i++)
+			triangles += mesh->g[i].indices.size()/3;
+		cout << names[m] << ": " << triangles << " triangles, " << 
+			mesh->g.size() << " groups, " << best*1000.0f << 
+			" ms to build" << endl;
+
+		//Every level must be a triangle list of real triangles, and every
+		//border edge of a group must still be there
+		GLfloat radius = mesh->bounds.Size().Length()*0.5f;
+		for(GLuint l = 1; l < MESH_LOD_COUNT; l++)
+		{
+			size_t count = 0;
+			GLboolean good = true;
+			for(GLuint i = 0; i < mesh->g.size(); i++)
+			{
+				const TriangleGroup &grp = mesh->g[i];
+				if(grp.lods.size() < 2*l) {good = false; break;}
+				const GLuint *lod = grp.lodIndices.empty() ? NULL : 
+					&grp.lodIndices.front()+grp.lods[2*l-2]-grp.indices.size();
+				GLsizei size = grp.lods[2*l-1];
+				count += size/3;
+				good = good && (size%3 == 0);
+
+				vector<uint64_t> edges, border;
+				for(GLsizei t = 0; good && t+2 < size; t += 3)
+				{
+					for(GLuint c = 0; c < 3; c++)
+					{
+						GLuint a = lod[t+c], b = lod[t+(c+1)%3];
+						good = good && a < mesh->numVerts && a != b;
+						edges.push_back(((uint64_t)a<<32) | b);
+					}
+				}
+				const vector<GLuint> &full = grp.indices;
+				for(size_t t = 0; t+2 < full.size(); t += 3)
+				{
+					for(GLuint c = 0; c < 3; c++)
+					{
+						GLuint a = full[t+c], b = full[t+(c+1)%3];
+						border.push_back(((uint64_t)a<<32) | b);
+					}
+				}
+				sort(edges.begin(), edges.end());
+				sort(border.begin(), border.end());
+				for(size_t e = 0; good && e < border.size(); e++)
+				{
+					uint64_t twin = (border[e]<<32) | (border[e]>>32);
+					if(binary_search(border.begin(), border.end(), twin)) 
+						continue;
+					good = binary_search(edges.begin(), edges.end(), border[e]);
+				}
+			}
+			status = status && good;
+
+			ostringstream level;
+			level << "  lod " << l;
+			cout << left << setw(14) << level.str() << ": " << count << 
+				" triangles (" << (triangles ? (100.0f*count)/triangles : 
+				0.0f) << "%), error " << mesh->lodErrors[l] << " (" << 
+				(radius > 0.0f ? 100.0f*mesh->lodErrors[l]/radius : 0.0f) <<
+				"% of the radius)  " << (good ? "ok" : "WRONG") << endl;
+		}
+		delete mesh;
+	}
+
+	return(status);
+}
+
+GLboolean Benchmark::InstancedDraw()
+{
+	cout << "INSTANCED DRAWING" << endl;
+
+	//The context has no window, everything is drawn into a small 
+	//framebuffer object so the time goes to the draw calls, not the pixels
+	sf::Context context(sf::ContextSettings(24, 8, 0, 3, 3), 64, 64);
+	if(glewInit() != GLEW_OK || !GLEW_VERSION_3_3)
+	{
+		cout << "skipped, OpenGL 3.3 is not supported" << endl;
+		return(true);
+	}
+
+	//The shadowed state belongs to whichever context was current before
+	GLState::Invalidate();
+	const GLsizei size = 64;
+	GLuint fbo, rbo[2];
+	glGenFramebuffers(1, &fbo);
+	glGenRenderbuffers(2, rbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, rbo[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+	glBindRenderbuffer(GL_RENDERBUFFER, rbo[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 
+		GL_RENDERBUFFER, rbo[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 
+		GL_RENDERBUFFER, rbo[1]);
+	glViewport(0, 0, size, size);
+	GLState::Enable(GL_DEPTH_TEST);
+
+	Shader shader;
+	Mesh mesh;
+	UniformBuffer frame;
+	GLboolean status = shader.Open("ft.glsl");
+	if(!status) cerr << "Could not open ft.glsl " << shader.errString << endl;
+	GLint modelUniform = shader.Uniform("model");
+	GLint instancedUniform = shader.Uniform("instanced");
+	shader.BindUniformBlock("Frame", UNIFORM_BLOCK_FRAME);
+	shader.BindUniformBlock("Material", UNIFORM_BLOCK_MATERIAL);
+	GLState::UseProgram(shader.program);
+	shader.SetUniformMatrix(shader.Uniform("normalmatrix"), Matrix4().mat);
+
+	//A small asset, 64 triangles
+	Sphere(4, 8, mesh);
+	mesh.CalculateNormals();
+	mesh.CreateBufferObjects();
+	GLfloat spacing = 1.5f*mesh.bounds.Size().x;
+
+	GLuint counts[3] = {10000, 30000, 100000};
+	for(GLuint c = 0; status && c < 3; c++)
+	{
+		//The copies fill the view, the camera stays at the origin
+		GLuint count = counts[c];
+		GLfloat side = ceilf(sqrtf((GLfloat)count))*spacing;
+		InstanceBuffer instances;
+		instances.Resize(count);
+		instances.FillGrid(Vector3(0.0f, 0.0f, -side), spacing);
+		instances.Upload();
+		mesh.AttachInstances(instances);
+
+		Std140 block;
+		Matrix4 projection, view;
+		projection.Perspective(60.0f, 1.0f, 0.1f, 2.0f*side);
+		block.AddMat4(projection.mat);
+		block.AddMat4(view.mat);
+		frame.Create(block.Size(), &block.data.front(), GL_STATIC_DRAW);
+		frame.BindBase(UNIFORM_BLOCK_FRAME);
+
+		//One draw per copy, with the copy's model matrix as a uniform
+		vector<GLubyte> single(4*size*size), instanced(4*size*size);
+		GLfloat singleTime = 0.0f, instancedTime = 0.0f;
+		shader.SetUniform(instancedUniform, 0);
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			sf::Clock timer;
+			for(GLuint i = 0; i < count; i++)
+			{
+				shader.SetUniformMatrix(modelUniform, 
+					instances.instances[i].model.m);
+				mesh.Draw();
+			}
+			glFinish();
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < singleTime) singleTime = time;
+		}
+		glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, 
+			&single.front());
+
+		shader.SetUniform(instancedUniform, 1);
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			sf::Clock timer;
+			mesh.DrawInstanced(count);
+			glFinish();
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < instancedTime) instancedTime = time;
+		}
+		glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, 
+			&instanced.front());
+
+		//Both ways run the same vertex shader math, only a few pixels on
+		//the edges of triangles may differ
+		GLuint different = 0;
+		for(GLuint p = 0; p < single.size(); p += 4)
+			if(memcmp(&single[p], &instanced[p], 4) != 0) different++;
+		GLboolean good = (different <= size*size/100);
+		status = status && good;
+
+		ostringstream label;
+		label << count << " copies";
+		cout << left << setw(14) << label.str() << ": " << 
+			singleTime*1000.0f << " ms with " << count*mesh.g.size() << 
+			" draws, " << instancedTime*1000.0f << " ms instanced with " << 
+			mesh.g.size() << " draws (" << singleTime/instancedTime << 
+			"x)  " << (good ? "ok" : "DIFFERENT") << endl;
+
+		//Every 100th copy moves, then a block of 1% of the copies does
+		GLfloat scatteredTime = 0.0f, blockTime = 0.0f;
+		GLsizeiptr scattered = 0, block1 = 0;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			for(GLuint i = 0; i < count; i += 100)
+			{
+				instances.instances[i].model.m[12] += 0.01f;
+				instances.MarkDirty(i, 1);
+			}
+			sf::Clock timer;
+			scattered = instances.Upload();
+			glFinish();
+			GLfloat time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < scatteredTime) scatteredTime = time;
+
+			for(GLuint i = 0; i < count/100; i++)
+				instances.instances[i].model.m[13] += 0.01f;
+			instances.MarkDirty(0, count/100);
+			timer.restart();
+			block1 = instances.Upload();
+			glFinish();
+			time = timer.getElapsedTime().asSeconds();
+			if(r == 0 || time < blockTime) blockTime = time;
+		}
+		cout << left << setw(14) << "  update 1%" << ": " << 
+			scattered/1024 << " KB scattered in " << scatteredTime*1000.0f <<
+			" ms, " << block1/1024 << " KB in a block in " << 
+			blockTime*1000.0f << " ms, of " << 
+			count*sizeof(MeshInstance)/1024 << " KB" << endl;
+	}
+
+	GLState::UseProgram(0);
+	mesh.Close();
+	shader.Close();
+	frame.Close();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteRenderbuffers(2, rbo);
+	glDeleteFramebuffers(1, &fbo);
+	GLState::Invalidate();
+	return(status);
+}
+
+//Orders sort entries by their keys only
+static bool KeyLess(const RenderSortEntry &a, const RenderSortEntry &b)
+{
+	return(a.key < b.key);
+}
+
+GLboolean Benchmark::RenderQueueSort()
+{
+	cout << "RENDER QUEUE" << endl;
+
+	//A scene of 256 meshes with one to four groups each, which use 64
+	//shared materials. Nothing is drawn, so the meshes have no buffers.
+	const GLuint numMeshes = 256, numMaterials = 64, numShaders = 4;
+	vector<Material> library(numMaterials);
+	vector<Mesh> meshes(numMeshes);
+	vector<Shader> shaders(numShaders);
+	uint32_t seed = 12345;
+	for(GLuint m = 0; m < numMeshes; m++)
+	{
+		seed = seed*1664525u+1013904223u;
+		meshes[m].g.resize(1+(seed>>16)%4);
+		for(GLuint i = 0; i < meshes[m].g.size(); i++)
+		{
+			seed = seed*1664525u+1013904223u;
+			meshes[m].materials.push_back(&library[(seed>>16)%numMaterials]);
+			meshes[m].g[i].mtl = i;
+		}
+	}
+
+	//Objects placed at random, one in ten is transparent and drawn back to
+	//front after the others
+	RenderQueue queue;
+	Matrix4 identity;
+	for(GLuint o = 0; o < 5000; o++)
+	{
+		GLuint r[4];
+		for(GLuint k = 0; k < 4; k++)
+		{
+			seed = seed*1664525u+1013904223u;
+			r[k] = seed>>16;
+		}
+		GLuint m = r[0]%numMeshes, shader = r[1]%numShaders;
+		GLuint pass = (r[2]%10 == 0) ? 1 : 0;
+		GLfloat depth = (r[3]%65536)/65536.0f;
+		GLuint transform = queue.AddTransform(identity, identity);
+		for(GLuint i = 0; i < meshes[m].g.size(); i++)
+		{
+			const Material *mtl = meshes[m].materials[i];
+			uint64_t key = RenderQueue::Key(pass, shader, mtl-&library[0], 
+				m, pass ? 1.0f-depth : depth);
+			queue.Submit(key, &shaders[shader], &meshes[m], i, transform);
+		}
+	}
+	RenderQueueStats unsorted = queue.Simulate();
+
+	//Both sorts start from submission order every run
+	vector<RenderSortEntry> submitted = queue.order, sorted;
+	GLfloat radixTime = 0.0f, stdTime = 0.0f;
+	for(GLuint r = 0; r < RUNS; r++)
+	{
+		queue.order = submitted;
+		sf::Clock timer;
+		queue.Sort();
+		GLfloat time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < radixTime) radixTime = time;
+
+		sorted = submitted;
+		timer.restart();
+		stable_sort(sorted.begin(), sorted.end(), KeyLess);
+		time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < stdTime) stdTime = time;
+	}
+	GLboolean same = true;
+	for(size_t i = 0; same && i < sorted.size(); i++)
+		same = (sorted[i].item == queue.order[i].item);
+	RenderQueueStats stats = queue.Simulate();
+
+	cout << left << setw(14) << "sort" << ": " << queue.items.size() << 
+		" items, radix " << radixTime*1000.0f << " ms, std::stable_sort " <<
+		stdTime*1000.0f << " ms (" << stdTime/radixTime << "x)  " << 
+		(same ? "ok" : "DIFFERENT") << endl;
+	cout << left << setw(14) << "submitted" << ": " << unsorted.Changes() <<
+		" changes, " << unsorted.programChanges << " programs, " << 
+		unsorted.materialChanges << " materials, " << unsorted.vaoChanges <<
+		" vertex arrays, " << unsorted.transformChanges << " transforms" <<
+		endl;
+	cout << left << setw(14) << "sorted" << ": " << stats.Changes() << 
+		" changes, " << stats.programChanges << " programs, " << 
+		stats.materialChanges << " materials, " << stats.vaoChanges << 
+		" vertex arrays, " << stats.transformChanges << " transforms" << 
+		endl;
+
+	return(same);
+}
+
+GLboolean Benchmark::StreamUpload()
+{
+	cout << "STREAMING" << endl;
+
+	sf::Context context(sf::ContextSettings(24, 8, 0, 3, 3), 64, 64);
+	if(glewInit() != GLEW_OK || !GLEW_VERSION_3_3)
+	{
+		cout << "skipped, OpenGL 3.3 is not supported" << endl;
+		return(true);
+	}
+	GLState::Invalidate();
+
+	//Every frame streams the transforms of 20000 instances, which the GPU
+	//then reads by copying them to another buffer
+	const GLuint count = 20000, frames = 200;
+	const GLsizeiptr frameSize = count*sizeof(MeshInstance);
+	vector<MeshInstance> data(count), copied(count);
+	GLuint target;
+	glGenBuffers(1, &target);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+	glBufferData(GL_COPY_WRITE_BUFFER, frameSize, NULL, GL_STATIC_DRAW);
+
+	const char *names[3] = {"glBufferSubData", "orphaned", "persistent"};
+	GLboolean status = true;
+	for(GLuint m = 0; m < 3; m++)
+	{
+		if(m == 2 && !GLEW_ARB_buffer_storage)
+		{
+			cout << left << setw(14) << names[m] << 
+				": skipped, GL_ARB_buffer_storage is not supported" << endl;
+			continue;
+		}
+
+		//The first way updates one buffer in place, and the driver has to
+		//wait for the GPU or copy the data each frame
+		GLuint single = 0;
+		StreamBuffer stream;
+		if(m == 0)
+		{
+			glGenBuffers(1, &single);
+			GLState::BindBuffer(GL_ARRAY_BUFFER, single);
+			glBufferData(GL_ARRAY_BUFFER, frameSize, NULL, GL_DYNAMIC_DRAW);
+		}
+		else if(!stream.Create(GL_ARRAY_BUFFER, frameSize, m == 2))
+		{
+			cout << left << setw(14) << names[m] << ": could not map" << 
+				endl;
+			status = false;
+			continue;
+		}
+
+		size_t waits = 0;
+		GLfloat waitTime = 0.0f;
+		sf::Clock timer;
+		for(GLuint f = 0; f < frames; f++)
+		{
+			for(GLuint i = 0; i < count; i++)
+				data[i].model.m[12] = (GLfloat)(f+i);
+
+			GLuint source = single;
+			GLintptr offset = 0;
+			if(m == 0)
+			{
+				GLState::BindBuffer(GL_ARRAY_BUFFER, single);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, frameSize, &data.front());
+			}
+			else
+			{
+				GLvoid *p = stream.Map(frameSize, sizeof(GLfloat), offset);
+				memcpy(p, &data.front(), frameSize);
+				stream.Unmap();
+				source = stream.buffer;
+			}
+			glBindBuffer(GL_COPY_READ_BUFFER, source);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+				offset, 0, frameSize);
+			if(m != 0)
+			{
+				stream.EndFrame();
+				waits += stream.lastFrame.waits;
+				waitTime += stream.lastFrame.waitTime;
+			}
+		}
+		glFinish();
+		GLfloat time = timer.getElapsedTime().asSeconds();
+
+		//The target must hold the last frame
+		glGetBufferSubData(GL_COPY_WRITE_BUFFER, 0, frameSize, 
+			&copied.front());
+		GLboolean good = (memcmp(&copied.front(), &data.front(), 
+			frameSize) == 0);
+		status = status && good;
+
+		cout << left << setw(14) << names[m] << ": " << 
+			time*1000.0f/frames << " ms per frame, " << 
+			(frames*frameSize/(1024.0f*1024.0f))/time << " MB/s, " << 
+			waits << " fence waits (" << waitTime << " ms)  " << 
+			(good ? "ok" : "WRONG") << endl;
+
+		if(single != 0) GLState::DeleteBuffers(1, &single);
+		stream.Close();
+	}
+
+	glDeleteBuffers(1, &target);
+	GLState::Invalidate();
+	return(status);
+}
+
+//The box test of Frustum as a loop over the planes, one at a time
+static GLboolean BoxInFrustum(const Frustum &frustum, const BoundingBox &box)
+{
+	if(box.Empty()) return(false);
+	Vector3 c = box.Center(), e = box.Size()*0.5f;
+	for(GLuint i = 0; i < 6; i++)
+	{
+		const Vector3 &p = frustum.planes[i];
+		GLfloat d = p.x*c.x+p.y*c.y+p.z*c.z+p.w;
+		GLfloat r = fabsf(p.x)*e.x+fabsf(p.y)*e.y+fabsf(p.z)*e.z;
+		if(d+r < 0.0f) return(false);
+	}
+	return(true);
+}
+
+//Builds an assembly of side*side*side small spheres, each a group of its
+//own, on a grid centered on the origin
+static GLvoid Assembly(GLuint side, GLfloat spacing, Mesh &mesh)
+{
+	Mesh part;
+	Sphere(4, 8, part);
+	mesh.v.clear();
+	mesh.g.clear();
+	mesh.g.resize(side*side*side);
+	GLfloat start = -0.5f*(side-1)*spacing;
+	for(GLuint i = 0; i < mesh.g.size(); i++)
+	{
+		Vector3 offset(start+(i%side)*spacing, start+(i/side%side)*spacing,
+			start+(i/(side*side))*spacing);
+		GLuint first = mesh.v.size();
+		for(GLuint k = 0; k < part.numVerts; k++) 
+			mesh.v.push_back(part.v[k]+offset);
+		const vector<GLuint> &indices = part.g[0].indices;
+		for(GLuint k = 0; k < indices.size(); k++) 
+			mesh.g[i].indices.push_back(first+indices[k]);
+		mesh.g[i].count = indices.size();
+	}
+	mesh.numVerts = mesh.v.size();
+	mesh.CalculateBounds();
+}
+
+GLboolean Benchmark::FrustumCull()
+{
+	cout << "FRUSTUM CULLING" << endl;
+
+	//Random boxes all around a camera at the origin looking down -z
+	const GLuint count = 200000;
+	vector<BoundingBox> boxes(count);
+	uint32_t seed = 12345;
+	for(GLuint i = 0; i < count; i++)
+	{
+		GLfloat f[4];
+		for(GLuint k = 0; k < 4; k++)
+		{
+			seed = seed*1664525u+1013904223u;
+			f[k] = (seed>>8)/(GLfloat)(1<<24);
+		}
+		Vector3 c(f[0]*200.0f-100.0f, f[1]*200.0f-100.0f, 
+			f[2]*200.0f-100.0f);
+		Vector3 e(0.25f+2.0f*f[3], 0.25f+f[3], 0.25f+0.5f*f[3]);
+		boxes[i].Add(c-e);
+		boxes[i].Add(c+e);
+	}
+	Matrix4 projection;
+	projection.Perspective(60.0f, 1.0f, 0.1f, 1000.0f);
+	Frustum frustum(projection);
+
+	vector<GLubyte> scalar(count), simd(count), sphere(count);
+	GLfloat times[3] = {0.0f, 0.0f, 0.0f};
+	for(GLuint r = 0; r < RUNS; r++)
+	{
+		sf::Clock timer;
+		for(GLuint i = 0; i < count; i++) 
+			scalar[i] = BoxInFrustum(frustum, boxes[i]);
+		GLfloat time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < times[0]) times[0] = time;
+
+		timer.restart();
+		for(GLuint i = 0; i < count; i++) 
+			simd[i] = frustum.Intersects(boxes[i]);
+		time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < times[1]) times[1] = time;
+
+		timer.restart();
+		for(GLuint i = 0; i < count; i++) 
+		{
+			sphere[i] = frustum.Intersects(boxes[i].Center(), 
+				boxes[i].Size().Length()*0.5f);
+		}
+		time = timer.getElapsedTime().asSeconds();
+		if(r == 0 || time < times[2]) times[2] = time;
+	}
+	size_t visible[3] = {0, 0, 0};
+	for(GLuint i = 0; i < count; i++) 
+		visible[0] += scalar[i], visible[1] += simd[i], visible[2] += sphere[i];
+	GLboolean same = (scalar == simd);
+
+	const char *names[3] = {"box scalar", "box simd", "sphere"};
+	for(GLuint k = 0; k < 3; k++)
+	{
+		cout << left << setw(14) << names[k] << ": " << count << 
+			" boxes in " << times[k]*1000.0f << " ms (" << 
+			times[k]*1.0e9f/count << " ns each), " << visible[k] << 
+			" visible";
+		if(k == 1) cout << "  " << (same ? "ok" : "DIFFERENT");
+		cout << endl;
+	}
+
+	//An assembly of 4096 parts seen from its center, in six directions
+	Mesh mesh;
+	Assembly(16, 4.0f, mesh);
+	Vector3 targets[6] = {Vector3(1.0f, 0.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f),
+		Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 0.0f, -1.0f), 
+		Vector3(0.3f, 1.0f, 0.0f), Vector3(0.3f, -1.0f, 0.0f)};
+	GroupCullStats total;
+	GLfloat time = 0.0f;
+	for(GLuint k = 0; k < 6; k++)
+	{
+		Matrix4 mvp = projection*LookAt(Vector3(0.0f, 0.0f, 0.0f), 
+			targets[k], Vector3(0.0f, 1.0f, 0.0f));
+		GroupCullStats stats;
+		GLfloat best = 0.0f;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			sf::Clock timer;
+			stats = mesh.CullGroups(mvp);
+			GLfloat t = timer.getElapsedTime().asSeconds();
+			if(r == 0 || t < best) best = t;
+		}
+		time += best;
+		total.groups += stats.groups;
+		total.triangles += stats.triangles;
+		total.culledGroups += stats.culledGroups;
+		total.culledTriangles += stats.culledTriangles;
+	}
+	cout << left << setw(14) << "assembly" << ": " << total.groups/6 << 
+		" groups, " << (100.0f*total.culledGroups)/total.groups << 
+		"% of the groups and " << 
+		(100.0f*total.culledTriangles)/total.triangles << 
+		"% of the triangles culled per view in " << time*1.0e6f/6 << 
+		" us" << endl;
+
+	return(same);
+}
+
+//Checks if a box at depth beyond the wall projects inside the rectangle
+//of the wall, seen from the origin looking down -z
+static GLboolean BehindWall(const BoundingBox &box, GLfloat wallZ, 
+		GLfloat x0, GLfloat x1, GLfloat y0, GLfloat y1)
+{
+	for(GLuint k = 0; k < 8; k++)
+	{
+		Vector3 p((k & 1) ? box.max.x : box.min.x,
+			(k & 2) ? box.max.y : box.min.y, (k & 4) ? box.max.z : box.min.z);
+		if(p.z >= wallZ) return(false);
+		GLfloat x = p.x*wallZ/p.z, y = p.y*wallZ/p.z;
+		if(x < x0 || x > x1 || y < y0 || y > y1) return(false);
+	}
+	return(true);
+}
+
+//Adds a quad as two triangles, wound counterclockwise around the normal
+static GLvoid Quad(Mesh &mesh, GLuint a, GLuint b, GLuint c, GLuint d,
+		const Vector3 &normal)
+{
+	vector<GLuint> &indices = mesh.g[0].indices;
+	GLuint tris[6] = {a, b, c, a, c, d};
+	for(GLuint t = 0; t < 6; t += 3)
+	{
+		const Vector3 &p = mesh.v[tris[t]], &q = mesh.v[tris[t+1]];
+		const Vector3 &r = mesh.v[tris[t+2]];
+		if((q-p).CrossProduct(r-p)*normal < 0.0f) swap(tris[t+1], tris[t+2]);
+		indices.insert(indices.end(), tris+t, tris+t+3);
+	}
+}
+
+//Builds a ring facing +z, 20 units across and 1 unit thick, with a hole
+//of radius 3, and 8 small boxes behind it seen through the hole. 
+//Simplifying the ring shrinks the hole and covers the boxes.
+static GLvoid Ring(Mesh &ring, vector<BoundingBox> &boxes)
+{
+	//The outer and the inner circle of the front, then of the back
+	const GLuint segments = 32;
+	ring.v.clear();
+	for(GLuint k = 0; k < 4; k++)
+	{
+		GLfloat radius = (k%2 == 0) ? 10.0f : 3.0f;
+		for(GLuint j = 0; j < segments; j++)
+		{
+			GLfloat phi = 2.0f*3.14159265f*j/segments;
+			ring.v.push_back(Vector3(radius*cosf(phi), radius*sinf(phi),
+				(k < 2) ? 0.0f : -1.0f));
+		}
+	}
+	ring.numVerts = ring.v.size();
+	ring.g.resize(1);
+	ring.g[0].indices.clear();
+	for(GLuint j = 0; j < segments; j++)
+	{
+		GLuint n = (j+1)%segments;
+		GLfloat phi = 2.0f*3.14159265f*(j+0.5f)/segments;
+		Vector3 out(cosf(phi), sinf(phi), 0.0f), in(-out.x, -out.y, 0.0f);
+		GLuint fo = 0, fi = segments, bo = 2*segments, bi = 3*segments;
+		Quad(ring, fo+j, fo+n, fi+n, fi+j, Vector3(0.0f, 0.0f, 1.0f));
+		Quad(ring, bo+j, bo+n, bi+n, bi+j, Vector3(0.0f, 0.0f, -1.0f));
+		Quad(ring, fo+j, fo+n, bo+n, bo+j, out);
+		Quad(ring, fi+j, fi+n, bi+n, bi+j, in);
+	}
+	ring.g[0].count = ring.g[0].indices.size();
+	ring.CalculateBounds();
+
+	boxes.clear();
+	for(GLuint j = 0; j < 8; j++)
+	{
+		GLfloat phi = 2.0f*3.14159265f*j/8;
+		Vector3 c(2.2f*cosf(phi), 2.2f*sinf(phi), -5.0f);
+		BoundingBox box;
+		box.Add(c-Vector3(0.2f, 0.2f, 0.2f));
+		box.Add(c+Vector3(0.2f, 0.2f, 0.2f));
+		boxes.push_back(box);
+	}
+}
+
+GLboolean Benchmark::OcclusionCull()
+{
+	cout << "OCCLUSION CULLING" << endl;
+
+	//A wall hides most of an assembly of 4096 parts from a camera at the 
+	//origin looking down -z
+	const GLfloat wallZ = -20.0f, x0 = -12.0f, x1 = 6.0f, y0 = -8.0f;
+	const GLfloat y1 = 8.0f, depth = -60.0f;
+	Mesh wall;
+	wall.v.push_back(Vector3(x0, y0, wallZ));
+	wall.v.push_back(Vector3(x1, y0, wallZ));
+	wall.v.push_back(Vector3(x1, y1, wallZ));
+	wall.v.push_back(Vector3(x0, y1, wallZ));
+	wall.numVerts = wall.v.size();
+	wall.g.resize(1);
+	GLuint quad[6] = {0, 1, 2, 0, 2, 3};
+	wall.g[0].indices.assign(quad, quad+6);
+	wall.g[0].count = 6;
+	wall.CalculateBounds();
+
+	Mesh mesh;
+	Assembly(16, 4.0f, mesh);
+	Matrix4 projection, model;
+	projection.Perspective(60.0f, (GLfloat)OCCLUSION_WIDTH/OCCLUSION_HEIGHT,
+		0.1f, 1000.0f);
+	model.Translate(0.0f, 0.0f, depth);
+	Matrix4 mvp = projection*model;
+
+	//The same depth buffer on one thread and on all of them, with every
+	//part as an occluder
+	OcclusionCuller culler;
+	GLuint processors = Parallel::ThreadCount();
+	vector<GLfloat> single;
+	GLfloat rasterTimes[2] = {0.0f, 0.0f};
+	for(GLuint t = 0; t < 2; t++)
+	{
+		Parallel::maxThreads = (t == 0) ? 1 : 0;
+		for(GLuint r = 0; r < RUNS; r++)
+		{
+			culler.Clear();
+			mesh.AddOccluders(culler, mvp, 0.0f, (size_t)-1);
+			culler.Rasterize();
+			if(r == 0 || culler.stats.rasterTime < rasterTimes[t]) 
+				rasterTimes[t] = culler.stats.rasterTime;
+		}
+		if(t == 0) single = culler.levels[0];
+	}
+	Parallel::maxThreads = 0;
+	GLboolean same = (single == culler.levels[0]);
+	cout << left << setw(14) << "rasterize" << ": " << 
+		culler.stats.occluderTriangles << " triangles into " << 
+		culler.width << "x" << culler.height << " in " << rasterTimes[0] << 
+		" us on 1 thread, " << rasterTimes[1] << " us on " << processors <<
+		" (" << rasterTimes[0]/rasterTimes[1] << "x)  " << 
+		(same ? "ok" : "DIFFERENT") << endl;
+
+	//By default only the nearest parts in the view are large enough, a 
+	//smaller budget cuts them off
+	const size_t small = 4096;
+	mesh.CullGroups(mvp);
+	culler.Clear();
+	mesh.AddOccluders(culler, mvp);
+	culler.Rasterize();
+	size_t selected = culler.stats.occluderTriangles;
+	GLfloat selectTime = culler.stats.rasterTime;
+	culler.Clear();
+	mesh.AddOccluders(culler, mvp, MESH_OCCLUDER_MIN_SIZE, small);
+	GLboolean budget = (selected <= MESH_OCCLUDER_TRIANGLES && 
+		culler.triangles.size()/9 <= small);
+	cout << left << setw(14) << "selected" << ": " << selected << 
+		" triangles of at least " << MESH_OCCLUDER_MIN_SIZE << " pixels in "
+		<< selectTime << " us, " << culler.triangles.size()/9 << 
+		" with a budget of " << small << "  " << (budget ? "ok" : "OVER") <<
+		endl;
+
+	//Only the wall hides the parts, so the parts it hides are known.
+	//Every group is tested, none is outside the frustum. The wall is 
+	//grown by a pixel for the check, occluders are sampled at pixel 
+	//centers.
+	culler.Clear();
+	wall.AddOccluders(culler, projection);
+	culler.Rasterize();
+	GLfloat pixel = 2.0f*(-wallZ)*tanf(30.0f*3.14159265f/180.0f)/
+		OCCLUSION_HEIGHT;
+	GLfloat testTime = 0.0f;
+	size_t hidden = 0;
+	for(GLuint r = 0; r < RUNS; r++)
+	{
+		for(GLuint i = 0; i < mesh.g.size(); i++) mesh.g[i].visible = true;
+		culler.stats.testTime = 0.0f;
+		hidden = mesh.CullOccluded(culler, mvp);
+		if(r == 0 || culler.stats.testTime < testTime) 
+			testTime = culler.stats.testTime;
+	}
+	size_t behind = 0, wrong = 0, triangles = 0;
+	for(GLuint i = 0; i < mesh.g.size(); i++)
+	{
+		BoundingBox box;
+		box.Add(mesh.g[i].bounds.min+Vector3(0.0f, 0.0f, depth));
+		box.Add(mesh.g[i].bounds.max+Vector3(0.0f, 0.0f, depth));
+		triangles += mesh.g[i].count/3;
+		if(BehindWall(box, wallZ, x0, x1, y0, y1)) behind++;
+		if(!mesh.g[i].visible && !BehindWall(box, wallZ, x0-pixel, 
+				x1+pixel, y0-pixel, y1+pixel)) 
+			wrong++;
+	}
+	cout << left << setw(14) << "test" << ": " << mesh.g.size() << 
+		" groups in " << testTime << " us, " << hidden << " occluded of " <<
+		behind << " behind the wall, " << 
+		culler.stats.occludedTriangles/RUNS << " of " << triangles << 
+		" triangles  " << (wrong == 0 ? "ok" : "WRONG") << endl;
+
+	//With clockwise front faces the wall faces away, GL would cull it and
+	//it must hide nothing
+	culler.Clear();
+	wall.AddOccluders(culler, projection, 0.0f, (size_t)-1, GL_CW);
+	GLboolean backFaces = culler.triangles.empty();
+	cout << left << setw(14) << "back faces" << ": " << 
+		culler.triangles.size()/9 << " of " << wall.g[0].count/3 << 
+		" wall triangles kept with clockwise front faces  " << 
+		(backFaces ? "ok" : "WRONG") << endl;
+
+	//The boxes behind the hole can be seen up close, where the coarse 
+	//levels of the ring are many pixels off and must not be used. Far 
+	//away the levels are used, the boxes are smaller than a pixel there.
+	Mesh ring;
+	vector<BoundingBox> boxes;
+	Ring(ring, boxes);
+	ring.BuildLods();
+	size_t culled = 0, occluders[2] = {0, 0};
+	for(GLuint t = 0; t < 2; t++)
+	{
+		Matrix4 placed;
+		placed.Translate(0.0f, 0.0f, (t == 0) ? -20.0f : -200.0f);
+		Matrix4 m = projection*placed;
+		culler.Clear();
+		ring.AddOccluders(culler, m);
+		culler.Rasterize();
+		occluders[t] = culler.stats.occluderTriangles;
+		for(GLuint i = 0; t == 0 && i < boxes.size(); i++)
+			if(culler.Occluded(m, boxes[i])) culled++;
+	}
+	cout << left << setw(14) << "lod occluders" << ": " << occluders[0] <<
+		" of " << ring.g[0].count/3 << " triangles near, " << 
+		occluders[1] << " far, " << culled << " of " << boxes.size() << 
+		" boxes behind the hole culled  " << (culled == 0 ? "ok" : "WRONG") 
+		<< endl;
+
+	return(same && budget && wrong == 0 && backFaces && culled == 0);
+}
@@ -0,0 +1,139 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cfloat>
+#include <cmath>
+#include <sstream>
+
+#include <Bounds.h>
+#include <Simd.h>
+
+using namespace std;
+
+BoundingBox::BoundingBox()
+{
+	Reset();
+}
+
+GLvoid BoundingBox::Reset()
+{
+	min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+GLvoid BoundingBox::Add(const Vector3 &p)
+{
+	if(p.x < min.x) min.x = p.x;
+	if(p.y < min.y) min.y = p.y;
+	if(p.z < min.z) min.z = p.z;
+	if(p.x > max.x) max.x = p.x;
+	if(p.y > max.y) max.y = p.y;
+	if(p.z > max.z) max.z = p.z;
+}
+
+GLvoid BoundingBox::Add(const BoundingBox &b)
+{
+	if(b.Empty()) return;
+	Add(b.min);
+	Add(b.max);
+}
+
+GLboolean BoundingBox::Empty() const
+{
+	return(min.x > max.x);
+}
+
+Vector3 BoundingBox::Center() const
+{
+	return((min+max)*0.5f);
+}
+
+Vector3 BoundingBox::Size() const
+{
+	return(max-min);
+}
+
+const string BoundingBox::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s<<"min: "<<min.ToString()<<endl<<"max: "<<max.ToString();
+	return(s.str());
+}
+
+BoundingSphere::BoundingSphere()
+{
+	radius = -1.0f;
+}
+
+GLboolean BoundingSphere::Empty() const
+{
+	return(radius < 0.0f);
+}
+
+Frustum::Frustum()
+{
+	for(GLuint i = 0; i < 6; i++) planes[i] = Vector3(0.0f, 0.0f, 0.0f, 1.0f);
+	Transpose();
+}
+
+Frustum::Frustum(const Matrix4 &m)
+{
+	//A point is inside when -w <= x, y, z <= w in clip space, so each plane
+	//is the fourth row of the matrix plus or minus one of the others
+	const GLfloat *a = m.mat;
+	for(GLuint i = 0; i < 6; i++)
+	{
+		GLuint row = i/2;
+		GLfloat sign = (i%2 == 0) ? 1.0f : -1.0f;
+		Vector3 p(a[3]+sign*a[row], a[7]+sign*a[4+row], 
+			a[11]+sign*a[8+row], a[15]+sign*a[12+row]);
+
+		GLfloat l = sqrtf(p.x*p.x+p.y*p.y+p.z*p.z);
+		if(l > 0.0f) p = Vector3(p.x/l, p.y/l, p.z/l, p.w/l);
+		planes[i] = p;
+	}
+	Transpose();
+}
+
+GLvoid Frustum::Transpose()
+{
+	for(GLuint i = 0; i < 8; i++)
+	{
+		Vector3 p = (i < 6) ? planes[i] : Vector3(0.0f, 0.0f, 0.0f, 1.0f);
+		soa[0][i] = p.x, soa[1][i] = p.y, soa[2][i] = p.z, soa[3][i] = p.w;
+	}
+}
+
+GLboolean Frustum::Intersects(const Vector3 &center, GLfloat radius) const
+{
+	for(GLuint i = 0; i < 6; i++)
+	{
+		const Vector3 &p = planes[i];
+		if(p.x*center.x+p.y*center.y+p.z*center.z+p.w < -radius) 
+			return(false);
+	}
+	return(true);
+}
+
+GLboolean Frustum::Intersects(const BoundingBox &box) const
+{
+	if(box.Empty()) return(false);
+
+	//The corner furthest along a plane's normal is the last to leave, its
+	//distance is the center's distance plus |n|.e, e being half the size
+	Vector3 c = box.Center(), e = box.Size()*0.5f;
+	Simd4 cx = Simd::Splat(c.x), cy = Simd::Splat(c.y), cz = Simd::Splat(c.z);
+	Simd4 ex = Simd::Splat(e.x), ey = Simd::Splat(e.y), ez = Simd::Splat(e.z);
+	for(GLuint i = 0; i < 8; i += 4)
+	{
+		Simd4 nx = Simd::Load(&soa[0][i]), ny = Simd::Load(&soa[1][i]);
+		Simd4 nz = Simd::Load(&soa[2][i]), w = Simd::Load(&soa[3][i]);
+		Simd4 d = Simd::Add(Simd::Add(Simd::Add(Simd::Mul(nx, cx), 
+			Simd::Mul(ny, cy)), Simd::Mul(nz, cz)), w);
+		Simd4 r = Simd::Add(Simd::Add(Simd::Mul(Simd::Abs(nx), ex), 
+			Simd::Mul(Simd::Abs(ny), ey)), Simd::Mul(Simd::Abs(nz), ez));
+		if(Simd::AnyNegative(Simd::Add(d, r))) return(false);
+	}
+	return(true);
+}
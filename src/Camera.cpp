@@ -0,0 +1,51 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <Camera.h>
+
+Camera::Camera()
+	: position(0.0f, 0.0f, 0.0f), yaw(0.0f), pitch(0.0f)
+{
+}
+
+GLvoid Camera::Yaw(GLfloat angle)
+{
+	//Keep the angle small, so it doesn't lose precision over time
+	yaw += angle;
+	if(yaw > 180.0f) yaw -= 360.0f;
+	else if(yaw < -180.0f) yaw += 360.0f;
+}
+
+GLvoid Camera::Pitch(GLfloat angle)
+{
+	pitch += angle;
+	if(pitch > 89.0f) pitch = 89.0f;
+	else if(pitch < -89.0f) pitch = -89.0f;
+}
+
+GLvoid Camera::Dolly(GLfloat distance)
+{
+	position += Forward()*distance;
+}
+
+Quaternion Camera::Orientation() const
+{
+	//Pitching around the camera's own x axis happens before turning around
+	//the world's y axis, so the horizon stays level
+	return(Quaternion::FromAxisAngle(Vector3(0.0f, 1.0f, 0.0f), yaw)*
+		Quaternion::FromAxisAngle(Vector3(1.0f, 0.0f, 0.0f), pitch));
+}
+
+Vector3 Camera::Forward() const
+{
+	return(Orientation()*Vector3(0.0f, 0.0f, -1.0f));
+}
+
+Matrix4 Camera::ViewMatrix() const
+{
+	Transform t;
+	t.position = position;
+	t.rotation = Orientation();
+	return(t.InverseMatrix());
+}
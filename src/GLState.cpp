@@ -0,0 +1,363 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#include <GLState.h>
+
+using namespace std;
+
+//A shadow value that isn't known, no OpenGL name or enum has this value
+#define UNKNOWN 0xFFFFFFFF
+
+//The caps tracked by Enable() and Disable()
+#define NUM_CAPS 5
+static const GLenum trackedCaps[NUM_CAPS] = {GL_BLEND, GL_CULL_FACE,
+	GL_DEPTH_TEST, GL_DEPTH_CLAMP, GL_SCISSOR_TEST};
+
+//A range bound to an indexed binding point, size 0 is the whole buffer
+struct ShadowRange {
+	GLuint buffer;
+	GLintptr offset;
+	GLsizeiptr size;
+};
+
+//The last values passed on to OpenGL
+struct Shadow {
+	GLuint program, vao, arrayBuffer, uniformBuffer, activeTexture;
+	GLuint textures[GL_STATE_TEXTURE_UNITS];
+	ShadowRange uniforms[GL_STATE_UNIFORM_BINDINGS];
+	GLuint caps[NUM_CAPS];
+	GLuint blendSrc, blendDst, depthFunc, depthMask, cullFace, frontFace;
+	GLuint polygonMode;
+};
+
+static Shadow Unknown()
+{
+	Shadow s;
+	s.program = UNKNOWN, s.vao = UNKNOWN, s.arrayBuffer = UNKNOWN;
+	s.uniformBuffer = UNKNOWN, s.activeTexture = UNKNOWN;
+	for(GLuint i = 0; i < GL_STATE_TEXTURE_UNITS; i++)
+		s.textures[i] = UNKNOWN;
+	for(GLuint i = 0; i < GL_STATE_UNIFORM_BINDINGS; i++)
+		s.uniforms[i].buffer = UNKNOWN, s.uniforms[i].offset = 0,
+		s.uniforms[i].size = 0;
+	for(GLuint i = 0; i < NUM_CAPS; i++) s.caps[i] = UNKNOWN;
+	s.blendSrc = UNKNOWN, s.blendDst = UNKNOWN, s.depthFunc = UNKNOWN;
+	s.depthMask = UNKNOWN, s.cullFace = UNKNOWN, s.frontFace = UNKNOWN;
+	s.polygonMode = UNKNOWN;
+	return(s);
+}
+
+static Shadow shadow = Unknown();
+
+GLboolean GLState::validate = false;
+GLStateStats GLState::stats;
+
+GLStateStats::GLStateStats()
+{
+	issued = 0, elided = 0, mismatches = 0;
+}
+
+const string GLStateStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	size_t total = issued+elided;
+	GLfloat percent = (total > 0) ? (100.0f*elided)/total : 0.0f;
+	s<<left;
+	s<<setw(15)<<"GL STATE"<<": "<<issued<<" calls issued, "<<elided<<
+		" elided ("<<percent<<"%)";
+	if(mismatches > 0) s<<", "<<mismatches<<" shadow mismatches";
+	return(s.str());
+}
+
+//Counts a call that is passed on without being tracked
+static GLvoid PassOn()
+{
+	if(GLState::validate) GLState::Validate();
+	GLState::stats.issued++;
+}
+
+//Updates a shadow value, returns true if the call has to be made
+static GLboolean Change(GLuint &value, GLuint to)
+{
+	if(GLState::validate) GLState::Validate();
+	if(value == to)
+	{
+		GLState::stats.elided++;
+		return(false);
+	}
+	value = to;
+	GLState::stats.issued++;
+	return(true);
+}
+
+//Returns the index of a tracked cap, or NUM_CAPS
+static GLuint CapIndex(GLenum cap)
+{
+	GLuint i = 0;
+	while(i < NUM_CAPS && trackedCaps[i] != cap) i++;
+	return(i);
+}
+
+//Compares a known shadow value with the value OpenGL reports, and takes
+//OpenGL's value if they differ
+static GLboolean Check(GLuint &value, GLint actual, const char *name)
+{
+	if(value == UNKNOWN || value == (GLuint)actual) return(true);
+	cerr << "GLState: " << name << " is " << actual << ", the shadow has " <<
+		value << endl;
+	GLState::stats.mismatches++;
+	value = actual;
+	return(false);
+}
+
+static GLint Get(GLenum name)
+{
+	GLint value = 0;
+	glGetIntegerv(name, &value);
+	return(value);
+}
+
+GLvoid GLState::ResetStats()
+{
+	stats = GLStateStats();
+}
+
+GLvoid GLState::Invalidate()
+{
+	shadow = Unknown();
+}
+
+GLboolean GLState::Validate()
+{
+	GLboolean ok = true;
+	ok = Check(shadow.program, Get(GL_CURRENT_PROGRAM), "program") && ok;
+	ok = Check(shadow.vao, Get(GL_VERTEX_ARRAY_BINDING), "vertex array") &&
+		ok;
+	ok = Check(shadow.arrayBuffer, Get(GL_ARRAY_BUFFER_BINDING),
+		"GL_ARRAY_BUFFER") && ok;
+	ok = Check(shadow.uniformBuffer, Get(GL_UNIFORM_BUFFER_BINDING),
+		"GL_UNIFORM_BUFFER") && ok;
+	ok = Check(shadow.activeTexture, Get(GL_ACTIVE_TEXTURE),
+		"active texture") && ok;
+
+	//Only the active unit can be queried without changing the state
+	GLuint unit = shadow.activeTexture-GL_TEXTURE0;
+	if(shadow.activeTexture != UNKNOWN && unit < GL_STATE_TEXTURE_UNITS)
+	{
+		ok = Check(shadow.textures[unit], Get(GL_TEXTURE_BINDING_2D),
+			"GL_TEXTURE_2D") && ok;
+	}
+
+	for(GLuint i = 0; i < GL_STATE_UNIFORM_BINDINGS; i++)
+	{
+		ShadowRange &r = shadow.uniforms[i];
+		if(r.buffer == UNKNOWN) continue;
+		GLint buffer = 0;
+		GLint64 offset = 0, size = 0;
+		glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &buffer);
+		glGetInteger64i_v(GL_UNIFORM_BUFFER_START, i, &offset);
+		glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, i, &size);
+		if(r.buffer == (GLuint)buffer && r.offset == offset && r.size == size)
+			continue;
+		cerr << "GLState: uniform buffer binding " << i << " is " <<
+			buffer << " (" << offset << ", " << size <<
+			"), the shadow has " << r.buffer << " (" << r.offset << ", " <<
+			r.size << ")" << endl;
+		stats.mismatches++;
+		r.buffer = buffer, r.offset = offset, r.size = size;
+		ok = false;
+	}
+
+	for(GLuint i = 0; i < NUM_CAPS; i++)
+		ok = Check(shadow.caps[i], glIsEnabled(trackedCaps[i]), "cap") && ok;
+
+	ok = Check(shadow.blendSrc, Get(GL_BLEND_SRC_RGB), "blend source") && ok;
+	ok = Check(shadow.blendDst, Get(GL_BLEND_DST_RGB), "blend destination")
+		&& ok;
+	ok = Check(shadow.depthFunc, Get(GL_DEPTH_FUNC), "depth func") && ok;
+	ok = Check(shadow.depthMask, Get(GL_DEPTH_WRITEMASK), "depth mask") && ok;
+	ok = Check(shadow.cullFace, Get(GL_CULL_FACE_MODE), "cull face") && ok;
+	ok = Check(shadow.frontFace, Get(GL_FRONT_FACE), "front face") && ok;
+	GLint polygonMode[2] = {0, 0};
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	ok = Check(shadow.polygonMode, polygonMode[0], "polygon mode") && ok;
+	return(ok);
+}
+
+GLvoid GLState::UseProgram(GLuint program)
+{
+	if(Change(shadow.program, program)) glUseProgram(program);
+}
+
+GLvoid GLState::BindVertexArray(GLuint vao)
+{
+	if(Change(shadow.vao, vao)) glBindVertexArray(vao);
+}
+
+GLvoid GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+	if(target == GL_ARRAY_BUFFER)
+	{
+		if(Change(shadow.arrayBuffer, buffer)) glBindBuffer(target, buffer);
+	}
+	else if(target == GL_UNIFORM_BUFFER)
+	{
+		if(Change(shadow.uniformBuffer, buffer)) glBindBuffer(target, buffer);
+	}
+	else
+	{
+		PassOn();
+		glBindBuffer(target, buffer);
+	}
+}
+
+GLvoid GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	//OpenGL reports a whole buffer as offset 0 and size 0
+	BindBufferRange(target, index, buffer, 0, 0);
+}
+
+GLvoid GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+		GLintptr offset, GLsizeiptr size)
+{
+	if(target != GL_UNIFORM_BUFFER || index >= GL_STATE_UNIFORM_BINDINGS)
+	{
+		PassOn();
+		if(size == 0) glBindBufferBase(target, index, buffer);
+		else glBindBufferRange(target, index, buffer, offset, size);
+		return;
+	}
+
+	if(validate) Validate();
+	ShadowRange &r = shadow.uniforms[index];
+	if(r.buffer == buffer && r.offset == offset && r.size == size)
+	{
+		stats.elided++;
+		return;
+	}
+	r.buffer = buffer, r.offset = offset, r.size = size;
+	shadow.uniformBuffer = buffer;
+	stats.issued++;
+	if(size == 0) glBindBufferBase(target, index, buffer);
+	else glBindBufferRange(target, index, buffer, offset, size);
+}
+
+GLvoid GLState::ActiveTexture(GLenum unit)
+{
+	if(Change(shadow.activeTexture, unit)) glActiveTexture(unit);
+}
+
+GLvoid GLState::BindTexture(GLenum target, GLuint texture)
+{
+	GLuint unit = shadow.activeTexture-GL_TEXTURE0;
+	if(target != GL_TEXTURE_2D || shadow.activeTexture == UNKNOWN ||
+			unit >= GL_STATE_TEXTURE_UNITS)
+	{
+		PassOn();
+		glBindTexture(target, texture);
+		return;
+	}
+	if(Change(shadow.textures[unit], texture)) glBindTexture(target, texture);
+}
+
+GLvoid GLState::Enable(GLenum cap)
+{
+	GLuint i = CapIndex(cap);
+	if(i == NUM_CAPS) PassOn();
+	if(i == NUM_CAPS || Change(shadow.caps[i], GL_TRUE)) glEnable(cap);
+}
+
+GLvoid GLState::Disable(GLenum cap)
+{
+	GLuint i = CapIndex(cap);
+	if(i == NUM_CAPS) PassOn();
+	if(i == NUM_CAPS || Change(shadow.caps[i], GL_FALSE)) glDisable(cap);
+}
+
+GLvoid GLState::BlendFunc(GLenum src, GLenum dst)
+{
+	if(validate) Validate();
+	if(shadow.blendSrc == src && shadow.blendDst == dst)
+	{
+		stats.elided++;
+		return;
+	}
+	shadow.blendSrc = src, shadow.blendDst = dst;
+	stats.issued++;
+	glBlendFunc(src, dst);
+}
+
+GLvoid GLState::DepthFunc(GLenum func)
+{
+	if(Change(shadow.depthFunc, func)) glDepthFunc(func);
+}
+
+GLvoid GLState::DepthMask(GLboolean mask)
+{
+	if(Change(shadow.depthMask, mask ? GL_TRUE : GL_FALSE)) glDepthMask(mask);
+}
+
+GLvoid GLState::CullFace(GLenum mode)
+{
+	if(Change(shadow.cullFace, mode)) glCullFace(mode);
+}
+
+GLvoid GLState::FrontFace(GLenum mode)
+{
+	if(Change(shadow.frontFace, mode)) glFrontFace(mode);
+}
+
+GLvoid GLState::PolygonMode(GLenum mode)
+{
+	if(Change(shadow.polygonMode, mode)) glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+GLvoid GLState::DeleteProgram(GLuint program)
+{
+	//A program in use is only deleted once another program is used, but
+	//a new program may get its name afterwards
+	PassOn();
+	if(shadow.program == program) shadow.program = UNKNOWN;
+	glDeleteProgram(program);
+}
+
+GLvoid GLState::DeleteBuffers(GLsizei n, const GLuint *buffers)
+{
+	PassOn();
+	for(GLsizei k = 0; k < n; k++)
+	{
+		if(buffers[k] == 0) continue;
+		if(shadow.arrayBuffer == buffers[k]) shadow.arrayBuffer = 0;
+		if(shadow.uniformBuffer == buffers[k]) shadow.uniformBuffer = 0;
+		for(GLuint i = 0; i < GL_STATE_UNIFORM_BINDINGS; i++)
+		{
+			if(shadow.uniforms[i].buffer == buffers[k])
+				shadow.uniforms[i].buffer = UNKNOWN;
+		}
+	}
+	glDeleteBuffers(n, buffers);
+}
+
+GLvoid GLState::DeleteVertexArrays(GLsizei n, const GLuint *arrays)
+{
+	PassOn();
+	for(GLsizei k = 0; k < n; k++)
+		if(arrays[k] != 0 && shadow.vao == arrays[k]) shadow.vao = 0;
+	glDeleteVertexArrays(n, arrays);
+}
+
+GLvoid GLState::DeleteTextures(GLsizei n, const GLuint *textures)
+{
+	PassOn();
+	for(GLsizei k = 0; k < n; k++)
+	{
+		for(GLuint i = 0; textures[k] != 0 && i < GL_STATE_TEXTURE_UNITS; i++)
+			if(shadow.textures[i] == textures[k]) shadow.textures[i] = 0;
+	}
+	glDeleteTextures(n, textures);
+}
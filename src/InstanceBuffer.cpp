@@ -0,0 +1,109 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <algorithm>
+
+#include <InstanceBuffer.h>
+#include <GLState.h>
+
+using namespace std;
+
+InstanceBuffer::InstanceBuffer()
+{
+	vbo = 0, capacity = 0;
+}
+
+GLvoid InstanceBuffer::Resize(GLuint count)
+{
+	GLuint old = instances.size();
+	MeshInstance instance;
+	instance.model = Mat4f::Identity();
+	for(GLuint i = 0; i < 4; i++) instance.color.v[i] = 1.0f;
+	instances.resize(count, instance);
+	if(count > old) MarkDirty(old, count-old);
+}
+
+GLvoid InstanceBuffer::MarkDirty(GLuint first, GLuint count)
+{
+	if(count == 0) return;
+
+	//Consecutive edits usually continue the last range
+	if(!dirty.empty() && dirty[dirty.size()-2]+dirty.back() == first)
+	{
+		dirty.back() += count;
+		return;
+	}
+	dirty.push_back(first);
+	dirty.push_back(count);
+}
+
+GLvoid InstanceBuffer::FillGrid(const Vector3 &center, GLfloat spacing)
+{
+	GLuint side = (GLuint)ceilf(sqrtf((GLfloat)instances.size()));
+	GLfloat start = -0.5f*(side-1)*spacing;
+	for(GLuint i = 0; i < instances.size(); i++)
+	{
+		Mat4f &m = instances[i].model;
+		m = Mat4f::Identity();
+		m.m[12] = center.x+start+(i%side)*spacing;
+		m.m[13] = center.y+start+(i/side)*spacing;
+		m.m[14] = center.z;
+	}
+	dirty.clear();
+	MarkDirty(0, instances.size());
+}
+
+GLsizeiptr InstanceBuffer::Upload()
+{
+	if(vbo == 0) glGenBuffers(1, &vbo);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	//A VBO that is too small is reallocated and filled with everything
+	GLsizeiptr bytes = 0;
+	if(instances.size() > capacity || capacity == 0)
+	{
+		capacity = instances.size();
+		bytes = capacity*sizeof(MeshInstance);
+		glBufferData(GL_ARRAY_BUFFER, bytes,
+			instances.empty() ? NULL : &instances.front(), GL_DYNAMIC_DRAW);
+		dirty.clear();
+		return(bytes);
+	}
+
+	//Sort the ranges by their first instance and merge the ones that
+	//overlap or touch, so each instance is uploaded at most once
+	vector<pair<GLuint, GLuint> > ranges;
+	for(GLuint i = 0; i < dirty.size(); i += 2)
+	{
+		GLuint end = min<size_t>(dirty[i]+dirty[i+1], instances.size());
+		if(dirty[i] < end) ranges.push_back(make_pair(dirty[i], end));
+	}
+	sort(ranges.begin(), ranges.end());
+	for(GLuint i = 0; i < ranges.size();)
+	{
+		GLuint first = ranges[i].first, end = ranges[i].second;
+		for(i++; i < ranges.size() && ranges[i].first <= end; i++)
+			end = max(end, ranges[i].second);
+		GLsizeiptr size = (end-first)*sizeof(MeshInstance);
+		glBufferSubData(GL_ARRAY_BUFFER, first*sizeof(MeshInstance), size,
+			&instances[first]);
+		bytes += size;
+	}
+	dirty.clear();
+	return(bytes);
+}
+
+GLvoid InstanceBuffer::Close()
+{
+	vector<MeshInstance>().swap(instances);
+	vector<GLuint>().swap(dirty);
+	if(vbo != 0) GLState::DeleteBuffers(1, &vbo);
+	vbo = 0, capacity = 0;
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	Close();
+}
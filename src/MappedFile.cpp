@@ -0,0 +1,90 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <MappedFile.h>
+
+using namespace std;
+
+MappedFile::MappedFile()
+{
+	data = NULL, size = 0;
+#ifdef _WIN32
+	file = NULL, mapping = NULL;
+#endif
+}
+
+GLboolean MappedFile::Open(const string &filename)
+{
+	//Release the previous mapping, if there is one
+	Close();
+
+#ifdef _WIN32
+	HANDLE f = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(f == INVALID_HANDLE_VALUE) return(false);
+
+	LARGE_INTEGER fsize;
+	if(!GetFileSizeEx(f, &fsize)) {CloseHandle(f); return(false);}
+	file = f;
+	size = (size_t)fsize.QuadPart;
+
+	//Empty files can't be mapped, but they are still valid files
+	if(size == 0) return(true);
+
+	HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(m == NULL) {Close(); return(false);}
+	mapping = m;
+
+	data = (const GLchar*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+	if(data == NULL) {Close(); return(false);}
+#else
+	GLint fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0) return(false);
+
+	struct stat st;
+	if(fstat(fd, &st) != 0) {close(fd); return(false);}
+	size = (size_t)st.st_size;
+
+	//Empty files can't be mapped, but they are still valid files
+	if(size == 0) {close(fd); return(true);}
+
+	//The descriptor isn't needed once the mapping exists
+	GLvoid *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED) {size = 0; return(false);}
+
+	//We read the file front to back, let the kernel read ahead aggressively
+	madvise(p, size, MADV_SEQUENTIAL);
+	data = (const GLchar*)p;
+#endif
+
+	return(true);
+}
+
+GLvoid MappedFile::Close()
+{
+#ifdef _WIN32
+	if(data != NULL) UnmapViewOfFile(data);
+	if(mapping != NULL) CloseHandle((HANDLE)mapping);
+	if(file != NULL) CloseHandle((HANDLE)file);
+	file = NULL, mapping = NULL;
+#else
+	if(data != NULL) munmap((GLvoid*)data, size);
+#endif
+	data = NULL, size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
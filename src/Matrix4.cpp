@@ -8,6 +8,7 @@
 #include <iomanip>
 
 #include <Matrix4.h>
+#include <Simd.h>
 
 #define PI 3.14159265358979323846264338327950288419716939937510582097494459231f
 
@@ -18,6 +19,18 @@ Matrix4::Matrix4()
 	for(GLuint i=0; i<16; i++) mat[i]=((i%5==0) ? 1.0f : 0.0f);
 }
 
+Matrix4::Matrix4(const Mat4f &m)
+{
+	memcpy(mat, m.m, sizeof(mat));
+}
+
+Mat4f Matrix4::ToMat4() const
+{
+	Mat4f m;
+	memcpy(m.m, mat, sizeof(mat));
+	return(m);
+}
+
 Matrix4& Matrix4::LoadIdentity()
 {
 	for(GLuint i=0; i<16; i++) mat[i]=((i%5==0) ? 1.0f : 0.0f);
@@ -101,15 +114,165 @@ Matrix4 Matrix4::Transpose() const
 	return(m);
 }
 
+#if defined(SIMD_SSE)
+//Picks the components x and y of a and z and w of b
+#define SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+//The products of 2x2 matrices stored as (m00, m01, m10, m11), a*b, the 
+//adjugate of a times b and a times the adjugate of b
+static inline __m128 Multiply2(__m128 a, __m128 b)
+{
+	return(_mm_add_ps(_mm_mul_ps(a, SHUFFLE(b, b, 0, 3, 0, 3)),
+		_mm_mul_ps(SHUFFLE(a, a, 1, 0, 3, 2), SHUFFLE(b, b, 2, 1, 2, 1))));
+}
+
+static inline __m128 AdjugateMultiply2(__m128 a, __m128 b)
+{
+	return(_mm_sub_ps(_mm_mul_ps(SHUFFLE(a, a, 3, 3, 0, 0), b),
+		_mm_mul_ps(SHUFFLE(a, a, 1, 1, 2, 2), SHUFFLE(b, b, 2, 3, 0, 1))));
+}
+
+static inline __m128 MultiplyAdjugate2(__m128 a, __m128 b)
+{
+	return(_mm_sub_ps(_mm_mul_ps(a, SHUFFLE(b, b, 3, 0, 3, 0)),
+		_mm_mul_ps(SHUFFLE(a, a, 1, 0, 3, 2), SHUFFLE(b, b, 2, 1, 2, 1))));
+}
+#endif
+
 Matrix4 Matrix4::Inverse() const
 {
 	Matrix4 m;
-	GLfloat det = Determinant();
+#if defined(SIMD_SSE)
+	//Split the matrix into 2x2 blocks A, B, C and D, the inverse is built
+	//from their determinants and adjugates. Inverting the transpose gives
+	//the transpose of the inverse, so the columns can be used as rows.
+	__m128 c0 = _mm_loadu_ps(mat), c1 = _mm_loadu_ps(mat+4);
+	__m128 c2 = _mm_loadu_ps(mat+8), c3 = _mm_loadu_ps(mat+12);
+	__m128 a = _mm_movelh_ps(c0, c1), b = _mm_movehl_ps(c1, c0);
+	__m128 c = _mm_movelh_ps(c2, c3), d = _mm_movehl_ps(c3, c2);
+
+	//The determinants |A|, |B|, |C| and |D|
+	__m128 dets = _mm_sub_ps(
+		_mm_mul_ps(SHUFFLE(c0, c2, 0, 2, 0, 2), SHUFFLE(c1, c3, 1, 3, 1, 3)),
+		_mm_mul_ps(SHUFFLE(c0, c2, 1, 3, 1, 3), SHUFFLE(c1, c3, 0, 2, 0, 2)));
+	__m128 detA = SHUFFLE(dets, dets, 0, 0, 0, 0);
+	__m128 detB = SHUFFLE(dets, dets, 1, 1, 1, 1);
+	__m128 detC = SHUFFLE(dets, dets, 2, 2, 2, 2);
+	__m128 detD = SHUFFLE(dets, dets, 3, 3, 3, 3);
+
+	//The adjugates of the blocks of the inverse, X = |D|A-B(D#C), 
+	//Y = |B|C-D(A#B)#, Z = |C|B-A(D#C)# and W = |A|D-C(A#B)
+	__m128 dc = AdjugateMultiply2(d, c), ab = AdjugateMultiply2(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Multiply2(b, dc));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Multiply2(c, ab));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), MultiplyAdjugate2(d, ab));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), MultiplyAdjugate2(a, dc));
+
+	//|M| = |A||D|+|B||C|-tr((A#B)(D#C))
+	__m128 trace = _mm_mul_ps(ab, SHUFFLE(dc, dc, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, SHUFFLE(trace, trace, 2, 3, 0, 1));
+	trace = _mm_add_ps(trace, SHUFFLE(trace, trace, 1, 0, 3, 2));
+	__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), 
+		_mm_mul_ps(detB, detC)), trace);
+	if(fabs(_mm_cvtss_f32(det)) < 0.000001f) return(m);
+
+	//Undo the adjugates while storing the blocks
+	__m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, scale), y = _mm_mul_ps(y, scale);
+	z = _mm_mul_ps(z, scale), w = _mm_mul_ps(w, scale);
+	_mm_storeu_ps(m.mat, SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(m.mat+4, SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(m.mat+8, SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(m.mat+12, SHUFFLE(z, w, 2, 0, 2, 0));
+#else
+	//The cofactors are sums of products of 2x2 determinants, s from the 
+	//first two columns and c from the last two
+	const GLfloat *a = mat;
+	GLfloat s0 = a[0]*a[5]-a[4]*a[1], s1 = a[0]*a[6]-a[4]*a[2];
+	GLfloat s2 = a[0]*a[7]-a[4]*a[3], s3 = a[1]*a[6]-a[5]*a[2];
+	GLfloat s4 = a[1]*a[7]-a[5]*a[3], s5 = a[2]*a[7]-a[6]*a[3];
+	GLfloat c5 = a[10]*a[15]-a[14]*a[11], c4 = a[9]*a[15]-a[13]*a[11];
+	GLfloat c3 = a[9]*a[14]-a[13]*a[10], c2 = a[8]*a[15]-a[12]*a[11];
+	GLfloat c1 = a[8]*a[14]-a[12]*a[10], c0 = a[8]*a[13]-a[12]*a[9];
+	GLfloat det = s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0;
 	if(fabs(det) < 0.000001f) return(m);
-	for(GLuint c=0; c<4; c++)
-		for(GLuint r=0; r<4; r++)
-			m.mat[c*4+r]=Cofactor(c, r)/det;
-	return(m.Transpose());
+
+	GLfloat k = 1.0f/det;
+	m.mat[0] = (a[5]*c5-a[6]*c4+a[7]*c3)*k;
+	m.mat[1] = (-a[1]*c5+a[2]*c4-a[3]*c3)*k;
+	m.mat[2] = (a[13]*s5-a[14]*s4+a[15]*s3)*k;
+	m.mat[3] = (-a[9]*s5+a[10]*s4-a[11]*s3)*k;
+	m.mat[4] = (-a[4]*c5+a[6]*c2-a[7]*c1)*k;
+	m.mat[5] = (a[0]*c5-a[2]*c2+a[3]*c1)*k;
+	m.mat[6] = (-a[12]*s5+a[14]*s2-a[15]*s1)*k;
+	m.mat[7] = (a[8]*s5-a[10]*s2+a[11]*s1)*k;
+	m.mat[8] = (a[4]*c4-a[5]*c2+a[7]*c0)*k;
+	m.mat[9] = (-a[0]*c4+a[1]*c2-a[3]*c0)*k;
+	m.mat[10] = (a[12]*s4-a[13]*s2+a[15]*s0)*k;
+	m.mat[11] = (-a[8]*s4+a[9]*s2-a[11]*s0)*k;
+	m.mat[12] = (-a[4]*c3+a[5]*c1-a[6]*c0)*k;
+	m.mat[13] = (a[0]*c3-a[1]*c1+a[2]*c0)*k;
+	m.mat[14] = (-a[12]*s3+a[13]*s1-a[14]*s0)*k;
+	m.mat[15] = (a[8]*s3-a[9]*s1+a[10]*s0)*k;
+#endif
+	return(m);
+}
+
+Matrix4 Matrix4::AffineInverse() const
+{
+	//The rows of the inverse of the upper 3x3 matrix are the cross 
+	//products of its columns, divided by the determinant
+	Matrix4 m;
+	Simd4 c0 = Simd::Load(mat), c1 = Simd::Load(mat+4);
+	Simd4 c2 = Simd::Load(mat+8);
+	Simd4 r0 = Simd::Cross3(c1, c2);
+	GLfloat det = Simd::Dot3(c0, r0);
+	if(fabs(det) < 0.000001f) return(m);
+
+	Simd4 k = Simd::Splat(1.0f/det);
+	GLfloat r[3][4];
+	Simd::Store(r[0], Simd::Mul(r0, k));
+	Simd::Store(r[1], Simd::Mul(Simd::Cross3(c2, c0), k));
+	Simd::Store(r[2], Simd::Mul(Simd::Cross3(c0, c1), k));
+	Simd4 t = Simd::Load(mat+12);
+	for(GLuint i = 0; i < 3; i++)
+	{
+		m.mat[i] = r[i][0], m.mat[4+i] = r[i][1], m.mat[8+i] = r[i][2];
+		m.mat[12+i] = -Simd::Dot3(Simd::Load(r[i]), t);
+	}
+	return(m);
+}
+
+Matrix4 Matrix4::RigidInverse() const
+{
+	Matrix4 m;
+	Simd4 t = Simd::Load(mat+12);
+	for(GLuint i = 0; i < 3; i++)
+	{
+		m.mat[i] = mat[4*i], m.mat[4+i] = mat[4*i+1];
+		m.mat[8+i] = mat[4*i+2];
+		m.mat[12+i] = -Simd::Dot3(Simd::Load(mat+4*i), t);
+	}
+	return(m);
+}
+
+Matrix4 Matrix4::NormalMatrix() const
+{
+	//The transpose of the inverse in AffineInverse(), the columns are the
+	//cross products
+	Matrix4 m;
+	Simd4 c0 = Simd::Load(mat), c1 = Simd::Load(mat+4);
+	Simd4 c2 = Simd::Load(mat+8);
+	Simd4 r0 = Simd::Cross3(c1, c2);
+	GLfloat det = Simd::Dot3(c0, r0);
+	if(fabs(det) < 0.000001f) return(m);
+
+	Simd4 k = Simd::Splat(1.0f/det);
+	Simd::Store(m.mat, Simd::Mul(r0, k));
+	Simd::Store(m.mat+4, Simd::Mul(Simd::Cross3(c2, c0), k));
+	Simd::Store(m.mat+8, Simd::Mul(Simd::Cross3(c0, c1), k));
+	m.mat[3] = 0.0f, m.mat[7] = 0.0f, m.mat[11] = 0.0f;
+	return(m);
 }
 
 GLfloat Matrix4::Cofactor(GLuint column, GLuint row) const
@@ -138,44 +301,73 @@ GLfloat Matrix4::Cofactor(GLuint column, GLuint row) const
 
 GLfloat Matrix4::Determinant() const
 {
-	//Basically, we have to take an arbitrary row (or column), in this case we
-	//took the fourth row of the matrix, and multiply each element in that row
-	//by it's signed cofactor, which is found by calculating the determinant of
-	//the minor of that element, and then summing up all the values.
-	return(mat[3]*Cofactor(0, 3)+mat[7]*Cofactor(1, 3)+mat[11]*Cofactor(2, 3)
-			+mat[15]*Cofactor(3, 3));
+	//Laplace expansion along the first two columns: every 2x2 determinant
+	//of those columns times the complementary 2x2 determinant of the last
+	//two
+	const GLfloat *a = mat;
+	return((a[0]*a[5]-a[4]*a[1])*(a[10]*a[15]-a[14]*a[11])-
+		(a[0]*a[6]-a[4]*a[2])*(a[9]*a[15]-a[13]*a[11])+
+		(a[0]*a[7]-a[4]*a[3])*(a[9]*a[14]-a[13]*a[10])+
+		(a[1]*a[6]-a[5]*a[2])*(a[8]*a[15]-a[12]*a[11])-
+		(a[1]*a[7]-a[5]*a[3])*(a[8]*a[14]-a[12]*a[10])+
+		(a[2]*a[7]-a[6]*a[3])*(a[8]*a[13]-a[12]*a[9]));
 }
 
 Vector3 Matrix4::operator*(const Vector3 &v) const
 {
-	Vector3 u;
-	u.x = mat[0]*v.x+mat[4]*v.y+mat[8]*v.z+mat[12]*v.w;
-	u.y = mat[1]*v.x+mat[5]*v.y+mat[9]*v.z+mat[13]*v.w;
-	u.z = mat[2]*v.x+mat[6]*v.y+mat[10]*v.z+mat[14]*v.w;
-	u.w = mat[3]*v.x+mat[7]*v.y+mat[11]*v.z+mat[15]*v.w;
-	return(u);
+	//Sum the columns scaled by the components of the vector
+	Simd4 u = Simd::Mul(Simd::Load(mat), Simd::Splat(v.x));
+	u = Simd::Add(u, Simd::Mul(Simd::Load(mat+4), Simd::Splat(v.y)));
+	u = Simd::Add(u, Simd::Mul(Simd::Load(mat+8), Simd::Splat(v.z)));
+	u = Simd::Add(u, Simd::Mul(Simd::Load(mat+12), Simd::Splat(v.w)));
+
+	//The result is copied from v, which is trivial, rather than built by
+	//a constructor, which is a call
+	Vector3 r = v;
+	Simd::Store(&r.x, u);
+	return(r);
 }
 
 Matrix4 Matrix4::operator*(const Matrix4 &m) const
 {
+	//Each column of the product is the sum of the columns of this matrix,
+	//scaled by the components of the other matrix's column
 	Matrix4 a;
-	for(GLuint i=0, offset=0, ii=0; i<16; i++, ii++)
+#if defined(SIMD_AVX)
+	//Two columns at a time, each half of a register holds one of them
+	__m256 c[4];
+	for(GLuint k = 0; k < 4; k++)
 	{
-		a.mat[i]=0, offset=((i%4==0) ? i : offset), ii=((ii>3) ? 0 : ii);
-		for(GLuint j=0, mult=0; j<4; mult++, j++)
-		{
-			a.mat[i]+=mat[ii+mult*4]*m.mat[offset+j];
-		}
+		__m128 col = _mm_loadu_ps(mat+4*k);
+		c[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(col), col, 1);
+	}
+	for(GLuint i = 0; i < 16; i += 8)
+	{
+		__m256 b = _mm256_loadu_ps(m.mat+i);
+		__m256 r = _mm256_mul_ps(c[0], _mm256_shuffle_ps(b, b, 0x00));
+		r = _mm256_add_ps(r, _mm256_mul_ps(c[1], 
+			_mm256_shuffle_ps(b, b, 0x55)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(c[2], 
+			_mm256_shuffle_ps(b, b, 0xAA)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(c[3], 
+			_mm256_shuffle_ps(b, b, 0xFF)));
+		_mm256_storeu_ps(a.mat+i, r);
+	}
+#else
+	Simd4 c[4];
+	for(GLuint k = 0; k < 4; k++) c[k] = Simd::Load(mat+4*k);
+	for(GLuint i = 0; i < 16; i += 4)
+	{
+		Simd4 r = Simd::Mul(c[0], Simd::Splat(m.mat[i]));
+		r = Simd::Add(r, Simd::Mul(c[1], Simd::Splat(m.mat[i+1])));
+		r = Simd::Add(r, Simd::Mul(c[2], Simd::Splat(m.mat[i+2])));
+		r = Simd::Add(r, Simd::Mul(c[3], Simd::Splat(m.mat[i+3])));
+		Simd::Store(a.mat+i, r);
 	}
+#endif
 	return(a);
 }
 
-Matrix4& Matrix4::operator=(const Matrix4 &m)
-{
-	memmove(mat, m.mat, 16*sizeof(GLfloat));
-	return(*this);
-}
-
 Matrix4& Matrix4::operator*=(const Matrix4 &m)
 {
 	(*this) = (*this)*m;
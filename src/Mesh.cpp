@@ -2,110 +2,51 @@
 //Licensed under the MIT license
 //See license.txt
 
+#include <SFML/System/Clock.hpp>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
+#include <deque>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cfloat>
 
 #include <Mesh.h>
+#include <MappedFile.h>
+#include <Tokenizer.h>
+#include <Parallel.h>
+#include <Simplifier.h>
+#include <Simd.h>
+#include <GLState.h>
 
-using namespace std;
-
-GLboolean Material::Open(const string &filename, const string &matname)
-{
-	//Open the file and make sure it is good
-	ifstream file(filename.c_str(), ifstream::in);
-	if(!file.is_open() || !file.good()) return(false);
+//The smallest chunk of an OBJ file worth parsing on its own thread, in bytes
+#define OBJ_MIN_CHUNK_SIZE (1<<20)
 
-	//Loop through the file, one line at a time
-	while(file.good())
-	{
-		//Get the next line
-		string buf;
-		getline(file, buf);
-		
-		//Load only the data from the specified material
-		//When we are done loading we break out of the 
-		//top level loop. Make sure the line specifies 
-		//a new material by the tag <newmtl> and is not
-		//just a comment!
-		if(buf[0] == 'n' && buf.find(matname) != string::npos)
-		{
-			//If we are done reading in the material definition
-			//this will be set to true so we could break out of this loop
-			GLboolean finished = false;
+//The number of triangles, or vertices, per task of CalculateNormals()
+#define NORMAL_BLOCK_SIZE (1<<16)
 
-			while(file.good())
-			{
-				//Get the next line
-				getline(file, buf);
+using namespace std;
 
-				//Break out of the loop when we are done
-				if(finished) break;
+//Guards the material library cache, meshes may be loaded on any thread
+static sf::Mutex materialCacheMutex;
 
-				switch(buf[0])
-				{
-					//If N is found that means it is either a specular exponent
-					//or index of refraction.
-					case 'N':
-					{
-						istringstream s(buf.substr(3), istringstream::in);
-						if(buf[1] == 's')
-							s >> ns;
-						else if(buf[1] == 'i')
-							s >> ni;
-						break;
-					}
+map<string, MaterialLibrary*> MaterialLibrary::cache;
 
-					//If the first char is K, it specifies either a specular
-					//ambient or diffuse color
-					//Blender doesn't output a alpha component for the colors
-					//Set that shit to 1 (fully opaque)
-					case 'K':
-					{
-						istringstream s(buf.substr(3), istringstream::in);
-						if(buf[1] == 'a')
-							s >> ka[0] >> ka[1] >> ka[2];
-						else if(buf[1] == 'd')
-							s >> kd[0] >> kd[1] >> kd[2];
-						else
-							s >> ks[0] >> ks[1] >> ks[2];
-						break;
-					}
-	
-					//If the first char is d, it specifies the transparency
-					case 'd':
-					{
-						istringstream s(buf.substr(2), istringstream::in);
-						s >> d;
-						break;
-					}
+Material::Material()
+{
+	ns = 0.0f, d = 1.0f, illum = 2, ni = 1.0f;
+	for(GLuint i = 0; i < 3; i++) ka[i] = 0.2f, kd[i] = 0.8f, ks[i] = 1.0f;
+}
 
-					//If the first char is i, it specifies the illumination
-					//model
-					case 'i':
-					{
-						istringstream s(buf.substr(6), istringstream::in);
-						s >> illum;
-						break;
-					}
+GLboolean Material::Open(const string &filename, const string &matname)
+{
+	//The library parses the file only the first time it's requested
+	MaterialLibrary *library = MaterialLibrary::Load(filename);
+	if(library == NULL) return(false);
 
-					//If we find none of the above then we know we are done
-					//reading the file defintion so set finished to true
-					default:
-					{
-						finished = true;
-						break;
-					}
-				}
-			}
-	
-			//Break out of the top level loop
-			break;
-		}
-	}
-	
-	//Close that shit!
-	file.close();
+	const Material *mtl = library->Find(matname);
+	*this = (mtl != NULL) ? *mtl : Material();
 
 	return(true);
 }
@@ -135,6 +76,175 @@ const string Material::ToString() const
 	return(s.str());
 }
 
+MeshLoadStats::MeshLoadStats()
+{
+	bytes = 0, parseTime = 0.0f, threads = 1;
+	fromCache = false, cacheWritten = false;
+	corners = 0, uniqueVerts = 0, optimizeTime = 0.0f, remapTime = 0.0f;
+}
+
+GLfloat MeshLoadStats::Throughput() const
+{
+	if(parseTime <= 0.0f) return(0.0f);
+	return((bytes/(1024.0f*1024.0f))/parseTime);
+}
+
+const string MeshLoadStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s<<left;
+	s<<setw(15)<<"FILE SIZE"<<": "<<bytes<<" bytes"<<endl;
+	s<<setw(15)<<"PARSE TIME"<<": "<<parseTime*1000.0f<<" ms"<<endl;
+	s<<setw(15)<<"THREADS"<<": "<<threads<<endl;
+	s<<setw(15)<<"CACHE"<<": "<<(fromCache ? "loaded" : (cacheWritten ? 
+		"written" : "not used"))<<endl;
+	s<<setw(15)<<"THROUGHPUT"<<": "<<Throughput()<<" MB/s";
+
+	//Welding statistics, the memory saved assumes a position, a normal and
+	//a texture coordinate per vertex
+	if(corners > 0)
+	{
+		size_t saved = (corners-uniqueVerts)*3*sizeof(Vector3);
+		s<<endl<<setw(15)<<"CORNERS"<<": "<<corners<<endl;
+		s<<setw(15)<<"UNIQUE VERTS"<<": "<<uniqueVerts<<" ("<<
+			(100.0f*uniqueVerts)/corners<<"%)"<<endl;
+		s<<setw(15)<<"WELD SAVINGS"<<": "<<saved/(1024.0f*1024.0f)<<" MB";
+	}
+
+	//Vertex cache use of the triangles, if they were reordered
+	if(vertexCacheAfter.triangles > 0)
+	{
+		s<<endl<<setw(15)<<"OPTIMIZE TIME"<<": "<<optimizeTime*1000.0f<<
+			" ms"<<endl;
+		s<<setw(15)<<"ACMR"<<": "<<vertexCacheBefore.ACMR()<<" -> "<<
+			vertexCacheAfter.ACMR()<<endl;
+		s<<setw(15)<<"ATVR"<<": "<<vertexCacheBefore.ATVR()<<" -> "<<
+			vertexCacheAfter.ATVR();
+	}
+
+	//Estimated vertex fetch cache misses, if the vertices were reordered
+	if(fetchAfter.fetches > 0)
+	{
+		s<<endl<<setw(15)<<"REMAP TIME"<<": "<<remapTime*1000.0f<<" ms"<<endl;
+		s<<setw(15)<<"FETCH MISSES"<<": "<<fetchBefore.MissRatio()<<" -> "<<
+			fetchAfter.MissRatio()<<" lines/vertex";
+	}
+	return(s.str());
+}
+
+GroupCullStats::GroupCullStats()
+{
+	groups = 0, triangles = 0, culledGroups = 0, culledTriangles = 0;
+}
+
+GLvoid GroupCullStats::Add(const GroupCullStats &s)
+{
+	groups += s.groups;
+	triangles += s.triangles;
+	culledGroups += s.culledGroups;
+	culledTriangles += s.culledTriangles;
+}
+
+const string GroupCullStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	GLfloat percent = (triangles > 0) ? (100.0f*culledTriangles)/triangles : 
+		0.0f;
+	s<<left;
+	s<<setw(15)<<"GROUPS"<<": "<<groups<<", "<<culledGroups<<
+		" outside the frustum, "<<culledTriangles<<" of "<<triangles<<
+		" triangles culled ("<<percent<<"%)";
+	return(s.str());
+}
+
+TriangleGroup::TriangleGroup()
+{
+	mtl = NO_MATERIAL, ibo = 0, vao = 0, count = 0, visible = true;
+}
+
+GLboolean MaterialLibrary::Open(const string &filename)
+{
+	MappedFile file;
+	if(!file.Open(filename)) return(false);
+
+	this->filename = filename;
+	materials.clear(), names.clear(), lookup.clear();
+
+	//Every line starts with a statement, values are added to the material
+	//defined by the last newmtl statement
+	Tokenizer t(file.data, file.data+file.size);
+	while(!t.Done())
+	{
+		t.SkipSpaces();
+
+		if(t.Keyword("newmtl"))
+		{
+			//If a name is defined twice, the first definition is used
+			names.push_back(t.ReadLine());
+			materials.push_back(Material());
+			lookup.insert(make_pair(names.back(), materials.size()-1));
+		}
+		else if(!materials.empty())
+		{
+			Material &mtl = materials.back();
+			if(t.Keyword("Ns")) mtl.ns = t.ReadFloat();
+			else if(t.Keyword("Ni")) mtl.ni = t.ReadFloat();
+			else if(t.Keyword("d")) mtl.d = t.ReadFloat();
+			else if(t.Keyword("illum")) mtl.illum = t.ReadInt();
+			else if(t.Keyword("Ka"))
+			{
+				for(GLuint i = 0; i < 3; i++) mtl.ka[i] = t.ReadFloat();
+			}
+			else if(t.Keyword("Kd"))
+			{
+				for(GLuint i = 0; i < 3; i++) mtl.kd[i] = t.ReadFloat();
+			}
+			else if(t.Keyword("Ks"))
+			{
+				for(GLuint i = 0; i < 3; i++) mtl.ks[i] = t.ReadFloat();
+			}
+		}
+
+		t.NextLine();
+	}
+
+	return(true);
+}
+
+const Material* MaterialLibrary::Find(const string &name) const
+{
+	map<string, GLuint>::const_iterator it = lookup.find(name);
+	if(it == lookup.end()) return(NULL);
+	return(&materials[it->second]);
+}
+
+MaterialLibrary* MaterialLibrary::Load(const string &filename)
+{
+	sf::Lock lock(materialCacheMutex);
+
+	map<string, MaterialLibrary*>::iterator it = cache.find(filename);
+	if(it != cache.end()) return(it->second);
+
+	MaterialLibrary *library = new MaterialLibrary();
+	if(!library->Open(filename))
+	{
+		delete library;
+		return(NULL);
+	}
+
+	cache[filename] = library;
+	return(library);
+}
+
+GLvoid MaterialLibrary::ClearCache()
+{
+	sf::Lock lock(materialCacheMutex);
+
+	for(map<string, MaterialLibrary*>::iterator it = cache.begin(); 
+			it != cache.end(); it++) delete it->second;
+	cache.clear();
+}
+
 const string TriangleGroup::ToString() const
 {
 	ostringstream s(ostringstream::out);
@@ -159,8 +269,10 @@ const string TriangleGroup::ToString() const
 		count++;
 	}
 
-	//Now print out the material data for this group
-	s<<endl<<endl<<mtl.ToString();
+	//Now print out the index of the material for this group
+	s<<endl<<endl<<"MATERIAL: ";
+	if(mtl == NO_MATERIAL) s<<"none";
+	else s<<mtl;
 
 	return(s.str());
 }
@@ -170,15 +282,110 @@ TriangleGroup::~TriangleGroup()
 	//Clear the indices vector and deallocate memory
 	indices.clear(); vector<GLuint>().swap(indices);
 
-	//Delete the index buffer object
-	glDeleteBuffers(1, &ibo);
+	//Delete the vertex array and index buffer objects, if they were ever
+	//created
+	if(vao != 0) GLState::DeleteVertexArrays(1, &vao);
+	if(ibo != 0) GLState::DeleteBuffers(1, &ibo);
+}
+
+Mesh::Mesh()
+{
+	vbo = 0, numVerts = 0, format = VERTEX_FORMAT_FLOAT, culled = false;
+	lod = 0, materialStride = 0;
 }
 
-GLboolean Mesh::Open(const string &filename)
+GLboolean Mesh::Open(const string &filename, GLuint flags)
 {
 	//Deallocate previous mesh resources, if any exist
 	Close();
 
+	//Time the parsing so different load paths can be compared
+	sf::Clock timer;
+	stats = MeshLoadStats();
+
+	//The binary cache holds the fully loaded mesh, there's nothing else to
+	//do if it's valid
+	if((flags & MESH_LOAD_CACHE) && OpenCache(filename, 
+				flags & MESH_CACHE_FLAGS))
+	{
+		stats.parseTime = timer.getElapsedTime().asSeconds();
+		return(true);
+	}
+
+	GLboolean status;
+	if(flags & MESH_LOAD_PARALLEL) status = ParseParallel(filename, flags);
+	else if(flags & (MESH_LOAD_MAPPED | MESH_LOAD_WELD)) 
+		status = ParseMapped(filename, flags);
+	else status = ParseStream(filename);
+	stats.parseTime = timer.getElapsedTime().asSeconds();
+	if(!status) return(false);
+
+	if(flags & MESH_LOAD_OPTIMIZE) 
+	{
+		OptimizeIndices();
+		RemapVertices();
+	}
+	CalculateBounds();
+
+	//The cache holds the final arrays, so the normals have to be calculated
+	//before it's written
+	if(flags & MESH_LOAD_CACHE)
+	{
+		CalculateNormals();
+		stats.cacheWritten = MeshCache::Write(*this, filename, 
+			flags & MESH_CACHE_FLAGS);
+	}
+
+	return(true);
+}
+
+GLboolean Mesh::OpenCache(const string &filename, GLuint flags)
+{
+	if(!cache.Open(filename, flags)) return(false);
+
+	const MeshCacheHeader &h = *cache.header;
+	numVerts = h.numVerts;
+	bounds.min = Vector3(h.min[0], h.min[1], h.min[2]);
+	bounds.max = Vector3(h.max[0], h.max[1], h.max[2]);
+	sphere.center = Vector3(h.center[0], h.center[1], h.center[2]);
+	sphere.radius = h.radius;
+
+	//The index arrays stay in the mapped file until CreateBufferObjects(),
+	//the bounds were calculated before the cache was written
+	g.resize(h.numGroups);
+	for(GLuint i = 0; i < h.numGroups; i++)
+	{
+		const MeshCacheGroup &c = cache.groups[i];
+		g[i].count = c.count;
+		g[i].bounds.min = Vector3(c.min[0], c.min[1], c.min[2]);
+		g[i].bounds.max = Vector3(c.max[0], c.max[1], c.max[2]);
+		g[i].sphere.center = Vector3(c.center[0], c.center[1], c.center[2]);
+		g[i].sphere.radius = c.radius;
+	}
+
+	//The materials are looked up in their MTL files again, so edits to the
+	//MTL files show up without rewriting the cache. UseMaterial() builds 
+	//the same table the OBJ file did, unless materials were removed.
+	for(GLuint i = 0; i < h.numGroups; i++)
+	{
+		GLuint m = cache.groups[i].mtl;
+		if(m == NO_MATERIAL) continue;
+		if(!UseMaterial(g[i], cache.materialNames[2*m], 
+				cache.materialNames[2*m+1]))
+		{
+			Close();
+			return(false);
+		}
+	}
+
+	stats.bytes = cache.file.size;
+	stats.fromCache = true;
+
+	return(true);
+}
+
+GLboolean Mesh::ParseStream(const string &filename)
+{
 	//We need at most two files, the OBJ and MTL files
 	ifstream file;
 	string mtlfilename;
@@ -190,6 +397,12 @@ GLboolean Mesh::Open(const string &filename)
 	//Open the OBJ file here, read only!
 	file.open(filename.c_str(), ifstream::in);
 	if(!file.is_open() || !file.good()) return(false);
+
+	//Get the size of the file for the load statistics
+	file.seekg(0, ifstream::end);
+	stats.bytes = file.tellg();
+	stats.threads = 1;
+	file.seekg(0, ifstream::beg);
 	
 	//If we encounter another group we have to set this variable
 	//to true so we don't skip the group the next time around the loop
@@ -215,8 +428,9 @@ GLboolean Mesh::Open(const string &filename)
 				if(buf[1] == 't')
 				{
 					istringstream s(buf.substr(3), istringstream::in);
-					s >> x >> y >> z;
-					vt.push_back(Vector3(x, y, z));
+					s >> x >> y;
+					Vec2f uv = {{x, y}};
+					vt.push_back(uv);
 				}
 				//Add the normal vertex to the vector
 				else if(buf[1] == 'n')
@@ -269,18 +483,27 @@ GLboolean Mesh::Open(const string &filename)
 							//vertex index as the normal and texture
 							//coordinates will be generated manually
 							//to fit our needs
+							vector<GLuint> polygon;
 							size_t pos = buf.find_first_of(' ', 0);
 							while(pos != string::npos)
 							{
-								//Add the index to the indices vector of the
-								//group
 								istringstream s(buf.substr(pos+1), 
 										istringstream::in);
 								GLfloat index;
 								s >> index;
-								temp.indices.push_back(index-1);
+								polygon.push_back(index-1);
 								pos = buf.find_first_of(' ', pos+1);
 							}
+
+							//Polygons are split into a fan of triangles 
+							//around the first corner, in the same order 
+							//as the mapped parser
+							for(size_t c = 2; c < polygon.size(); c++)
+							{
+								temp.indices.push_back(polygon[0]);
+								temp.indices.push_back(polygon[c-1]);
+								temp.indices.push_back(polygon[c]);
+							}
 							break;
 						}
 
@@ -291,20 +514,12 @@ GLboolean Mesh::Open(const string &filename)
 							//One MTL file may hold multiple definitions
 							string matname = buf.substr(7);
 							
-							//We have to make sure that the MTL file exists
-							//TODO: So multiple groups may use the same 
-							//material. We could save memory by allowing groups
-							//to reference the same material structure. How? 
-							//Well maybe have a Material vector in the mesh 
-							//class with each material in the vector having a
-							//unique id, such as the material name, and then if
-							//the material specified is already in the vector,
-							//just make the group reference that! However, 
-							//the material struct is pretty small, so maybe not
-							// nescessary. 
+							//We have to make sure that the MTL file exists.
+							//Groups using the same material share one entry
+							//of the mesh's material table.
 							if(!mtlfilename.empty())
 							{
-								if(!temp.mtl.Open(mtlfilename, matname))
+								if(!UseMaterial(temp, mtlfilename, matname))
 									return(false);
 							}
 							else {return(false);}
@@ -342,136 +557,1461 @@ GLboolean Mesh::Open(const string &filename)
 	//equal to this value
 	numVerts = v.size();
 
-	//Merge the vector array with the normal array, creating an interleaved
-	//array
-
 	return(true);
 }	
 
-GLvoid Mesh::CreateBufferObjects()
+//A run of faces parsed from one chunk of an OBJ file. Every 'g' line starts
+//a new segment. A chunk's first segment may instead continue the group that
+//was current at the end of the previous chunk.
+struct ObjSegment {
+	GLboolean startsGroup; //Started by a 'g' line
+	GLboolean hasMaterial; //A usemtl line was found in the segment
+	string matname; //The last material used in the segment
+	string mtlfilename; //The MTL file given in this chunk before matname
+	vector<GLuint> indices; //Zero based vertex indices
+	vector<GLuint> tindices; //Zero based texture coordinate indices, only
+	                         //when welding
+	vector<GLuint> nindices; //Zero based normal indices, only when welding
+	vector<size_t> relative[3]; //Positions in indices, tindices and nindices
+	                            //that are relative to the first vertex, 
+	                            //texture coordinate and normal of the chunk
+	GLuint group; //The group in the mesh the indices belong to
+	size_t offset; //Where the indices go in the group's index array
+	GLboolean whole; //The segment is the only one of its group, so its
+	                 //arrays can be handed over
+};
+
+//One corner of a face, made of the zero based indices of its vertex,
+//texture coordinate and normal
+struct ObjCorner {
+	GLuint index[3]; //NO_INDEX if the corner has no such attribute
+	GLboolean relative[3]; //The index is relative to the start of the chunk
+};
+
+//The parsed contents of one chunk of an OBJ file. Chunks always start and 
+//end at line boundaries.
+struct ObjChunk {
+	const GLchar *begin, *end; //The range of the mapped file to parse
+	GLboolean weld; //Keep texture coordinate and normal indices
+	vector<Vector3> v; //Vertices defined in the chunk
+	vector<Vec2f> vt; //Texture coordinates defined in the chunk
+	vector<Vector3> vn; //Normals defined in the chunk, only when welding
+	vector<ObjCorner> polygon; //Scratch space for the face being parsed
+	deque<ObjSegment> segments; //Deques don't copy elements when they grow
+	string mtlfilename; //The last MTL file given in the chunk
+	size_t offset[3]; //Where the vertex arrays go in the merged arrays
+};
+
+//The chunks being merged and the arrays they are merged into. Welding needs
+//the texture coordinates and normals of every corner of every face, which
+//are merged into temporary arrays until the mesh's vertices are built.
+struct ObjMerge {
+	vector<ObjChunk> chunks; //The parsed chunks, in file order
+	Mesh *mesh; //Receives the vertices, texture coordinates and indices
+	vector<Vector3> vn; //The normals, only when welding
+	vector< vector<GLuint> > tindices; //Texture coordinate indices by group
+	vector< vector<GLuint> > nindices; //Normal indices by group
+};
+
+//Appends a new, empty segment to the chunk
+static ObjSegment* NewObjSegment(ObjChunk &chunk, GLboolean startsGroup)
 {
-	//Generate buffer ids
-	glGenBuffers(1, &vbo);
+	chunk.segments.push_back(ObjSegment());
+	ObjSegment &segment = chunk.segments.back();
+	segment.startsGroup = startsGroup, segment.hasMaterial = false;
+	segment.group = 0, segment.offset = 0, segment.whole = false;
+	return(&segment);
+}
 
-	//Upload the vertex data from the vector container to the GPU
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, v.size()*sizeof(Vector3), &(v.front()),
-		GL_STATIC_DRAW);
+//Converts a one based OBJ index into a zero based index. Negative indices 
+//count back from the last element read, which earlier chunks may hold, so 
+//they're made relative to the chunk's first element and fixed up during the
+//merge.
+static GLuint ResolveObjIndex(GLint index, size_t count, GLboolean &relative)
+{
+	relative = (index < 0);
+	if(index == 0) return(NO_INDEX);
+	return((index < 0) ? count+index : index-1);
+}
 
-	//We may or may not have multiple groups. Loop through each group and
-	//create a buffer ID for the group and upload the indices to the GPU
-	for(vector<TriangleGroup>::iterator it=g.begin(); it<g.end(); it++)
+//Adds a corner of a triangle to the segment
+static GLvoid AddObjCorner(const ObjChunk &chunk, ObjSegment &segment, 
+		const ObjCorner &corner)
+{
+	vector<GLuint> *arrays[3] = {&segment.indices, &segment.tindices,
+		&segment.nindices};
+	for(GLuint a = 0; a < (chunk.weld ? 3 : 1); a++)
 	{
-		glGenBuffers(1, &(it->ibo));
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, 
-			it->indices.size()*sizeof(GLuint), &(it->indices.front()),
-			GL_STATIC_DRAW);
+		if(corner.relative[a]) segment.relative[a].push_back(arrays[a]->size());
+		arrays[a]->push_back(corner.index[a]);
 	}
 }
 
-GLvoid Mesh::CalculateNormals()
+//Parses one chunk of an OBJ file. Runs as a Parallel::For task.
+static GLvoid ParseObjChunk(GLuint index, GLvoid *data)
 {
-	//Reserve memory, we already know the size of the vector (same number of
-	//normals as vertices)
-	v.reserve(v.size()+numVerts);
-	
-	//Reset all normals to zero vectors
-	for(GLuint i = 0; i < numVerts; i++) v.push_back(Vector3());
+	ObjChunk &chunk = ((ObjMerge*)data)->chunks[index];
 
-	//Loop through each triangle group
-	for(vector<TriangleGroup>::const_iterator grp=g.begin();grp<g.end();grp++)
+	//The segment faces and materials are currently added to. It is only 
+	//created once something is added to it.
+	ObjSegment *segment = NULL;
+
+	Tokenizer t(chunk.begin, chunk.end);
+	while(!t.Done())
 	{
-		//Loop every third index, a group of three indices is one face
-		for(vector<GLuint>::const_iterator i=grp->indices.begin();
-				i<grp->indices.end(); i+=3)
+		switch(*t.pos)
 		{
-			//Calculate the normal via cross product of (a-c)x(b-c)
-			Vector3 normal=(v[*i]-v[*(i+2)]).CrossProduct(v[*(i+1)]-v[*(i+2)]);
-
-			//Add the normal to the normal already contained within
-			//the interleaved array
-			v[*i+numVerts] += normal;
-			v[*(i+1)+numVerts] += normal;
-			v[*(i+2)+numVerts] += normal;
+			//A vertex, a texture coordinate or a normal. Unless we are
+			//welding, normals are generated by CalculateNormals() so they
+			//are skipped here.
+			case 'v':
+			{
+				if(t.Keyword("v"))
+				{
+					GLfloat x = t.ReadFloat(), y = t.ReadFloat();
+					chunk.v.push_back(Vector3(x, y, t.ReadFloat()));
+				}
+				else if(t.Keyword("vt"))
+				{
+					//The optional w coordinate is never used
+					GLfloat x = t.ReadFloat();
+					Vec2f uv = {{x, t.ReadFloat()}};
+					chunk.vt.push_back(uv);
+				}
+				else if(chunk.weld && t.Keyword("vn"))
+				{
+					GLfloat x = t.ReadFloat(), y = t.ReadFloat();
+					chunk.vn.push_back(Vector3(x, y, t.ReadFloat()));
+				}
+				break;
+			}
+
+			//A face made of v, v/vt, v//vn or v/vt/vn corners. Polygons
+			//are split into a fan of triangles around the first corner.
+			case 'f':
+			{
+				if(!t.Keyword("f")) break;
+				if(segment == NULL) segment = NewObjSegment(chunk, false);
+
+				chunk.polygon.clear();
+				while(!t.EndOfLine())
+				{
+					GLint i[3] = {t.ReadInt(), 0, 0};
+					if(t.pos < t.end && *t.pos == '/')
+					{
+						t.pos++;
+						if(t.pos < t.end && *t.pos != '/') i[1] = t.ReadInt();
+						if(t.pos < t.end && *t.pos == '/') 
+						{
+							t.pos++;
+							i[2] = t.ReadInt();
+						}
+					}
+					t.SkipToken();
+
+					ObjCorner corner;
+					corner.index[0] = ResolveObjIndex(i[0], chunk.v.size(),
+						corner.relative[0]);
+					corner.index[1] = ResolveObjIndex(i[1], chunk.vt.size(),
+						corner.relative[1]);
+					corner.index[2] = ResolveObjIndex(i[2], chunk.vn.size(),
+						corner.relative[2]);
+					chunk.polygon.push_back(corner);
+				}
+
+				for(size_t c = 2; c < chunk.polygon.size(); c++)
+				{
+					AddObjCorner(chunk, *segment, chunk.polygon[0]);
+					AddObjCorner(chunk, *segment, chunk.polygon[c-1]);
+					AddObjCorner(chunk, *segment, chunk.polygon[c]);
+				}
+				break;
+			}
+
+			//A new group, all following faces belong to it
+			case 'g':
+			{
+				if(t.Keyword("g")) segment = NewObjSegment(chunk, true);
+				break;
+			}
+
+			//The MTL file holding the material definitions
+			case 'm':
+			{
+				if(t.Keyword("mtllib")) chunk.mtlfilename = t.ReadLine();
+				break;
+			}
+
+			//A material for the current group
+			case 'u':
+			{
+				if(!t.Keyword("usemtl")) break;
+				if(segment == NULL) segment = NewObjSegment(chunk, false);
+				segment->hasMaterial = true;
+				segment->matname = t.ReadLine();
+				segment->mtlfilename = chunk.mtlfilename;
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
 		}
+
+		t.NextLine();
 	}
+}
 
-	//Now normalize each normal
-	for(GLuint i = numVerts; i < v.size(); i++) v[i] = v[i].Normalize();
-}	
+//Copies one array of a chunk into its place in the merged array
+template<typename T>
+static GLvoid CopyObjArray(vector<T> &from, vector<T> &to, size_t offset,
+		GLboolean single)
+{
+	//A single chunk can simply hand over its array
+	if(single) to.swap(from);
+	else copy(from.begin(), from.end(), to.begin()+offset);
+	vector<T>().swap(from);
+}
 
-GLvoid Mesh::Close()
+//Copies the index array of a segment into its place in the group's index
+//array and fixes up relative indices
+static GLvoid CopyObjIndices(vector<GLuint> &from, vector<GLuint> &to,
+		const ObjSegment &segment, const vector<size_t> &relative, 
+		size_t offset)
 {
-	//Delete all previously used resources
-	//Delete all the vector containers and deallocate the memory they hold
-	v.clear(); vector<Vector3>().swap(v);
-	vt.clear(); vector<Vector3>().swap(vt);
-	
-	//Delete the trianglegroup container. Remember calling clear will call
-	//the destructors for each of the elements in the vector!
-	g.clear(); vector<TriangleGroup>().swap(g);
+	//Groups made of a single segment have an empty index array that can be
+	//swapped with the segment's. The arrays of other groups were allocated
+	//by MergeObjChunks() and are only written in place, as several chunks
+	//copy into them at once.
+	if(segment.whole) to.swap(from);
+	else copy(from.begin(), from.end(), to.begin()+segment.offset);
 
-	// Delete buffer objects
-	glDeleteBuffers(1, &vbo);
+	for(vector<size_t>::const_iterator r = relative.begin(); 
+			r < relative.end(); r++)
+		to[segment.offset+*r] += offset;
 }
 
-const string Mesh::ToString() const
+//Copies the arrays of one chunk into their place in the mesh and fixes up
+//relative indices. Runs as a Parallel::For task.
+static GLvoid CopyObjChunk(GLuint index, GLvoid *data)
 {
-	ostringstream s(ostringstream::out);
+	ObjMerge &merge = *(ObjMerge*)data;
+	ObjChunk &chunk = merge.chunks[index];
+	Mesh &mesh = *merge.mesh;
+	GLboolean single = (merge.chunks.size() == 1);
 
-	//Print the # of vertices and groups into the string stream
-	s<<left<<setfill('/')<<setw(68)<<"/"<<setfill(' ')<<endl;
-	s<<setw(15)<<"# OF VERTICES"<<": "<<v.size()<<endl;
-	s<<setw(15)<<"# OF GROUPS"<<": "<<g.size();
-	
-	//Now Print out the list of vertices
-	s<<endl<<setfill('=')<<setw(68)<<'='<<setfill(' ')<<endl;
-	s<<"LIST OF VERTICES"<<endl<<setfill('-')<<setw(16)<<'-'<<setfill(' ');
-	for(GLuint i = 0; i < numVerts; i++)
-	{
-		s << endl << v[i].ToString();
-	}
+	CopyObjArray(chunk.v, mesh.v, chunk.offset[0], single);
+	CopyObjArray(chunk.vt, mesh.vt, chunk.offset[1], single);
+	if(chunk.weld) CopyObjArray(chunk.vn, merge.vn, chunk.offset[2], single);
 
-	//Loop through each group and print the number of indices in each group
-	//and the indices it self in groups of three
-	for(vector<TriangleGroup>::const_iterator k=g.begin(); k<g.end(); k++)
+	for(deque<ObjSegment>::iterator s = chunk.segments.begin(); 
+			s < chunk.segments.end(); s++)
 	{
-		s<<endl<<setfill('=')<<setw(68)<<'='<<setfill(' ')<<endl;
-		s<<k->ToString();
+		CopyObjIndices(s->indices, mesh.g[s->group].indices, *s, 
+			s->relative[0], chunk.offset[0]);
+		if(!chunk.weld) continue;
+		CopyObjIndices(s->tindices, merge.tindices[s->group], *s,
+			s->relative[1], chunk.offset[1]);
+		CopyObjIndices(s->nindices, merge.nindices[s->group], *s,
+			s->relative[2], chunk.offset[2]);
 	}
-	s<<endl<<setfill('/')<<setw(68)<<"/"<<setfill(' ');
 
-	return(s.str());
+	//Free the chunk's memory as soon as possible, big files need it
+	deque<ObjSegment>().swap(chunk.segments);
 }
 
-Mesh::~Mesh()
+//Hashes a (vertex, texture coordinate, normal) index triple
+static GLuint HashObjCorner(GLuint v, GLuint vt, GLuint vn)
 {
-	Close();
+	GLuint h = v*0x9E3779B1u;
+	h ^= (vt*0x85EBCA77u) + (h<<6) + (h>>2);
+	h ^= (vn*0xC2B2AE3Du) + (h<<6) + (h>>2);
+	return(h ^ (h>>16));
 }
 
-//TEMPORARY!
-GLvoid Mesh::Draw() const
+//Replaces the merged arrays with one vertex per unique (vertex, texture
+//coordinate, normal) triple. The triples are deduplicated with an open 
+//addressing hash table using linear probing.
+static GLvoid WeldObjVertices(ObjMerge &merge, MeshLoadStats &stats)
 {
-	//Bind the vertex buffer and set the vertex pointer to the binded buffer
-	//All the groups contain indices to only one set of vertices
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glVertexAttribPointer(0,4,GL_FLOAT,GL_FALSE,sizeof(Vector3),(GLvoid*)0);
-	glVertexAttribPointer(1,4,GL_FLOAT,GL_FALSE,sizeof(Vector3),(GLvoid*)((uintptr_t)numVerts));
-	
-	//Loop through each group and bind the index buffer and set the index
-	//pointer. Then draw the elements as triangles using the indices
-	for(vector<TriangleGroup>::const_iterator it=g.begin(); it<g.end(); it++)
+	Mesh &mesh = *merge.mesh;
+
+	//Start with room for about as many unique vertices as there are 
+	//positions, which is typical, and grow when the table is half full
+	GLuint capacity = 16;
+	while(capacity < 2*mesh.v.size() && capacity < 0x80000000u) capacity *= 2;
+	vector<GLuint> table(capacity, NO_INDEX);
+	vector<GLuint> keys; //Three indices per unique vertex
+
+	//The file's normals are only kept if every corner has one, otherwise
+	//CalculateNormals() replaces them and they must not split vertices
+	GLboolean hasTexcoords = false, hasNormals = true;
+	for(GLuint grp = 0; grp < mesh.g.size() && hasNormals; grp++)
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->ibo);
-		glDrawElements(GL_TRIANGLES, it->indices.size(), GL_UNSIGNED_INT,
-			(GLvoid*)0);
+		const vector<GLuint> &nindices = merge.nindices[grp];
+		hasNormals = (find(nindices.begin(), nindices.end(), NO_INDEX) == 
+			nindices.end());
 	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
+	for(GLuint grp = 0; grp < mesh.g.size(); grp++)
+	{
+		vector<GLuint> &indices = mesh.g[grp].indices;
+		const vector<GLuint> &tindices = merge.tindices[grp];
+		const vector<GLuint> &nindices = merge.nindices[grp];
+		stats.corners += indices.size();
+
+		for(size_t i = 0; i < indices.size(); i++)
+		{
+			GLuint v = indices[i], vt = tindices[i];
+			GLuint vn = hasNormals ? nindices[i] : NO_INDEX;
+			hasTexcoords = hasTexcoords || (vt != NO_INDEX);
+
+			GLuint mask = table.size()-1, h = HashObjCorner(v, vt, vn) & mask;
+			while(table[h] != NO_INDEX)
+			{
+				const GLuint *key = &keys[3*table[h]];
+				if(key[0] == v && key[1] == vt && key[2] == vn) break;
+				h = (h+1) & mask;
+			}
+
+			if(table[h] == NO_INDEX)
+			{
+				table[h] = keys.size()/3;
+				keys.push_back(v), keys.push_back(vt), keys.push_back(vn);
+
+				//Keep the load factor under one half, rehash into a table
+				//twice the size
+				if(keys.size()/3 > table.size()/2)
+				{
+					vector<GLuint> larger(table.size()*2, NO_INDEX);
+					GLuint lmask = larger.size()-1;
+					for(GLuint k = 0; k < keys.size()/3; k++)
+					{
+						GLuint lh = HashObjCorner(keys[3*k], keys[3*k+1],
+							keys[3*k+2]) & lmask;
+						while(larger[lh] != NO_INDEX) lh = (lh+1) & lmask;
+						larger[lh] = k;
+					}
+					table.swap(larger);
+					indices[i] = keys.size()/3-1;
+					continue;
+				}
+			}
+			indices[i] = table[h];
+		}
+
+		//The corner arrays aren't needed anymore
+		vector<GLuint>().swap(merge.tindices[grp]);
+		vector<GLuint>().swap(merge.nindices[grp]);
+	}
+	vector<GLuint>().swap(table);
+
+	//Build the vertex array from the unique triples. Out of range indices
+	//(broken files) get zero vectors. If every corner has a normal, the
+	//normals follow the vertices like CalculateNormals() would put them.
+	GLuint count = keys.size()/3;
+	stats.uniqueVerts = count;
+	if(count == 0) hasNormals = false;
+
+	vector<Vector3> v(hasNormals ? 2*count : count);
+	vector<Vec2f> vt;
+	Vec2f zero = {{0.0f, 0.0f}};
+	if(hasTexcoords) vt.resize(count, zero);
+	for(GLuint k = 0; k < count; k++)
+	{
+		const GLuint *key = &keys[3*k];
+		if(key[0] < mesh.v.size()) v[k] = mesh.v[key[0]];
+		if(hasTexcoords && key[1] < mesh.vt.size()) vt[k] = mesh.vt[key[1]];
+		if(hasNormals && key[2] < merge.vn.size()) 
+			v[count+k] = merge.vn[key[2]];
+	}
+
+	mesh.v.swap(v);
+	mesh.vt.swap(vt);
+	vector<Vector3>().swap(merge.vn);
+}
+
+//Stitches the parsed chunks together in file order
+static GLboolean MergeObjChunks(ObjMerge &merge, MeshLoadStats &stats)
+{
+	Mesh &mesh = *merge.mesh;
+	GLboolean weld = merge.chunks.front().weld;
+
+	//Find where each chunk's vertices go and which group each segment 
+	//belongs to. A segment that doesn't start with a 'g' line continues the
+	//current group, which may have been started in an earlier chunk.
+	size_t count[3] = {0, 0, 0};
+	vector<size_t> sizes;
+	vector<GLuint> segmentCounts;
+	for(vector<ObjChunk>::iterator c = merge.chunks.begin(); 
+			c < merge.chunks.end(); c++)
+	{
+		c->offset[0] = count[0], c->offset[1] = count[1];
+		c->offset[2] = count[2];
+		count[0] += c->v.size(), count[1] += c->vt.size();
+		count[2] += c->vn.size();
+
+		for(deque<ObjSegment>::iterator s = c->segments.begin(); 
+				s < c->segments.end(); s++)
+		{
+			if(s->startsGroup || sizes.empty()) 
+			{
+				sizes.push_back(0);
+				segmentCounts.push_back(0);
+			}
+			s->group = sizes.size()-1;
+			s->offset = sizes.back();
+			sizes.back() += s->indices.size();
+			segmentCounts.back()++;
+		}
+	}
+	mesh.g.resize(sizes.size());
+	for(vector<ObjChunk>::iterator c = merge.chunks.begin(); 
+			c < merge.chunks.end(); c++)
+	{
+		for(deque<ObjSegment>::iterator s = c->segments.begin(); 
+				s < c->segments.end(); s++)
+			s->whole = (segmentCounts[s->group] == 1);
+	}
+
+	//Load the materials in file order so the last usemtl of a group wins
+	string mtlfilename;
+	for(vector<ObjChunk>::iterator c = merge.chunks.begin(); 
+			c < merge.chunks.end(); c++)
+	{
+		for(deque<ObjSegment>::iterator s = c->segments.begin(); 
+				s < c->segments.end(); s++)
+		{
+			if(!s->hasMaterial) continue;
+			if(!s->mtlfilename.empty()) mtlfilename = s->mtlfilename;
+			if(mtlfilename.empty()) return(false);
+			if(!mesh.UseMaterial(mesh.g[s->group], mtlfilename, s->matname))
+				return(false);
+		}
+		if(!c->mtlfilename.empty()) mtlfilename = c->mtlfilename;
+	}
+
+	//Allocate the arrays once and let every chunk copy its data in parallel
+	if(merge.chunks.size() > 1)
+	{
+		mesh.v.resize(count[0]);
+		mesh.vt.resize(count[1]);
+		if(weld) merge.vn.resize(count[2]);
+	}
+	if(weld)
+	{
+		merge.tindices.resize(sizes.size());
+		merge.nindices.resize(sizes.size());
+	}
+	for(GLuint i = 0; i < sizes.size(); i++)
+	{
+		if(segmentCounts[i] <= 1) continue;
+		mesh.g[i].indices.resize(sizes[i]);
+		if(!weld) continue;
+		merge.tindices[i].resize(sizes[i]);
+		merge.nindices[i].resize(sizes[i]);
+	}
+	Parallel::For(merge.chunks.size(), &CopyObjChunk, &merge);
+
+	//Get the number of vertices in the array. When welding, normals read
+	//from the file may follow them.
+	mesh.numVerts = mesh.v.size();
+	if(weld) 
+	{
+		WeldObjVertices(merge, stats);
+		mesh.numVerts = stats.uniqueVerts;
+	}
+
+	return(true);
+}
+
+GLboolean Mesh::ParseMapped(const string &filename, GLuint flags)
+{
+	MappedFile file;
+	if(!file.Open(filename)) return(false);
+	stats.bytes = file.size;
+	stats.threads = 1;
+
+	//The whole file is parsed as one chunk
+	ObjMerge merge;
+	merge.mesh = this;
+	merge.chunks.resize(1);
+	merge.chunks[0].begin = file.data;
+	merge.chunks[0].end = file.data+file.size;
+	merge.chunks[0].weld = ((flags & MESH_LOAD_WELD) != 0);
+	ParseObjChunk(0, &merge);
+
+	return(MergeObjChunks(merge, stats));
+}
+
+GLboolean Mesh::ParseParallel(const string &filename, GLuint flags)
+{
+	MappedFile file;
+	if(!file.Open(filename)) return(false);
+	stats.bytes = file.size;
+	stats.threads = Parallel::ThreadCount();
+
+	//A few chunks per thread balance the load, but chunks shouldn't be so 
+	//small that merging them costs more than parsing them
+	size_t count = stats.threads*4;
+	if(count > file.size/OBJ_MIN_CHUNK_SIZE) 
+		count = file.size/OBJ_MIN_CHUNK_SIZE;
+	if(count == 0) count = 1;
+
+	//Split the file into roughly equal chunks, moving each split point
+	//forward to the start of the next line
+	ObjMerge merge;
+	merge.mesh = this;
+	merge.chunks.resize(count);
+	const GLchar *begin = file.data, *end = file.data+file.size;
+	for(size_t i = 0; i < count; i++)
+	{
+		const GLchar *split = (i+1 == count) ? end : 
+			file.data+(file.size/count)*(i+1);
+		if(split < begin) split = begin;
+		if(split < end)
+		{
+			split = (const GLchar*)memchr(split, '\n', end-split);
+			split = (split == NULL) ? end : split+1;
+		}
+		merge.chunks[i].begin = begin, merge.chunks[i].end = split;
+		merge.chunks[i].weld = ((flags & MESH_LOAD_WELD) != 0);
+		begin = split;
+	}
+
+	Parallel::For(merge.chunks.size(), &ParseObjChunk, &merge);
+
+	return(MergeObjChunks(merge, stats));
+}
+
+GLboolean Mesh::UseMaterial(TriangleGroup &grp, const string &mtlfilename,
+		const string &matname)
+{
+	MaterialLibrary *library = MaterialLibrary::Load(mtlfilename);
+	if(library == NULL) return(false);
+
+	//Unknown materials get the default material
+	const Material *mtl = library->Find(matname);
+	if(mtl == NULL) {grp.mtl = NO_MATERIAL; return(true);}
+
+	//Reuse the table entry if another group uses the same material already.
+	//Meshes rarely have more than a few hundred materials so a linear search
+	//is fast enough.
+	for(GLuint i = 0; i < materials.size(); i++)
+	{
+		if(materials[i] == mtl) {grp.mtl = i; return(true);}
+	}
+	grp.mtl = materials.size();
+	materials.push_back(mtl);
+	materialNames.push_back(mtlfilename);
+	materialNames.push_back(matname);
+
+	return(true);
+}
+
+const Material& Mesh::GetMaterial(const TriangleGroup &grp) const
+{
+	static const Material defaultMaterial;
+	if(grp.mtl >= materials.size()) return(defaultMaterial);
+	return(*materials[grp.mtl]);
+}
+
+const Vector3* Mesh::Vertices() const
+{
+	if(cache.header != NULL) return(cache.vertices);
+	return(v.empty() ? NULL : &v.front());
+}
+
+const Vec2f* Mesh::Texcoords() const
+{
+	if(numVerts == 0) return(NULL);
+	if(cache.header != NULL) 
+	{
+		return((cache.header->numTexcoords == numVerts) ? cache.texcoords :
+			NULL);
+	}
+	return((vt.size() == numVerts) ? &vt.front() : NULL);
+}
+
+//Returns the indices of a group, from the vector container or the mapped 
+//cache
+static const GLuint* GroupIndices(const Mesh &mesh, GLuint index, 
+		size_t &count)
+{
+	if(mesh.cache.header != NULL)
+	{
+		count = mesh.cache.groups[index].count;
+		return(mesh.cache.Indices(index));
+	}
+	const TriangleGroup &grp = mesh.g[index];
+	count = grp.indices.size();
+	return(grp.indices.empty() ? NULL : &grp.indices.front());
+}
+
+GLvoid Mesh::CalculateBounds()
+{
+	bounds.Reset();
+	const Vector3 *vertices = Vertices();
+	sphere = BoundingSphere();
+	for(GLuint i = 0; i < numVerts; i++) bounds.Add(vertices[i]);
+	if(!bounds.Empty()) 
+	{
+		sphere.center = bounds.Center();
+		for(GLuint i = 0; i < numVerts; i++) 
+			sphere.radius = max(sphere.radius, 
+				sphere.center.Distance(vertices[i]));
+	}
+
+	//Each group only covers the vertices it indexes. Vertices shared by
+	//several groups are visited once per group.
+	for(GLuint i = 0; i < g.size(); i++)
+	{
+		TriangleGroup &grp = g[i];
+		size_t count;
+		const GLuint *indices = GroupIndices(*this, i, count);
+		grp.bounds.Reset();
+		grp.sphere = BoundingSphere();
+		for(size_t j = 0; j < count; j++) grp.bounds.Add(vertices[indices[j]]);
+		if(grp.bounds.Empty()) continue;
+		grp.sphere.center = grp.bounds.Center();
+		for(size_t j = 0; j < count; j++)
+		{
+			grp.sphere.radius = max(grp.sphere.radius, 
+				grp.sphere.center.Distance(vertices[indices[j]]));
+		}
+	}
+}
+
+//Points the vertex attributes at the bound VBO, recorded by the bound vertex
+//array object
+static GLvoid SetVertexLayout(GLuint format, GLuint numVerts, 
+	GLboolean normals)
+{
+	glEnableVertexAttribArray(0);
+	if(format == VERTEX_FORMAT_QUANTIZED)
+	{
+		//The normals aren't normalized by GL, the conversion of signed
+		//normalized integers differs between OpenGL versions
+		GLsizei stride = sizeof(QuantizedVertex);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, 
+			(GLvoid*)offsetof(QuantizedVertex, position));
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_FALSE, stride,
+			(GLvoid*)offsetof(QuantizedVertex, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+			(GLvoid*)offsetof(QuantizedVertex, texcoord));
+		return;
+	}
+
+	//The normals follow all the vertices. Without them attribute 1 stays
+	//disabled and the shader reads its constant value instead of whatever
+	//lies past the vertices
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vector3), 
+		(GLvoid*)0);
+	if(!normals) return;
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vector3),
+		(GLvoid*)(numVerts*sizeof(Vector3)));
+}
+
+GLvoid Mesh::CreateVertexArrays()
+{
+	//Each group's vertex array object records the attribute pointers into
+	//the VBO and the group's index buffer. Vertex arrays aren't shared 
+	//between contexts, the names of the old ones mean nothing in the 
+	//current context and are simply replaced.
+	GLboolean normals = (cache.header != NULL || v.size() == 2*numVerts);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
+	for(vector<TriangleGroup>::iterator it=g.begin(); it<g.end(); it++)
+	{
+		glGenVertexArrays(1, &it->vao);
+		GLState::BindVertexArray(it->vao);
+		SetVertexLayout(format, numVerts, normals);
+		GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->ibo);
+	}
+
+	//Unbind the last group's vertex array object, so later index buffer
+	//bindings can't change it
+	GLState::BindVertexArray(0);
+}
+
+GLvoid Mesh::CreateBufferObjects(GLuint format)
+{
+	//Generate buffer ids
+	glGenBuffers(1, &vbo);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
+	this->format = format;
+	GLboolean normals = (cache.header != NULL || v.size() == 2*numVerts);
+
+	if(format == VERTEX_FORMAT_QUANTIZED)
+	{
+		//Interleave and quantize the positions, normals and texture 
+		//coordinates, missing normals are left zero
+		const Vector3 *vertices = Vertices();
+		vector<QuantizedVertex> quantized(numVerts);
+		VertexFormat::Quantize(vertices, normals ? vertices+numVerts : NULL,
+			Texcoords(), numVerts, bounds, 
+			quantized.empty() ? NULL : &quantized.front());
+		glBufferData(GL_ARRAY_BUFFER, numVerts*sizeof(QuantizedVertex), 
+			quantized.empty() ? NULL : &quantized.front(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		//Upload the vertex data from the vector container, or straight 
+		//from the mapped cache file, to the GPU
+		GLsizeiptr size = ((cache.header != NULL) ? 2*numVerts : v.size())*
+			sizeof(Vector3);
+		glBufferData(GL_ARRAY_BUFFER, size, Vertices(), GL_STATIC_DRAW);
+	}
+
+	//We may or may not have multiple groups. Loop through each group and
+	//create a buffer ID for the group and upload the indices to the GPU.
+	//The indices are uploaded through GL_ARRAY_BUFFER, binding an element
+	//array buffer would attach it to whichever vertex array is bound.
+	for(GLuint i = 0; i < g.size(); i++)
+	{
+		TriangleGroup &grp = g[i];
+		const GLuint *indices;
+		if(cache.header != NULL) 
+		{
+			indices = cache.Indices(i);
+			grp.count = cache.groups[i].count;
+		}
+		else
+		{
+			indices = grp.indices.empty() ? NULL : &grp.indices.front();
+			grp.count = grp.indices.size();
+		}
+
+		//The levels of detail follow the group's own indices
+		glGenBuffers(1, &grp.ibo);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, grp.ibo);
+		glBufferData(GL_ARRAY_BUFFER, 
+			(grp.count+grp.lodIndices.size())*sizeof(GLuint), NULL, 
+			GL_STATIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, grp.count*sizeof(GLuint),
+			indices);
+		if(!grp.lodIndices.empty())
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, grp.count*sizeof(GLuint),
+				grp.lodIndices.size()*sizeof(GLuint), &grp.lodIndices.front());
+		}
+	}
+	CreateVertexArrays();
+
+	//A Material block for each material and the default material, each 
+	//at an offset the blocks can be bound from
+	Std140 block;
+	vector<GLubyte> blocks;
+	for(GLuint i = 0; i <= materials.size(); i++)
+	{
+		const Material m = (i < materials.size()) ? *materials[i] : 
+			Material();
+		block.Clear();
+		block.AddVec4(m.ka[0], m.ka[1], m.ka[2], 1.0f);
+		block.AddVec4(m.kd[0], m.kd[1], m.kd[2], 1.0f);
+		block.AddVec4(m.ks[0], m.ks[1], m.ks[2], 1.0f);
+		block.AddFloat(m.ns);
+		block.AddFloat(m.d);
+		if(i == 0) materialStride = UniformBuffer::Stride(block.Size());
+		blocks.resize((i+1)*materialStride, 0);
+		memcpy(&blocks[i*materialStride], &block.data.front(), block.Size());
+	}
+	materialBuffer.Create(blocks.size(), &blocks.front(), GL_STATIC_DRAW);
+}
+
+//The groups reordered by OptimizeIndices() and their cache use
+struct OptimizeJob {
+	vector<TriangleGroup> *groups;
+	vector<VertexCacheStats> before;
+	vector<VertexCacheStats> after;
+};
+
+//Reorders the triangles of one group
+static GLvoid OptimizeGroup(GLuint index, GLvoid *data)
+{
+	OptimizeJob &job = *(OptimizeJob*)data;
+	vector<GLuint> &indices = (*job.groups)[index].indices;
+	if(indices.empty()) return;
+
+	job.before[index] = VertexCache::Measure(&indices.front(), indices.size());
+	VertexCache::Optimize(&indices.front(), indices.size());
+	job.after[index] = VertexCache::Measure(&indices.front(), indices.size());
+}
+
+GLvoid Mesh::OptimizeIndices()
+{
+	//The index arrays of a cached mesh are read only
+	if(cache.header != NULL) return;
+
+	sf::Clock timer;
+	OptimizeJob job;
+	job.groups = &g;
+	job.before.resize(g.size());
+	job.after.resize(g.size());
+	Parallel::For(g.size(), &OptimizeGroup, &job);
+
+	stats.vertexCacheBefore = stats.vertexCacheAfter = VertexCacheStats();
+	for(GLuint i = 0; i < g.size(); i++)
+	{
+		stats.vertexCacheBefore.Add(job.before[i]);
+		stats.vertexCacheAfter.Add(job.after[i]);
+	}
+	stats.optimizeTime = timer.getElapsedTime().asSeconds();
+}
+
+//Estimates the vertex fetch cache misses of drawing all the groups, one 
+//after the other
+static VertexFetchStats MeasureFetch(const vector<TriangleGroup> &groups)
+{
+	vector<GLuint> indices;
+	for(GLuint i = 0; i < groups.size(); i++)
+	{
+		indices.insert(indices.end(), groups[i].indices.begin(),
+			groups[i].indices.end());
+	}
+	if(indices.empty()) return(VertexFetchStats());
+	return(VertexCache::MeasureFetch(&indices.front(), indices.size(), 
+		sizeof(Vector3)));
+}
+
+//Moves element i of the array to remap[i]
+template<typename T>
+static GLvoid RemapArray(T *array, const vector<GLuint> &remap)
+{
+	vector<T> old(array, array+remap.size());
+	for(GLuint i = 0; i < remap.size(); i++) array[remap[i]] = old[i];
+}
+
+GLvoid Mesh::RemapVertices()
+{
+	//The vertex and index arrays of a cached mesh are read only
+	if(cache.header != NULL || numVerts == 0) return;
+
+	stats.fetchBefore = MeasureFetch(g);
+	sf::Clock timer;
+
+	//Number the vertices in the order the groups first use them, followed
+	//by the vertices no group uses
+	vector<GLuint> remap(numVerts, NO_INDEX);
+	GLuint next = 0;
+	for(vector<TriangleGroup>::iterator grp=g.begin(); grp<g.end(); grp++)
+	{
+		for(vector<GLuint>::iterator i = grp->indices.begin(); 
+				i < grp->indices.end(); i++)
+		{
+			if(remap[*i] == NO_INDEX) remap[*i] = next++;
+			*i = remap[*i];
+		}
+	}
+	for(GLuint i = 0; i < numVerts; i++)
+		if(remap[i] == NO_INDEX) remap[i] = next++;
+
+	//Move the vertices, normals and texture coordinates to match
+	RemapArray(&v.front(), remap);
+	if(v.size() == 2*numVerts) RemapArray(&v.front()+numVerts, remap);
+	if(vt.size() == numVerts) RemapArray(&vt.front(), remap);
+
+	stats.remapTime = timer.getElapsedTime().asSeconds();
+	stats.fetchAfter = MeasureFetch(g);
+}
+
+//The groups split by BuildMeshlets()
+struct MeshletJob {
+	Mesh *mesh;
+};
+
+//Splits one group into meshlets
+static GLvoid BuildGroupMeshlets(GLuint index, GLvoid *data)
+{
+	Mesh &mesh = *((MeshletJob*)data)->mesh;
+	TriangleGroup &grp = mesh.g[index];
+	size_t count;
+	const GLuint *indices = GroupIndices(mesh, index, count);
+
+	Meshlet::Build(mesh.Vertices(), indices, count, grp.meshlets, 
+		grp.meshletVertices, grp.meshletIndices);
+}
+
+GLvoid Mesh::BuildMeshlets()
+{
+	MeshletJob job;
+	job.mesh = this;
+	Parallel::For(g.size(), &BuildGroupMeshlets, &job);
+}
+
+//Orders vertices by position, so vertices at the same place end up next to
+//each other
+static bool PositionLess(const pair<Vector3, GLuint> &a, 
+		const pair<Vector3, GLuint> &b)
+{
+	if(a.first.x != b.first.x) return(a.first.x < b.first.x);
+	if(a.first.y != b.first.y) return(a.first.y < b.first.y);
+	return(a.first.z < b.first.z);
+}
+
+//The groups simplified by BuildLods() and the vertices they must keep
+struct LodJob {
+	Mesh *mesh;
+	const GLubyte *locked;
+	vector<vector<GLfloat> > errors;
+};
+
+//Simplifies one group and lines its levels of detail up behind its indices
+static GLvoid BuildGroupLods(GLuint index, GLvoid *data)
+{
+	LodJob &job = *(LodJob*)data;
+	TriangleGroup &grp = job.mesh->g[index];
+	size_t count;
+	const GLuint *indices = GroupIndices(*job.mesh, index, count);
+
+	//Every level halves the triangles of the one before
+	vector<size_t> targets;
+	for(GLuint i = 1; i < MESH_LOD_COUNT; i++) 
+		targets.push_back((count/3 >> i)*3);
+	vector<vector<GLuint> > lods;
+	Simplifier::Simplify(job.mesh->Vertices(), job.locked, indices, count,
+		targets, lods, job.errors[index]);
+
+	grp.lodIndices.clear();
+	grp.lods.clear();
+	for(GLuint i = 0; i < lods.size(); i++)
+	{
+		grp.lods.push_back(count+grp.lodIndices.size());
+		grp.lods.push_back(lods[i].size());
+		grp.lodIndices.insert(grp.lodIndices.end(), lods[i].begin(), 
+			lods[i].end());
+	}
+}
+
+GLvoid Mesh::BuildLods()
+{
+	const Vector3 *vertices = Vertices();
+	if(numVerts == 0) return;
+
+	//The groups are simplified on their own, so the vertices they share
+	//must stay or the groups would no longer meet
+	vector<GLubyte> locked(numVerts, 0);
+	vector<GLuint> owner(numVerts, NO_INDEX);
+	for(GLuint i = 0; i < g.size(); i++)
+	{
+		size_t count;
+		const GLuint *indices = GroupIndices(*this, i, count);
+		for(size_t k = 0; k < count; k++)
+		{
+			if(owner[indices[k]] == NO_INDEX) owner[indices[k]] = i;
+			else if(owner[indices[k]] != i) locked[indices[k]] = 1;
+		}
+	}
+
+	//So must welded vertices with the same position but different normals
+	//or texture coordinates, the seam would open if only one of them moved
+	vector<pair<Vector3, GLuint> > sorted(numVerts);
+	for(GLuint i = 0; i < numVerts; i++) 
+		sorted[i] = make_pair(vertices[i], i);
+	sort(sorted.begin(), sorted.end(), &PositionLess);
+	for(GLuint i = 1; i < numVerts; i++)
+	{
+		if(sorted[i].first != sorted[i-1].first) continue;
+		locked[sorted[i].second] = locked[sorted[i-1].second] = 1;
+	}
+
+	LodJob job;
+	job.mesh = this;
+	job.locked = &locked.front();
+	job.errors.resize(g.size());
+	Parallel::For(g.size(), &BuildGroupLods, &job);
+
+	//A level is only as good as its worst group
+	lodErrors.assign(MESH_LOD_COUNT, 0.0f);
+	for(GLuint i = 0; i < g.size(); i++)
+	{
+		for(GLuint k = 0; k < job.errors[i].size(); k++)
+			lodErrors[k+1] = max(lodErrors[k+1], job.errors[i][k]);
+	}
+	lod = 0;
+}
+
+GLuint Mesh::SelectLod(const Vector3 &camera, GLfloat pixelsPerUnit,
+		GLfloat maxError)
+{
+	//Inside the bounding sphere every error can be arbitrarily large
+	lod = 0;
+	GLfloat distance = camera.Distance(bounds.Center())-
+		0.5f*bounds.Size().Length();
+	if(distance <= 0.0f) return(lod);
+
+	//The errors grow with every level
+	for(GLuint i = 1; i < lodErrors.size(); i++)
+		if(lodErrors[i]*pixelsPerUnit/distance <= maxError) lod = i;
+	return(lod);
+}
+
+MeshletCullStats Mesh::CullMeshlets(const Matrix4 &modelviewprojection,
+		const Vector3 &camera, GLenum frontFace)
+{
+	MeshletCullStats stats;
+	Frustum frustum(modelviewprojection);
+	culled = true;
+
+	for(vector<TriangleGroup>::iterator grp=g.begin(); grp<g.end(); grp++)
+	{
+		grp->ranges.clear();
+		if(grp->meshlets.empty())
+		{
+			if(grp->count > 0) 
+				grp->ranges.push_back(0), grp->ranges.push_back(grp->count);
+			continue;
+		}
+
+		for(vector<Meshlet>::const_iterator m = grp->meshlets.begin(); 
+				m < grp->meshlets.end(); m++)
+		{
+			stats.meshlets++;
+			stats.triangles += m->triangleCount;
+
+			GLboolean visible = frustum.Intersects(m->center, m->radius);
+			if(!visible) stats.frustumCulled++;
+			else if(m->Backfacing(camera, frontFace)) 
+				stats.backfaceCulled++, visible = false;
+
+			if(!visible) 
+			{
+				stats.culledTriangles += m->triangleCount;
+				continue;
+			}
+
+			//Neighbouring meshlets are drawn with a single call
+			GLsizei first = m->indexOffset, count = 3*m->triangleCount;
+			if(!grp->ranges.empty() && grp->ranges[grp->ranges.size()-2]+
+					grp->ranges.back() == first)
+				grp->ranges.back() += count;
+			else grp->ranges.push_back(first), grp->ranges.push_back(count);
+		}
+	}
+
+	return(stats);
+}
+
+GroupCullStats Mesh::CullGroups(const Matrix4 &modelviewprojection)
+{
+	GroupCullStats stats;
+	Frustum frustum(modelviewprojection);
+
+	//Nothing is visible if the whole mesh is outside
+	GLboolean any = !sphere.Empty() && 
+		frustum.Intersects(sphere.center, sphere.radius);
+	for(vector<TriangleGroup>::iterator grp=g.begin(); grp<g.end(); grp++)
+	{
+		stats.groups++;
+		stats.triangles += grp->count/3;
+		grp->visible = any && !grp->sphere.Empty() &&
+			frustum.Intersects(grp->sphere.center, grp->sphere.radius) &&
+			frustum.Intersects(grp->bounds);
+		if(!grp->visible) 
+			stats.culledGroups++, stats.culledTriangles += grp->count/3;
+	}
+	return(stats);
+}
+
+//A group that may be added as an occluder, its diameter on the screen and
+//the level of detail added
+struct Occluder {
+	GLfloat size;
+	GLuint group;
+	GLuint level;
+};
+
+static bool LargerOccluder(const Occluder &a, const Occluder &b)
+{
+	return(a.size > b.size || (a.size == b.size && a.group < b.group));
+}
+
+GLvoid Mesh::AddOccluders(OcclusionCuller &culler, 
+		const Matrix4 &modelviewprojection, GLfloat minSize, 
+		size_t maxTriangles, GLenum frontFace) const
+{
+	//A length l at clip space w covers at most l*scale/w pixels of the 
+	//depth buffer. The x and y rows of the matrix stretch it, the w row 
+	//moves the points away from the center of the window.
+	const GLfloat *a = modelviewprojection.mat;
+	GLfloat rowW = Vector3(a[3], a[7], a[11]).Length();
+	GLfloat scale = max(
+		0.5f*culler.width*(Vector3(a[0], a[4], a[8]).Length()+rowW),
+		0.5f*culler.height*(Vector3(a[1], a[5], a[9]).Length()+rowW));
+
+	//Groups outside the view or hidden can't hide anything. The others are
+	//measured at their nearest point, which has the smallest w, so groups
+	//around the camera are the largest. The errors grow with every level.
+	vector<Occluder> occluders;
+	for(GLuint i = 0; i < g.size(); i++)
+	{
+		const TriangleGroup &grp = g[i];
+		if(!grp.visible || grp.sphere.Empty()) continue;
+		const Vector3 &c = grp.sphere.center;
+		GLfloat w = a[3]*c.x+a[7]*c.y+a[11]*c.z+a[15]-rowW*grp.sphere.radius;
+		Occluder o = {FLT_MAX, i, 0};
+		if(w > 0.0f)
+		{
+			o.size = 2.0f*grp.sphere.radius*scale/w;
+			for(GLuint k = 1; k <= grp.lods.size()/2 && k < lodErrors.size();
+					k++)
+				if(lodErrors[k]*scale <= MESH_OCCLUDER_LOD_ERROR*w) o.level = k;
+		}
+		if(o.size >= minSize) occluders.push_back(o);
+	}
+	sort(occluders.begin(), occluders.end(), &LargerOccluder);
+
+	//Smaller groups still fill the budget a larger one didn't fit in
+	const Vector3 *vertices = Vertices();
+	size_t triangles = 0;
+	for(vector<Occluder>::iterator o=occluders.begin(); o<occluders.end();
+			o++)
+	{
+		const TriangleGroup &grp = g[o->group];
+		size_t count;
+		const GLuint *indices = GroupIndices(*this, o->group, count);
+		if(o->level > 0)
+		{
+			indices = &grp.lodIndices[grp.lods[2*o->level-2]-count];
+			count = grp.lods[2*o->level-1];
+		}
+		if(count == 0 || triangles+count/3 > maxTriangles) continue;
+		triangles += count/3;
+		culler.AddOccluder(modelviewprojection, vertices, indices, count,
+			frontFace);
+	}
+}
+
+size_t Mesh::CullOccluded(OcclusionCuller &culler, 
+		const Matrix4 &modelviewprojection)
+{
+	sf::Clock timer;
+	size_t hidden = 0;
+	for(vector<TriangleGroup>::iterator grp=g.begin(); grp<g.end(); grp++)
+	{
+		if(!grp->visible || !culler.Occluded(modelviewprojection, 
+				grp->bounds)) 
+			continue;
+		grp->visible = false;
+		hidden++;
+		culler.stats.occludedTriangles += grp->count/3;
+	}
+	culler.stats.testTime += timer.getElapsedTime().asMicroseconds();
+	return(hidden);
+}
+
+//The triangles and vertices of CalculateNormals(). The vertices are split
+//into blocks and the triangles into chunks of NORMAL_BLOCK_SIZE.
+struct NormalJob {
+	const Vector3 *vertices;
+	Vector3 *normals;
+	GLuint numVerts;
+	vector<const GLuint*> groups; //The indices of each group
+	vector<size_t> starts; //The first triangle of each group, then the
+	                       //number of triangles
+	GLuint chunks; //The number of chunks of triangles
+	GLuint blockSize; //The number of vertices per block
+	GLuint blocks; //The number of blocks of vertices
+	vector<GLuint> counts; //The number of triangles of each chunk that 
+	                       //touch each block, then where they go in 
+	                       //triangles
+	vector<GLuint> first; //Where the triangles of each block start
+	vector<GLuint> triangles; //The triangles touching each block, in order
+};
+
+//Returns the indices of triangle t, grp is moved on to the group holding it
+static inline const GLuint* NormalTriangle(const NormalJob &job, size_t t,
+		size_t &grp)
+{
+	while(t >= job.starts[grp+1]) grp++;
+	return(job.groups[grp]+3*(t-job.starts[grp]));
+}
+
+//Returns the group holding triangle t
+static inline size_t NormalGroup(const NormalJob &job, size_t t)
+{
+	return(upper_bound(job.starts.begin(), job.starts.end(), t)-
+		job.starts.begin()-1);
+}
+
+//Counts, or with fill lists, the triangles of one chunk touching each block
+static GLvoid BucketChunk(NormalJob &job, GLuint index, GLboolean fill)
+{
+	size_t begin = (size_t)index*NORMAL_BLOCK_SIZE;
+	size_t end = min(begin+NORMAL_BLOCK_SIZE, job.starts.back());
+	GLuint *counts = &job.counts.front()+index*job.blocks;
+	size_t grp = NormalGroup(job, begin);
+	for(size_t t = begin; t < end; t++)
+	{
+		const GLuint *i = NormalTriangle(job, t, grp);
+		GLuint b[3];
+		for(GLuint c = 0; c < 3; c++) b[c] = i[c]/job.blockSize;
+		for(GLuint c = 0; c < 3; c++)
+		{
+			if((c > 0 && b[c] == b[0]) || (c > 1 && b[c] == b[1])) continue;
+			if(fill) job.triangles[counts[b[c]]++] = t;
+			else counts[b[c]]++;
+		}
+	}
+}
+
+static GLvoid CountChunk(GLuint index, GLvoid *data)
+{
+	BucketChunk(*(NormalJob*)data, index, false);
+}
+
+static GLvoid FillChunk(GLuint index, GLvoid *data)
+{
+	BucketChunk(*(NormalJob*)data, index, true);
+}
+
+//Sums the normals of the triangles touching one block of vertices and 
+//normalizes them. Only this task writes the block's normals.
+static GLvoid NormalBlock(GLuint index, GLvoid *data)
+{
+	NormalJob &job = *(NormalJob*)data;
+	GLuint begin = index*job.blockSize;
+	GLuint end = min(begin+job.blockSize, job.numVerts);
+	const Vector3 *v = job.vertices;
+	Vector3 *normals = job.normals;
+	for(GLuint i = begin; i < end; i++) 
+		normals[i] = Vector3(0.0f, 0.0f, 0.0f);
+
+	//The triangles are in order, so every normal is summed in the same 
+	//order as adding each triangle's normal to its vertices would. A 
+	//single block touches every triangle, they aren't listed.
+	GLboolean all = (job.blocks == 1);
+	const GLuint *triangles = job.triangles.empty() ? NULL : 
+		&job.triangles.front()+job.first[index];
+	size_t count = all ? job.starts.back() : 
+		job.first[index+1]-job.first[index];
+	size_t grp = 0;
+	for(size_t k = 0; k < count; k++)
+	{
+		//Calculate the normal via cross product of (a-c)x(b-c)
+		const GLuint *i = NormalTriangle(job, all ? k : triangles[k], grp);
+		Simd4 c = Simd::Load(&v[i[2]].x);
+		Simd4 n = Simd::Cross3(Simd::Sub(Simd::Load(&v[i[0]].x), c), 
+			Simd::Sub(Simd::Load(&v[i[1]].x), c));
+		for(GLuint j = 0; j < 3; j++)
+		{
+			if(i[j] < begin || i[j] >= end) continue;
+			Simd::Store(&normals[i[j]].x, 
+				Simd::Add(Simd::Load(&normals[i[j]].x), n));
+		}
+	}
+
+	//Now normalize each normal
+	for(GLuint i = begin; i < end; i++) normals[i] = normals[i].Normalize();
+}
+
+GLvoid Mesh::CalculateNormals()
+{
+	//The normals may already be in the array or in the cache
+	if(cache.header != NULL || v.size() == 2*numVerts) return;
+
+	//The normals follow the vertices in the same array
+	v.resize(2*numVerts);
+	if(numVerts == 0) return;
+
+	NormalJob job;
+	job.vertices = &v.front();
+	job.normals = &v.front()+numVerts;
+	job.numVerts = numVerts;
+	job.starts.push_back(0);
+	for(vector<TriangleGroup>::const_iterator grp=g.begin();grp<g.end();grp++)
+	{
+		job.groups.push_back(grp->indices.empty() ? NULL : 
+			&grp->indices.front());
+		job.starts.push_back(job.starts.back()+grp->indices.size()/3);
+	}
+	job.chunks = (job.starts.back()+NORMAL_BLOCK_SIZE-1)/NORMAL_BLOCK_SIZE;
+
+	//One thread simply goes through the triangles in order
+	job.blockSize = (Parallel::ThreadCount() > 1) ? NORMAL_BLOCK_SIZE : 
+		numVerts;
+	job.blocks = (numVerts+job.blockSize-1)/job.blockSize;
+	if(job.blocks == 1) 
+	{
+		NormalBlock(0, &job);
+		return;
+	}
+
+	//Sort the triangles into the blocks of vertices they touch, keeping 
+	//them in order, so no two threads ever add to the same normal
+	job.counts.assign(job.chunks*job.blocks, 0);
+	Parallel::For(job.chunks, &CountChunk, &job);
+	job.first.resize(job.blocks+1);
+	GLuint next = 0;
+	for(GLuint b = 0; b < job.blocks; b++)
+	{
+		job.first[b] = next;
+		for(GLuint c = 0; c < job.chunks; c++)
+		{
+			GLuint count = job.counts[c*job.blocks+b];
+			job.counts[c*job.blocks+b] = next;
+			next += count;
+		}
+	}
+	job.first[job.blocks] = next;
+	job.triangles.resize(next);
+	Parallel::For(job.chunks, &FillChunk, &job);
+
+	Parallel::For(job.blocks, &NormalBlock, &job);
+}	
+
+GLvoid Mesh::Close()
+{
+	//Delete all previously used resources
+	//Delete all the vector containers and deallocate the memory they hold
+	v.clear(); vector<Vector3>().swap(v);
+	vt.clear(); vector<Vec2f>().swap(vt);
+	
+	//Delete the trianglegroup container. Remember calling clear will call
+	//the destructors for each of the elements in the vector!
+	g.clear(); vector<TriangleGroup>().swap(g);
+
+	//The materials themselves belong to the cached libraries
+	vector<const Material*>().swap(materials);
+	vector<string>().swap(materialNames);
+
+	//Unmap the binary cache, if the mesh was loaded from one
+	cache.Close();
+	bounds.Reset();
+	sphere = BoundingSphere();
+	vector<GLfloat>().swap(lodErrors);
+
+	// Delete buffer objects
+	if(vbo != 0) GLState::DeleteBuffers(1, &vbo);
+	vbo = 0, numVerts = 0, format = VERTEX_FORMAT_FLOAT, culled = false;
+	lod = 0;
+	materialBuffer.Close();
+	materialStride = 0;
+}
+
+const string Mesh::ToString() const
+{
+	ostringstream s(ostringstream::out);
+
+	//Print the # of vertices and groups into the string stream
+	s<<left<<setfill('/')<<setw(68)<<"/"<<setfill(' ')<<endl;
+	s<<setw(15)<<"# OF VERTICES"<<": "<<v.size()<<endl;
+	s<<setw(15)<<"# OF GROUPS"<<": "<<g.size()<<endl;
+	s<<setw(15)<<"# OF MATERIALS"<<": "<<materials.size();
+	
+	//Now Print out the list of vertices
+	s<<endl<<setfill('=')<<setw(68)<<'='<<setfill(' ')<<endl;
+	s<<"LIST OF VERTICES"<<endl<<setfill('-')<<setw(16)<<'-'<<setfill(' ');
+	const Vector3 *vertices = Vertices();
+	for(GLuint i = 0; i < numVerts; i++)
+	{
+		s << endl << vertices[i].ToString();
+	}
+
+	//Loop through each group and print the number of indices in each group
+	//and the indices it self in groups of three
+	for(vector<TriangleGroup>::const_iterator k=g.begin(); k<g.end(); k++)
+	{
+		s<<endl<<setfill('=')<<setw(68)<<'='<<setfill(' ')<<endl;
+		s<<k->ToString()<<endl<<endl<<GetMaterial(*k).ToString();
+	}
+	s<<endl<<setfill('/')<<setw(68)<<"/"<<setfill(' ');
+
+	return(s.str());
+}
+
+Mesh::~Mesh()
+{
+	Close();
+}
+
+GLuint Mesh::MaterialBlock(const TriangleGroup &grp) const
+{
+	//Groups without a material use the default material's block, the last
+	return(min<size_t>(grp.mtl, materials.size()));
+}
+
+GLvoid Mesh::DrawGroup(const TriangleGroup &grp) const
+{
+	if(lod > 0 && 2*lod <= grp.lods.size())
+	{
+		glDrawElements(GL_TRIANGLES, grp.lods[2*lod-1], GL_UNSIGNED_INT,
+			(GLvoid*)(grp.lods[2*lod-2]*sizeof(GLuint)));
+		return;
+	}
+	if(!culled)
+	{
+		glDrawElements(GL_TRIANGLES, grp.count, GL_UNSIGNED_INT, (GLvoid*)0);
+		return;
+	}
+
+	//Only the meshlets that survived CullMeshlets()
+	for(GLuint r = 0; r < grp.ranges.size(); r += 2)
+	{
+		glDrawElements(GL_TRIANGLES, grp.ranges[r+1], GL_UNSIGNED_INT,
+			(GLvoid*)(grp.ranges[r]*sizeof(GLuint)));
+	}
+}
+
+//TEMPORARY!
+GLvoid Mesh::Draw() const
+{
+	//The vertex array object of each group holds the attribute pointers and
+	//the index buffer, all the groups contain indices to the same vertices
+	for(vector<TriangleGroup>::const_iterator it=g.begin(); it<g.end(); it++)
+	{
+		if(!it->visible) continue;
+		materialBuffer.BindRange(UNIFORM_BLOCK_MATERIAL, 
+			MaterialBlock(*it)*materialStride, materialStride);
+		GLState::BindVertexArray(it->vao);
+		DrawGroup(*it);
+	}
+}
+
+GLvoid Mesh::AttachInstances(const InstanceBuffer &instances)
+{
+	//Each column of the model matrix is an attribute of its own
+	GLsizei stride = sizeof(MeshInstance);
+	for(vector<TriangleGroup>::iterator it=g.begin(); it<g.end(); it++)
+	{
+		GLState::BindVertexArray(it->vao);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, instances.vbo);
+		for(GLuint c = 0; c < 4; c++)
+		{
+			GLuint a = INSTANCE_ATTRIBUTE_MODEL+c;
+			glEnableVertexAttribArray(a);
+			glVertexAttribPointer(a, 4, GL_FLOAT, GL_FALSE, stride, 
+				(GLvoid*)(offsetof(MeshInstance, model)+4*c*sizeof(GLfloat)));
+			glVertexAttribDivisor(a, 1);
+		}
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_COLOR);
+		glVertexAttribPointer(INSTANCE_ATTRIBUTE_COLOR, 4, GL_FLOAT, GL_FALSE,
+			stride, (GLvoid*)offsetof(MeshInstance, color));
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE_COLOR, 1);
+	}
+	GLState::BindVertexArray(0);
+}
+
+GLvoid Mesh::DrawInstanced(GLsizei count) const
+{
+	for(vector<TriangleGroup>::const_iterator it=g.begin(); it<g.end(); it++)
+	{
+		materialBuffer.BindRange(UNIFORM_BLOCK_MATERIAL, 
+			MaterialBlock(*it)*materialStride, materialStride);
+		GLState::BindVertexArray(it->vao);
+		if(lod > 0 && 2*lod <= it->lods.size())
+		{
+			glDrawElementsInstanced(GL_TRIANGLES, it->lods[2*lod-1], 
+				GL_UNSIGNED_INT, (GLvoid*)(it->lods[2*lod-2]*sizeof(GLuint)),
+				count);
+		}
+		else
+		{
+			glDrawElementsInstanced(GL_TRIANGLES, it->count, GL_UNSIGNED_INT,
+				(GLvoid*)0, count);
+		}
+	}
 }
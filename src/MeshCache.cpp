@@ -0,0 +1,250 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <MeshCache.h>
+#include <Mesh.h>
+
+//How much of the start and the end of the OBJ file is hashed
+#define MESH_CACHE_HASH_SIZE (1<<20)
+
+//Every array in the file starts on a multiple of this many bytes
+#define MESH_CACHE_ALIGNMENT 16
+
+using namespace std;
+
+//Copies the corners of a box and a sphere into the arrays of the file
+static GLvoid StoreBounds(const BoundingBox &box, const BoundingSphere &sphere,
+		GLfloat *min, GLfloat *max, GLfloat *center, GLfloat &radius)
+{
+	min[0] = box.min.x, min[1] = box.min.y, min[2] = box.min.z;
+	max[0] = box.max.x, max[1] = box.max.y, max[2] = box.max.z;
+	center[0] = sphere.center.x, center[1] = sphere.center.y;
+	center[2] = sphere.center.z, radius = sphere.radius;
+}
+
+//Rounds the offset up to the next multiple of MESH_CACHE_ALIGNMENT
+static uint64_t Align(uint64_t offset)
+{
+	return((offset+MESH_CACHE_ALIGNMENT-1) & ~((uint64_t)MESH_CACHE_ALIGNMENT-1));
+}
+
+//Writes the data followed by enough zeros to align the next array
+static GLvoid WriteAligned(ofstream &file, const GLvoid *data, uint64_t size, 
+		uint64_t &offset)
+{
+	static const GLchar zeros[MESH_CACHE_ALIGNMENT] = {0};
+	if(size > 0) file.write((const GLchar*)data, size);
+	uint64_t next = Align(offset+size);
+	file.write(zeros, next-(offset+size));
+	offset = next;
+}
+
+MeshCache::MeshCache()
+{
+	header = NULL, vertices = NULL, groups = NULL, texcoords = NULL;
+}
+
+const string MeshCache::Filename(const string &source)
+{
+	//Only replace the extension of the file, not a '.' in a directory name
+	size_t dot = source.find_last_of('.');
+	size_t slash = source.find_last_of("/\\");
+	if(dot == string::npos || (slash != string::npos && dot < slash))
+		return(source+".mesh");
+	return(source.substr(0, dot)+".mesh");
+}
+
+uint64_t MeshCache::Hash(const MappedFile &source)
+{
+	//64 bit FNV-1a over the size and the first and last megabyte
+	uint64_t hash = 14695981039346656037ULL;
+	const uint64_t prime = 1099511628211ULL;
+
+	uint64_t size = source.size;
+	for(GLuint i = 0; i < sizeof(size); i++)
+		hash = (hash ^ ((size>>(i*8)) & 0xFF))*prime;
+
+	size_t head = (source.size < MESH_CACHE_HASH_SIZE) ? source.size : 
+		MESH_CACHE_HASH_SIZE;
+	for(size_t i = 0; i < head; i++) 
+		hash = (hash ^ (GLubyte)source.data[i])*prime;
+
+	size_t tail = (source.size-head < MESH_CACHE_HASH_SIZE) ? 
+		source.size-head : MESH_CACHE_HASH_SIZE;
+	for(size_t i = source.size-tail; i < source.size; i++)
+		hash = (hash ^ (GLubyte)source.data[i])*prime;
+
+	return(hash);
+}
+
+GLboolean MeshCache::Open(const string &source, GLuint flags)
+{
+	Close();
+
+	struct stat st;
+	if(stat(source.c_str(), &st) != 0) return(false);
+	if(!file.Open(Filename(source))) return(false);
+
+	//Check the header before trusting anything else in the file
+	const MeshCacheHeader *h = (const MeshCacheHeader*)file.data;
+	if(file.size < sizeof(MeshCacheHeader) || memcmp(h->magic, "MESH", 4) != 0
+			|| h->version != MESH_CACHE_VERSION || h->flags != flags ||
+			h->sourceSize != (uint64_t)st.st_size || 
+			h->sourceTime != (int64_t)st.st_mtime)
+	{
+		Close();
+		return(false);
+	}
+
+	MappedFile src;
+	if(!src.Open(source) || h->sourceHash != Hash(src))
+	{
+		Close();
+		return(false);
+	}
+
+	//Make sure all the arrays are actually inside the file, a truncated
+	//cache must not crash the program
+	uint64_t size = file.size;
+	GLboolean valid = 
+		h->vertexOffset+2*(uint64_t)h->numVerts*sizeof(Vector3) <= size &&
+		h->groupOffset+h->numGroups*sizeof(MeshCacheGroup) <= size &&
+		h->materialOffset+h->materialSize <= size &&
+		h->texcoordOffset+h->numTexcoords*sizeof(Vec2f) <= size;
+	const MeshCacheGroup *grp = (const MeshCacheGroup*)(file.data+
+		h->groupOffset);
+	for(GLuint i = 0; valid && i < h->numGroups; i++)
+	{
+		valid = (grp[i].indexOffset+grp[i].count*sizeof(GLuint) <= size &&
+			(grp[i].mtl < h->numMaterials || grp[i].mtl == NO_MATERIAL));
+	}
+
+	//Two strings per material, each one ends inside the names
+	const GLchar *names = file.data+h->materialOffset;
+	for(uint64_t i = 0, start = 0; valid && i < h->materialSize; i++)
+	{
+		if(names[i] != '\0') continue;
+		materialNames.push_back(string(names+start, i-start));
+		start = i+1;
+	}
+	if(!valid || materialNames.size() != 2*(size_t)h->numMaterials)
+	{
+		Close();
+		return(false);
+	}
+
+	header = h;
+	vertices = (const Vector3*)(file.data+h->vertexOffset);
+	groups = grp;
+	texcoords = (const Vec2f*)(file.data+h->texcoordOffset);
+
+	return(true);
+}
+
+const GLuint* MeshCache::Indices(GLuint group) const
+{
+	return((const GLuint*)(file.data+groups[group].indexOffset));
+}
+
+GLboolean MeshCache::Write(const Mesh &mesh, const string &source,
+		GLuint flags)
+{
+	//Only fully loaded meshes, including normals, are cached. Their
+	//materials must have come from MTL files.
+	if(mesh.numVerts == 0 || mesh.v.size() != 2*mesh.numVerts ||
+			mesh.materialNames.size() != 2*mesh.materials.size()) 
+		return(false);
+
+	struct stat st;
+	MappedFile src;
+	if(stat(source.c_str(), &st) != 0 || !src.Open(source)) return(false);
+
+	MeshCacheHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "MESH", 4);
+	h.version = MESH_CACHE_VERSION;
+	h.flags = flags;
+	h.numVerts = mesh.numVerts;
+	h.numGroups = mesh.g.size();
+	h.numMaterials = mesh.materials.size();
+	h.numTexcoords = mesh.vt.size();
+	h.sourceSize = st.st_size;
+	h.sourceTime = st.st_mtime;
+	h.sourceHash = Hash(src);
+	StoreBounds(mesh.bounds, mesh.sphere, h.min, h.max, h.center, h.radius);
+
+	//Lay out the arrays one after the other: vertices, groups, materials,
+	//texture coordinates and then each group's indices
+	uint64_t offset = Align(sizeof(h));
+	h.vertexOffset = offset;
+	offset = Align(offset+mesh.v.size()*sizeof(Vector3));
+	h.groupOffset = offset;
+	offset = Align(offset+h.numGroups*sizeof(MeshCacheGroup));
+	string names;
+	for(GLuint i = 0; i < mesh.materialNames.size(); i++)
+		names += mesh.materialNames[i]+'\0';
+	h.materialOffset = offset;
+	h.materialSize = names.size();
+	offset = Align(offset+h.materialSize);
+	h.texcoordOffset = offset;
+	offset = Align(offset+h.numTexcoords*sizeof(Vec2f));
+
+	vector<MeshCacheGroup> groups(h.numGroups);
+	for(GLuint i = 0; i < h.numGroups; i++)
+	{
+		groups[i].indexOffset = offset;
+		groups[i].count = mesh.g[i].indices.size();
+		groups[i].mtl = mesh.g[i].mtl;
+		StoreBounds(mesh.g[i].bounds, mesh.g[i].sphere, groups[i].min, 
+			groups[i].max, groups[i].center, groups[i].radius);
+		offset = Align(offset+groups[i].count*sizeof(GLuint));
+	}
+
+	//Write everything to a temporary file first
+	string filename = Filename(source), temp = filename+".tmp";
+	ofstream file(temp.c_str(), ofstream::out | ofstream::binary);
+	if(!file.is_open()) return(false);
+
+	offset = 0;
+	WriteAligned(file, &h, sizeof(h), offset);
+	WriteAligned(file, &mesh.v.front(), mesh.v.size()*sizeof(Vector3), offset);
+	WriteAligned(file, groups.empty() ? NULL : &groups.front(), 
+		groups.size()*sizeof(MeshCacheGroup), offset);
+	WriteAligned(file, names.data(), names.size(), offset);
+	WriteAligned(file, mesh.vt.empty() ? NULL : &mesh.vt.front(), 
+		mesh.vt.size()*sizeof(Vec2f), offset);
+	for(GLuint i = 0; i < h.numGroups; i++)
+	{
+		const vector<GLuint> &indices = mesh.g[i].indices;
+		WriteAligned(file, indices.empty() ? NULL : &indices.front(), 
+			indices.size()*sizeof(GLuint), offset);
+	}
+
+	GLboolean good = file.good();
+	file.close();
+	if(!good) {remove(temp.c_str()); return(false);}
+
+	//Then replace the old cache, if there is one
+	remove(filename.c_str());
+	if(rename(temp.c_str(), filename.c_str()) != 0)
+	{
+		remove(temp.c_str());
+		return(false);
+	}
+
+	return(true);
+}
+
+GLvoid MeshCache::Close()
+{
+	file.Close();
+	header = NULL, vertices = NULL, groups = NULL, texcoords = NULL;
+	materialNames.clear();
+}
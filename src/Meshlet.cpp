@@ -0,0 +1,173 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+#include <Meshlet.h>
+
+using namespace std;
+
+//Calculates the bounding sphere and normal cone of the last meshlet
+static GLvoid FinishMeshlet(const Vector3 *vertices, const GLuint *indices,
+		Meshlet &m, const vector<GLuint> &meshletVertices)
+{
+	//The sphere is centered on the bounding box, which is close to the 
+	//smallest sphere for the compact clusters the builder makes
+	BoundingBox box;
+	const GLuint *local = &meshletVertices.front()+m.vertexOffset;
+	for(GLuint i = 0; i < m.vertexCount; i++) box.Add(vertices[local[i]]);
+	m.center = box.Center();
+	m.radius = 0.0f;
+	for(GLuint i = 0; i < m.vertexCount; i++)
+	{
+		GLfloat d = m.center.Distance(vertices[local[i]]);
+		if(d > m.radius) m.radius = d;
+	}
+
+	//The cone is centered on the average normal and opens wide enough to
+	//hold every normal. Degenerate triangles can face any way, so they 
+	//don't count.
+	const GLuint *tri = indices+m.indexOffset;
+	vector<Vector3> normals;
+	Vector3 axis(0.0f, 0.0f, 0.0f);
+	for(GLuint t = 0; t < m.triangleCount; t++, tri += 3)
+	{
+		const Vector3 &a = vertices[tri[0]], &b = vertices[tri[1]]; 
+		const Vector3 &c = vertices[tri[2]];
+		Vector3 n = (a-c).CrossProduct(b-c);
+		GLfloat l = n.Length();
+		if(l == 0.0f) continue;
+		normals.push_back(n/l);
+		axis += normals.back();
+	}
+
+	GLfloat l = axis.Length();
+	m.coneCos = -1.0f, m.coneSin = 0.0f;
+	if(normals.empty() || l == 0.0f) return;
+	m.coneAxis = axis/l;
+	m.coneCos = 1.0f;
+	for(GLuint i = 0; i < normals.size(); i++)
+	{
+		GLfloat c = normals[i]*m.coneAxis;
+		if(c < m.coneCos) m.coneCos = c;
+	}
+	m.coneSin = sqrtf(max(0.0f, 1.0f-m.coneCos*m.coneCos));
+}
+
+Meshlet::Meshlet()
+{
+	indexOffset = 0, vertexOffset = 0, triangleOffset = 0;
+	vertexCount = 0, triangleCount = 0;
+	radius = 0.0f, coneCos = -1.0f, coneSin = 0.0f;
+}
+
+GLboolean Meshlet::Backfacing(const Vector3 &camera, GLenum frontFace) const
+{
+	//The normals are spread over half a sphere or more
+	if(coneCos <= 0.0f) return(false);
+
+	//Inside the sphere the camera can be in front of any triangle
+	Vector3 d = center-camera;
+	GLfloat distance = sqrtf(d.x*d.x+d.y*d.y+d.z*d.z);
+	if(distance <= radius) return(false);
+
+	//Every triangle faces away if every normal is within 90 degrees of the
+	//direction to every point of the sphere. The directions to the sphere
+	//are within asin(radius/distance) of the direction to its center, 
+	//so the angle between the cone and the center, plus the cone's half
+	//angle, plus that must be below 90 degrees.
+	GLfloat c = (d*coneAxis)/distance;
+	if(frontFace == GL_CW) c = -c;
+	GLfloat s = sqrtf(max(0.0f, 1.0f-c*c));
+	return(c*coneCos-s*coneSin > radius/distance);
+}
+
+GLvoid Meshlet::Build(const Vector3 *vertices, const GLuint *indices, 
+		size_t count, vector<Meshlet> &meshlets, 
+		vector<GLuint> &meshletVertices, vector<GLubyte> &meshletIndices)
+{
+	meshlets.clear();
+	meshletVertices.clear();
+	meshletIndices.clear();
+	if(count < 3) return;
+
+	Meshlet m;
+	for(size_t t = 0; t+2 < count; t += 3)
+	{
+		//Count the triangle's vertices that the meshlet doesn't have yet, 
+		//a new meshlet is started if there isn't room for them
+		const GLuint *local = meshletVertices.empty() ? NULL : 
+			&meshletVertices.front()+m.vertexOffset;
+		GLuint missing = 0;
+		for(GLuint c = 0; c < 3; c++)
+		{
+			GLuint v = indices[t+c];
+			GLboolean found = false;
+			for(GLuint k = 0; !found && k < m.vertexCount; k++) 
+				found = (local[k] == v);
+			for(GLuint k = 0; !found && k < c; k++) 
+				found = (indices[t+k] == v);
+			if(!found) missing++;
+		}
+		if(m.vertexCount+missing > MESHLET_MAX_VERTICES || 
+				m.triangleCount == MESHLET_MAX_TRIANGLES)
+		{
+			FinishMeshlet(vertices, indices, m, meshletVertices);
+			meshlets.push_back(m);
+			m = Meshlet();
+			m.indexOffset = t;
+			m.vertexOffset = meshletVertices.size();
+			m.triangleOffset = meshletIndices.size();
+		}
+
+		for(GLuint c = 0; c < 3; c++)
+		{
+			//Look the vertex up again, an earlier corner may have added it
+			GLuint k = 0;
+			local = meshletVertices.empty() ? NULL : 
+				&meshletVertices.front()+m.vertexOffset;
+			while(k < m.vertexCount && local[k] != indices[t+c]) k++;
+			if(k == m.vertexCount)
+			{
+				meshletVertices.push_back(indices[t+c]);
+				m.vertexCount++;
+			}
+			meshletIndices.push_back(k);
+		}
+		m.triangleCount++;
+	}
+
+	FinishMeshlet(vertices, indices, m, meshletVertices);
+	meshlets.push_back(m);
+}
+
+MeshletCullStats::MeshletCullStats()
+{
+	meshlets = 0, triangles = 0, frustumCulled = 0, backfaceCulled = 0;
+	culledTriangles = 0;
+}
+
+GLvoid MeshletCullStats::Add(const MeshletCullStats &s)
+{
+	meshlets += s.meshlets;
+	triangles += s.triangles;
+	frustumCulled += s.frustumCulled;
+	backfaceCulled += s.backfaceCulled;
+	culledTriangles += s.culledTriangles;
+}
+
+const string MeshletCullStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	GLfloat percent = (triangles > 0) ? (100.0f*culledTriangles)/triangles : 
+		0.0f;
+	s<<left;
+	s<<setw(15)<<"MESHLETS"<<": "<<meshlets<<", "<<frustumCulled<<
+		" outside the frustum, "<<backfaceCulled<<" back facing"<<endl;
+	s<<setw(15)<<"TRIANGLES"<<": "<<triangles<<", "<<culledTriangles<<
+		" culled ("<<percent<<"%)";
+	return(s.str());
+}
@@ -0,0 +1,306 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <SFML/System/Clock.hpp>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+#include <OcclusionCuller.h>
+#include <Parallel.h>
+#include <Simd.h>
+
+using namespace std;
+
+//Corners with a smaller w are on or behind the near plane
+#define OCCLUSION_MIN_W 1.0e-5f
+
+OcclusionStats::OcclusionStats()
+{
+	occluderTriangles = 0, tested = 0, occluded = 0, occludedTriangles = 0;
+	rasterTime = 0.0f, testTime = 0.0f;
+}
+
+GLvoid OcclusionStats::Add(const OcclusionStats &s)
+{
+	occluderTriangles += s.occluderTriangles;
+	tested += s.tested;
+	occluded += s.occluded;
+	occludedTriangles += s.occludedTriangles;
+	rasterTime += s.rasterTime;
+	testTime += s.testTime;
+}
+
+const string OcclusionStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s<<left;
+	s<<setw(15)<<"OCCLUSION"<<": "<<tested<<" tested, "<<occluded<<
+		" occluded, "<<occludedTriangles<<" triangles, "<<
+		occluderTriangles<<" occluder triangles"<<endl;
+	s<<setw(15)<<"OCCLUSION TIME"<<": "<<rasterTime<<" us rasterizing, "<<
+		testTime<<" us testing";
+	return(s.str());
+}
+
+OcclusionCuller::OcclusionCuller()
+{
+	Resize(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+}
+
+GLvoid OcclusionCuller::Resize(GLuint width, GLuint height)
+{
+	//Whole groups of four pixels are rasterized at a time
+	this->width = (max(width, 1u)+3) & ~3u;
+	this->height = max(height, 1u);
+
+	//Each level halves the size, rounding up, down to a single texel
+	levels.clear();
+	sizes.clear();
+	GLuint w = this->width, h = this->height;
+	while(true)
+	{
+		levels.push_back(vector<GLfloat>(w*h, 1.0f));
+		sizes.push_back(w), sizes.push_back(h);
+		if(w == 1 && h == 1) break;
+		w = (w+1)/2, h = (h+1)/2;
+	}
+	triangles.clear();
+}
+
+GLvoid OcclusionCuller::Clear()
+{
+	triangles.clear();
+	stats = OcclusionStats();
+}
+
+//Transforms a point to the window, returns false if it's not in front of
+//the near plane
+static inline GLboolean ToWindow(const Matrix4 &m, const Vector3 &v,
+		GLuint width, GLuint height, GLfloat *out)
+{
+	Vector3 c = m*Vector3(v.x, v.y, v.z);
+	if(c.w < OCCLUSION_MIN_W) return(false);
+	out[0] = (c.x/c.w*0.5f+0.5f)*width;
+	out[1] = (c.y/c.w*0.5f+0.5f)*height;
+	out[2] = c.z/c.w*0.5f+0.5f;
+	return(true);
+}
+
+GLvoid OcclusionCuller::AddOccluder(const Matrix4 &modelviewprojection,
+		const Vector3 *vertices, const GLuint *indices, size_t count,
+		GLenum frontFace)
+{
+	for(size_t i = 0; i+2 < count; i += 3)
+	{
+		//Triangles crossing the near plane are left out, there are fewer
+		//occluders but nothing is hidden that shouldn't be
+		GLfloat t[9];
+		GLboolean front = true;
+		for(GLuint k = 0; k < 3 && front; k++)
+		{
+			front = ToWindow(modelviewprojection, vertices[indices[i+k]],
+				width, height, t+3*k);
+		}
+		if(!front) continue;
+
+		//The window's y axis points up, so counterclockwise triangles have
+		//a positive area. Back faces and edge-on triangles hide nothing 
+		//OpenGL draws.
+		GLfloat area = (t[3]-t[0])*(t[7]-t[1])-(t[4]-t[1])*(t[6]-t[0]);
+		if((frontFace == GL_CW) ? area >= 0.0f : area <= 0.0f) continue;
+
+		//Triangles entirely off one side of the window cover nothing
+		GLfloat minX = min(t[0], min(t[3], t[6]));
+		GLfloat maxX = max(t[0], max(t[3], t[6]));
+		GLfloat minY = min(t[1], min(t[4], t[7]));
+		GLfloat maxY = max(t[1], max(t[4], t[7]));
+		if(maxX < 0.0f || maxY < 0.0f || minX > width || minY > height)
+			continue;
+		triangles.insert(triangles.end(), t, t+9);
+	}
+}
+
+//The rows of the depth buffer rasterized by each task
+struct RasterJob {
+	const OcclusionCuller *culler;
+	GLfloat *depth;
+};
+
+//Rasterizes the triangles binned to one band of rows. Runs as a
+//Parallel::For task.
+static GLvoid RasterizeBand(GLuint index, GLvoid *data)
+{
+	const RasterJob &job = *(const RasterJob*)data;
+	const OcclusionCuller &culler = *job.culler;
+	GLint width = culler.width;
+	GLint top = index*OCCLUSION_BAND_ROWS;
+	GLint bottom = min<GLint>(top+OCCLUSION_BAND_ROWS, culler.height)-1;
+
+	GLfloat ramp[4] = {0.5f, 1.5f, 2.5f, 3.5f};
+	Simd4 offsets = Simd::Load(ramp), zero = Simd::Splat(0.0f);
+	for(GLuint j = culler.binStarts[index]; j < culler.binStarts[index+1];
+			j++)
+	{
+		//Wind the triangle counterclockwise in window space, so the edge
+		//functions are positive inside. Clockwise front faces are turned.
+		const GLfloat *a = &culler.triangles[9*culler.bins[j]];
+		const GLfloat *b = a+3, *c = a+6;
+		GLfloat area = (b[0]-a[0])*(c[1]-a[1])-(b[1]-a[1])*(c[0]-a[0]);
+		if(area == 0.0f) continue;
+		if(area < 0.0f) swap(b, c), area = -area;
+
+		GLint minY = max<GLint>(top, (GLint)floorf(min(a[1],
+			min(b[1], c[1]))));
+		GLint maxY = min<GLint>(bottom, (GLint)ceilf(max(a[1],
+			max(b[1], c[1]))));
+		if(minY > maxY) continue;
+		GLint minX = max<GLint>(0, (GLint)floorf(min(a[0], min(b[0], c[0]))));
+		GLint maxX = min<GLint>(width-1, (GLint)ceilf(max(a[0],
+			max(b[0], c[0]))));
+		if(minX > maxX) continue;
+		minX &= ~3;
+
+		//Each edge function is ex*x+ey*y+e0, zero on the edge from p to q.
+		//The depth is a plane in window space, its gradients follow from
+		//the barycentric coordinates, which are the edge functions
+		//divided by the area.
+		const GLfloat *p[3] = {b, c, a}, *q[3] = {c, a, b};
+		GLfloat ex[3], ey[3], e0[3];
+		GLfloat zx = 0.0f, zy = 0.0f, z0 = 0.0f;
+		for(GLuint e = 0; e < 3; e++)
+		{
+			ex[e] = p[e][1]-q[e][1], ey[e] = q[e][0]-p[e][0];
+			e0[e] = -(ex[e]*p[e][0]+ey[e]*p[e][1]);
+			GLfloat z = (e == 0 ? a : (e == 1 ? b : c))[2]/area;
+			zx += ex[e]*z, zy += ey[e]*z, z0 += e0[e]*z;
+		}
+
+		for(GLint y = minY; y <= maxY; y++)
+		{
+			GLfloat py = y+0.5f;
+			GLfloat *row = job.depth+y*width;
+			Simd4 rowE[3], ex4[3];
+			for(GLuint e = 0; e < 3; e++)
+			{
+				rowE[e] = Simd::Splat(ey[e]*py+e0[e]);
+				ex4[e] = Simd::Splat(ex[e]);
+			}
+			Simd4 rowZ = Simd::Splat(zy*py+z0), zx4 = Simd::Splat(zx);
+
+			for(GLint x = minX; x <= maxX; x += 4)
+			{
+				Simd4 px = Simd::Add(Simd::Splat((GLfloat)x), offsets);
+				Simd4 inside = Simd::Min(Simd::Min(
+					Simd::Add(Simd::Mul(ex4[0], px), rowE[0]),
+					Simd::Add(Simd::Mul(ex4[1], px), rowE[1])),
+					Simd::Add(Simd::Mul(ex4[2], px), rowE[2]));
+				Simd4 z = Simd::Add(Simd::Mul(zx4, px), rowZ);
+				Simd4 d = Simd::Load(row+x);
+				Simd::Store(row+x, Simd::Select(Simd::LessThan(inside, zero),
+					d, Simd::Min(d, z)));
+			}
+		}
+	}
+}
+
+GLvoid OcclusionCuller::Rasterize()
+{
+	sf::Clock timer;
+	vector<GLfloat> &depth = levels[0];
+	fill(depth.begin(), depth.end(), 1.0f);
+
+	//Sort the triangles into the bands of rows they overlap, counting
+	//first, so each task only sets up its own triangles
+	GLuint bands = (height+OCCLUSION_BAND_ROWS-1)/OCCLUSION_BAND_ROWS;
+	GLuint count = triangles.size()/9;
+	vector<GLuint> first(count), last(count);
+	binStarts.assign(bands+1, 0);
+	for(GLuint i = 0; i < count; i++)
+	{
+		const GLfloat *t = &triangles[9*i];
+		GLfloat minY = min(t[1], min(t[4], t[7]));
+		GLfloat maxY = max(t[1], max(t[4], t[7]));
+		first[i] = (GLuint)max(0.0f, floorf(minY))/OCCLUSION_BAND_ROWS;
+		last[i] = min<GLuint>((GLuint)max(0.0f, ceilf(maxY))/
+			OCCLUSION_BAND_ROWS, bands-1);
+		for(GLuint b = first[i]; b <= last[i]; b++) binStarts[b+1]++;
+	}
+	for(GLuint b = 0; b < bands; b++) binStarts[b+1] += binStarts[b];
+	bins.resize(binStarts[bands]);
+	vector<GLuint> next(binStarts.begin(), binStarts.end()-1);
+	for(GLuint i = 0; i < count; i++)
+		for(GLuint b = first[i]; b <= last[i]; b++) bins[next[b]++] = i;
+
+	RasterJob job = {this, &depth.front()};
+	Parallel::For(bands, &RasterizeBand, &job);
+	stats.occluderTriangles += triangles.size()/9;
+
+	//Each texel keeps the farthest of the up to four texels it covers
+	for(GLuint l = 1; l < levels.size(); l++)
+	{
+		const vector<GLfloat> &below = levels[l-1];
+		vector<GLfloat> &level = levels[l];
+		GLuint bw = sizes[2*l-2], bh = sizes[2*l-1];
+		GLuint w = sizes[2*l], h = sizes[2*l+1];
+		for(GLuint y = 0; y < h; y++)
+		{
+			GLuint y0 = 2*y, y1 = min(2*y+1, bh-1);
+			for(GLuint x = 0; x < w; x++)
+			{
+				GLuint x0 = 2*x, x1 = min(2*x+1, bw-1);
+				level[y*w+x] = max(max(below[y0*bw+x0], below[y0*bw+x1]),
+					max(below[y1*bw+x0], below[y1*bw+x1]));
+			}
+		}
+	}
+	stats.rasterTime += timer.getElapsedTime().asMicroseconds();
+}
+
+GLboolean OcclusionCuller::Occluded(const Matrix4 &modelviewprojection,
+		const BoundingBox &box)
+{
+	if(box.Empty()) return(false);
+	stats.tested++;
+
+	//The window rectangle and nearest depth of the corners
+	GLfloat minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f, minZ = 0.0f;
+	for(GLuint k = 0; k < 8; k++)
+	{
+		Vector3 corner((k & 1) ? box.max.x : box.min.x,
+			(k & 2) ? box.max.y : box.min.y, (k & 4) ? box.max.z : box.min.z);
+		GLfloat w[3];
+		if(!ToWindow(modelviewprojection, corner, width, height, w))
+			return(false);
+		if(k == 0 || w[0] < minX) minX = w[0];
+		if(k == 0 || w[0] > maxX) maxX = w[0];
+		if(k == 0 || w[1] < minY) minY = w[1];
+		if(k == 0 || w[1] > maxY) maxY = w[1];
+		if(k == 0 || w[2] < minZ) minZ = w[2];
+	}
+
+	//Boxes outside the window are left to frustum culling
+	if(maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+		return(false);
+	GLint x0 = max(0, (GLint)floorf(minX));
+	GLint x1 = min<GLint>(width-1, (GLint)floorf(maxX));
+	GLint y0 = max(0, (GLint)floorf(minY));
+	GLint y1 = min<GLint>(height-1, (GLint)floorf(maxY));
+
+	//The level where the rectangle spans at most two texels each way
+	GLuint l = 0;
+	while(l+1 < levels.size() && ((x1>>l)-(x0>>l) > 1 || (y1>>l)-(y0>>l) > 1))
+		l++;
+	const vector<GLfloat> &level = levels[l];
+	GLuint w = sizes[2*l];
+	GLfloat farthest = 0.0f;
+	for(GLint y = y0>>l; y <= (y1>>l); y++)
+		for(GLint x = x0>>l; x <= (x1>>l); x++)
+			farthest = max(farthest, level[y*w+x]);
+
+	if(minZ <= farthest) return(false);
+	stats.occluded++;
+	return(true);
+}
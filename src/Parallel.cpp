@@ -0,0 +1,85 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include <vector>
+
+#include <Parallel.h>
+
+using namespace std;
+
+GLuint Parallel::maxThreads = 0;
+
+//State shared by all the threads running one call to Parallel::For
+struct ParallelJob {
+	Parallel::Task task;
+	GLvoid *data;
+	GLuint count;
+	GLuint next;
+	sf::Mutex mutex;
+};
+
+//Keeps taking the next task until there are none left
+static GLvoid ParallelWorker(ParallelJob *job)
+{
+	while(true)
+	{
+		job->mutex.lock();
+		GLuint index = job->next++;
+		job->mutex.unlock();
+
+		if(index >= job->count) break;
+		job->task(index, job->data);
+	}
+}
+
+GLuint Parallel::ThreadCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	GLuint count = info.dwNumberOfProcessors;
+#else
+	GLint online = sysconf(_SC_NPROCESSORS_ONLN);
+	GLuint count = (online > 0) ? online : 1;
+#endif
+	if(maxThreads != 0 && maxThreads < count) count = maxThreads;
+	return(count);
+}
+
+GLvoid Parallel::For(GLuint count, Task task, GLvoid *data)
+{
+	GLuint threads = ThreadCount();
+	if(threads > count) threads = count;
+
+	//Not worth starting any threads
+	if(threads <= 1)
+	{
+		for(GLuint i = 0; i < count; i++) task(i, data);
+		return;
+	}
+
+	ParallelJob job;
+	job.task = task, job.data = data, job.count = count, job.next = 0;
+
+	//sf::Thread can't be copied so the threads have to live on the heap. The
+	//calling thread is one of the workers.
+	vector<sf::Thread*> workers;
+	for(GLuint i = 1; i < threads; i++)
+	{
+		workers.push_back(new sf::Thread(&ParallelWorker, &job));
+		workers.back()->launch();
+	}
+	ParallelWorker(&job);
+
+	for(GLuint i = 0; i < workers.size(); i++)
+	{
+		workers[i]->wait();
+		delete workers[i];
+	}
+}
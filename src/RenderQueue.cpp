@@ -0,0 +1,182 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+#include <RenderQueue.h>
+#include <GLState.h>
+
+using namespace std;
+
+RenderQueueStats::RenderQueueStats()
+{
+	items = 0, programChanges = 0, materialChanges = 0, vaoChanges = 0;
+	transformChanges = 0;
+}
+
+size_t RenderQueueStats::Changes() const
+{
+	return(programChanges+materialChanges+vaoChanges+transformChanges);
+}
+
+const string RenderQueueStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s<<left;
+	s<<setw(15)<<"RENDER QUEUE"<<": "<<items<<" items, "<<programChanges<<
+		" programs, "<<materialChanges<<" materials, "<<vaoChanges<<
+		" vertex arrays, "<<transformChanges<<" transforms";
+	return(s.str());
+}
+
+uint64_t RenderQueue::Key(GLuint pass, GLuint shader, GLuint material,
+		GLuint mesh, GLfloat depth)
+{
+	//Depth is quantized, anything outside 0 to 1 is clamped
+	const GLuint maxDepth = (1u<<RENDER_KEY_DEPTH_BITS)-1;
+	GLuint d = (depth <= 0.0f) ? 0 : (depth >= 1.0f) ? maxDepth :
+		(GLuint)(depth*maxDepth);
+
+	uint64_t key = pass & ((1u<<RENDER_KEY_PASS_BITS)-1);
+	key = (key<<RENDER_KEY_SHADER_BITS) |
+		(shader & ((1u<<RENDER_KEY_SHADER_BITS)-1));
+	key = (key<<RENDER_KEY_MATERIAL_BITS) |
+		(material & ((1u<<RENDER_KEY_MATERIAL_BITS)-1));
+	key = (key<<RENDER_KEY_MESH_BITS) |
+		(mesh & ((1u<<RENDER_KEY_MESH_BITS)-1));
+	key = (key<<RENDER_KEY_DEPTH_BITS) | d;
+	return(key);
+}
+
+GLvoid RenderQueue::Clear()
+{
+	//The capacity is kept, the next frame submits about as many items
+	items.clear();
+	transforms.clear();
+	order.clear();
+}
+
+GLuint RenderQueue::AddTransform(const Matrix4 &model, const Matrix4 &normal)
+{
+	transforms.push_back(model.ToMat4());
+	transforms.push_back(normal.ToMat4());
+	return(transforms.size()/2-1);
+}
+
+GLvoid RenderQueue::Submit(uint64_t key, Shader *shader, const Mesh *mesh,
+		GLuint group, GLuint transform)
+{
+	RenderItem item = {shader, mesh, group, transform};
+	RenderSortEntry entry = {key, (GLuint)items.size()};
+	items.push_back(item);
+	order.push_back(entry);
+}
+
+GLvoid RenderQueue::Sort()
+{
+	//Count the values of every byte of the keys in a single pass
+	size_t n = order.size();
+	if(n < 2) return;
+	size_t counts[8][256];
+	memset(counts, 0, sizeof(counts));
+	for(size_t i = 0; i < n; i++)
+	{
+		uint64_t key = order[i].key;
+		for(GLuint b = 0; b < 8; b++) counts[b][(key>>(8*b)) & 0xFF]++;
+	}
+
+	//Scatter the entries by each byte, starting with the least significant.
+	//Each pass is stable, so the order of the previous bytes is kept.
+	scratch.resize(n);
+	for(GLuint b = 0; b < 8; b++)
+	{
+		if(counts[b][(order[0].key>>(8*b)) & 0xFF] == n) continue;
+
+		size_t offsets[256], sum = 0;
+		for(GLuint v = 0; v < 256; v++) offsets[v] = sum, sum += counts[b][v];
+		for(size_t i = 0; i < n; i++)
+			scratch[offsets[(order[i].key>>(8*b)) & 0xFF]++] = order[i];
+		order.swap(scratch);
+	}
+}
+
+RenderQueueStats RenderQueue::Walk(GLboolean draw) const
+{
+	RenderQueueStats stats;
+	const Shader *shader = NULL;
+	const Mesh *mesh = NULL;
+	const UniformBuffer *materialBuffer = NULL;
+	GLuint group = 0, material = 0, transform = 0;
+
+	for(size_t i = 0; i < order.size(); i++)
+	{
+		const RenderItem &item = items[order[i].item];
+		const TriangleGroup &grp = item.mesh->g[item.group];
+
+		//A new program needs its own matrices, even if they're the same
+		//as the last item's
+		GLboolean newProgram = (item.shader != shader);
+		if(newProgram)
+		{
+			shader = item.shader;
+			stats.programChanges++;
+			if(draw) GLState::UseProgram(shader->program);
+		}
+
+		GLuint block = item.mesh->MaterialBlock(grp);
+		if(&item.mesh->materialBuffer != materialBuffer || block != material)
+		{
+			materialBuffer = &item.mesh->materialBuffer, material = block;
+			stats.materialChanges++;
+			if(draw)
+			{
+				GLsizeiptr stride = item.mesh->materialStride;
+				materialBuffer->BindRange(UNIFORM_BLOCK_MATERIAL,
+					block*stride, stride);
+			}
+		}
+
+		//Every group has its own vertex array object
+		if(item.mesh != mesh || item.group != group)
+		{
+			mesh = item.mesh, group = item.group;
+			stats.vaoChanges++;
+			if(draw) GLState::BindVertexArray(grp.vao);
+		}
+
+		if(newProgram || item.transform != transform)
+		{
+			transform = item.transform;
+			stats.transformChanges++;
+			if(draw)
+			{
+				//The handles were looked up when the program was linked
+				item.shader->SetUniformMatrix(
+					shader->slots[SHADER_UNIFORM_MODEL], 
+					transforms[2*transform].m);
+				item.shader->SetUniformMatrix(
+					shader->slots[SHADER_UNIFORM_NORMALMATRIX],
+					transforms[2*transform+1].m);
+			}
+		}
+
+		if(draw) item.mesh->DrawGroup(grp);
+		stats.items++;
+	}
+	return(stats);
+}
+
+RenderQueueStats RenderQueue::Simulate() const
+{
+	return(Walk(false));
+}
+
+RenderQueueStats RenderQueue::Execute()
+{
+	Sort();
+	stats = Walk(true);
+	return(stats);
+}
@@ -4,11 +4,40 @@
 
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <cstring>
 
 #include <Shader.h>
+#include <GLState.h>
 
 using namespace std;
 
+ShaderUniformStats::ShaderUniformStats()
+{
+	issued = 0, skipped = 0;
+}
+
+const string ShaderUniformStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	size_t total = issued+skipped;
+	GLfloat percent = (total > 0) ? (100.0f*skipped)/total : 0.0f;
+	s<<left;
+	s<<setw(15)<<"UNIFORMS"<<": "<<issued<<" uploaded, "<<skipped<<
+		" unchanged and skipped ("<<percent<<"%)";
+	return(s.str());
+}
+
+//The names of the ShaderUniformSlots
+static const GLchar *slotNames[SHADER_UNIFORM_SLOTS] = {"model", 
+	"normalmatrix"};
+
+Shader::Shader()
+{
+	program = 0;
+	for(GLuint i = 0; i < SHADER_UNIFORM_SLOTS; i++) slots[i] = -1;
+}
+
 GLboolean Shader::Open(const string &filename)
 {
 	//Deallocate previously used resources, if any exist
@@ -276,12 +305,144 @@ GLuint Shader::LinkShaderObjects()
 		return(0);
 	}
 
-	//If all goes well, assign the handle to shaderProgram and return the
-	//handle
+	//If all goes well, assign the handle to shaderProgram, list its 
+	//variables and return the handle
 	this->program = program;
+	QueryVariables();
 	return(program);
 }
 
+GLvoid Shader::QueryVariables()
+{
+	//The values uploaded before belong to the previous program
+	vector<ShaderUniform>().swap(uniforms);
+	vector<ShaderAttribute>().swap(attributes);
+	uniformLookup.clear();
+
+	//The name buffer has to fit the longest name of either kind
+	GLint numUniforms = 0, numAttributes = 0, uniformLength = 0;
+	GLint attributeLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniformLength);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &numAttributes);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attributeLength);
+	vector<GLchar> name(max(uniformLength, attributeLength)+1);
+
+	for(GLint i = 0; i < numUniforms; i++)
+	{
+		ShaderUniform u;
+		GLsizei length = 0;
+		glGetActiveUniform(program, i, name.size(), &length, &u.size, &u.type,
+			&name.front());
+		u.name = string(&name.front(), length);
+
+		//Arrays are reported by their first element, uniforms in uniform
+		//blocks have no location and are set through their buffer
+		if(u.name.size() > 3 && 
+				u.name.compare(u.name.size()-3, 3, "[0]") == 0)
+			u.name.erase(u.name.size()-3);
+		u.location = glGetUniformLocation(program, u.name.c_str());
+		if(u.location < 0) continue;
+
+		u.cached = false;
+		memset(u.value, 0, sizeof(u.value));
+		uniformLookup[u.name] = uniforms.size();
+		uniforms.push_back(u);
+	}
+
+	//Built in attributes, like gl_VertexID, have no location
+	for(GLint i = 0; i < numAttributes; i++)
+	{
+		ShaderAttribute a;
+		GLsizei length = 0;
+		glGetActiveAttrib(program, i, name.size(), &length, &a.size, &a.type,
+			&name.front());
+		a.name = string(&name.front(), length);
+		a.location = glGetAttribLocation(program, a.name.c_str());
+		if(a.location >= 0) attributes.push_back(a);
+	}
+
+	for(GLuint i = 0; i < SHADER_UNIFORM_SLOTS; i++) 
+		slots[i] = Uniform(slotNames[i]);
+}
+
+GLint Shader::Uniform(const string &name) const
+{
+	map<string, GLint>::const_iterator it = uniformLookup.find(name);
+	return((it == uniformLookup.end()) ? -1 : it->second);
+}
+
+GLint Shader::Attribute(const string &name) const
+{
+	for(GLuint i = 0; i < attributes.size(); i++)
+	{
+		if(attributes[i].name == name) return(attributes[i].location);
+	}
+	return(-1);
+}
+
+GLboolean Shader::BindUniformBlock(const string &name, GLuint binding)
+{
+	GLuint index = glGetUniformBlockIndex(program, name.c_str());
+	if(index == GL_INVALID_INDEX) return(false);
+	glUniformBlockBinding(program, index, binding);
+	return(true);
+}
+
+//Compares the value with the last one uploaded to the uniform and remembers
+//it. Returns the location to upload the value to, or -1 if the handle is
+//invalid or the value hasn't changed.
+static GLint UploadLocation(vector<ShaderUniform> &uniforms, GLint handle,
+	const GLvoid *value, size_t size, ShaderUniformStats &stats)
+{
+	if(handle < 0 || handle >= (GLint)uniforms.size()) return(-1);
+	ShaderUniform &u = uniforms[handle];
+	if(size > sizeof(u.value)) {stats.issued++; return(u.location);}
+	if(u.cached && memcmp(u.value, value, size) == 0)
+	{
+		stats.skipped++;
+		return(-1);
+	}
+	memcpy(u.value, value, size);
+	u.cached = true;
+	stats.issued++;
+	return(u.location);
+}
+
+GLvoid Shader::SetUniform(GLint handle, GLint x)
+{
+	GLint l = UploadLocation(uniforms, handle, &x, sizeof(x), uniformStats);
+	if(l >= 0) glUniform1i(l, x);
+}
+
+GLvoid Shader::SetUniform(GLint handle, GLfloat x)
+{
+	GLint l = UploadLocation(uniforms, handle, &x, sizeof(x), uniformStats);
+	if(l >= 0) glUniform1f(l, x);
+}
+
+GLvoid Shader::SetUniform(GLint handle, GLfloat x, GLfloat y, GLfloat z)
+{
+	GLfloat v[3] = {x, y, z};
+	GLint l = UploadLocation(uniforms, handle, v, sizeof(v), uniformStats);
+	if(l >= 0) glUniform3fv(l, 1, v);
+}
+
+GLvoid Shader::SetUniform(GLint handle, GLfloat x, GLfloat y, GLfloat z,
+		GLfloat w)
+{
+	GLfloat v[4] = {x, y, z, w};
+	GLint l = UploadLocation(uniforms, handle, v, sizeof(v), uniformStats);
+	if(l >= 0) glUniform4fv(l, 1, v);
+}
+
+GLvoid Shader::SetUniformMatrix(GLint handle, const GLfloat *m)
+{
+	GLint l = UploadLocation(uniforms, handle, m, 16*sizeof(GLfloat), 
+		uniformStats);
+	if(l >= 0) glUniformMatrix4fv(l, 1, GL_FALSE, m);
+}
+
 GLvoid Shader::DeleteShaderObjects()
 {
 	//Loop through the shader objects and delete each of them
@@ -302,7 +463,14 @@ GLvoid Shader::Close()
 {
 	//Delete the shader objects and the program
 	DeleteShaderObjects();
-	glDeleteProgram(program);
+	if(program != 0) GLState::DeleteProgram(program);
+	program = 0;
+
+	//The variables belong to the program
+	vector<ShaderUniform>().swap(uniforms);
+	vector<ShaderAttribute>().swap(attributes);
+	uniformLookup.clear();
+	for(GLuint i = 0; i < SHADER_UNIFORM_SLOTS; i++) slots[i] = -1;
 }
 
 Shader::~Shader()
@@ -0,0 +1,335 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <algorithm>
+
+#include <Simplifier.h>
+
+using namespace std;
+
+//A symmetric 4x4 matrix measuring the area weighted sum of squared
+//distances to a set of planes, and the total area
+struct Quadric {
+	GLdouble a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+	GLdouble weight;
+};
+
+//A candidate collapse of the vertex from onto the vertex to
+struct Collapse {
+	GLuint from;
+	GLuint to;
+	GLfloat cost;
+
+	GLboolean operator<(const Collapse &c) const {return(cost < c.cost);}
+};
+
+//Adds the quadric r to the quadric q
+static GLvoid AddQuadric(Quadric &q, const Quadric &r)
+{
+	q.a2 += r.a2, q.b2 += r.b2, q.c2 += r.c2, q.d2 += r.d2;
+	q.ab += r.ab, q.ac += r.ac, q.ad += r.ad;
+	q.bc += r.bc, q.bd += r.bd, q.cd += r.cd;
+	q.weight += r.weight;
+}
+
+//Returns the mean squared distance of the point p to the planes of q
+static GLfloat Evaluate(const Quadric &q, const Vector3 &p)
+{
+	if(q.weight <= 0.0) return(0.0f);
+	GLdouble x = p.x, y = p.y, z = p.z;
+	GLdouble e = q.a2*x*x+q.b2*y*y+q.c2*z*z+q.d2+
+		2.0*(q.ab*x*y+q.ac*x*z+q.ad*x+q.bc*y*z+q.bd*y+q.cd*z);
+	return((GLfloat)max(0.0, e/q.weight));
+}
+
+//Checks if moving the vertex from onto the vertex to turns any of the
+//triangles around from, other than the ones that disappear, over. The
+//triangles are taken as they are after the collapses in remap, which were
+//made earlier in the same pass.
+static GLboolean Flips(const vector<Vector3> &positions,
+		const vector<GLuint> &triangles, const vector<GLuint> &remap,
+		const GLuint *adjacent, GLuint count, GLuint from, GLuint to)
+{
+	for(GLuint i = 0; i < count; i++)
+	{
+		const GLuint *t = &triangles.front()+3*adjacent[i];
+		GLuint tri[3] = {remap[t[0]], remap[t[1]], remap[t[2]]};
+		if(tri[0] == to || tri[1] == to || tri[2] == to) continue;
+		if(tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0]) 
+			continue;
+
+		Vector3 p[3];
+		for(GLuint c = 0; c < 3; c++) p[c] = positions[tri[c]];
+		Vector3 before = (p[1]-p[0]).CrossProduct(p[2]-p[0]);
+		for(GLuint c = 0; c < 3; c++) if(tri[c] == from) p[c] = positions[to];
+		Vector3 after = (p[1]-p[0]).CrossProduct(p[2]-p[0]);
+		if(before*after <= 0.0f) return(true);
+	}
+	return(false);
+}
+
+//Returns the distance of the point p to the triangle abc
+static GLfloat TriangleDistance(const Vector3 &p, const Vector3 &a, 
+		const Vector3 &b, const Vector3 &c)
+{
+	//Find the feature of the triangle nearest to p from the barycentric 
+	//coordinates of its projection: a corner, an edge or the inside
+	Vector3 ab = b-a, ac = c-a, ap = p-a;
+	GLfloat d1 = ab*ap, d2 = ac*ap;
+	if(d1 <= 0.0f && d2 <= 0.0f) return(p.Distance(a));
+
+	Vector3 bp = p-b;
+	GLfloat d3 = ab*bp, d4 = ac*bp;
+	if(d3 >= 0.0f && d4 <= d3) return(p.Distance(b));
+
+	GLfloat vc = d1*d4-d3*d2;
+	if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return(p.Distance(a+ab*(d1/(d1-d3))));
+
+	Vector3 cp = p-c;
+	GLfloat d5 = ab*cp, d6 = ac*cp;
+	if(d6 >= 0.0f && d5 <= d6) return(p.Distance(c));
+
+	GLfloat vb = d5*d2-d1*d6;
+	if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return(p.Distance(a+ac*(d2/(d2-d6))));
+
+	GLfloat va = d3*d6-d5*d4;
+	if(va <= 0.0f && d4-d3 >= 0.0f && d5-d6 >= 0.0f)
+		return(p.Distance(b+(c-b)*((d4-d3)/((d4-d3)+(d5-d6)))));
+
+	//Degenerate triangles end up here with a zero denominator
+	GLfloat sum = va+vb+vc;
+	if(sum <= 0.0f) return(p.Distance(a));
+	return(p.Distance(a+ab*(vb/sum)+ac*(vc/sum)));
+}
+
+//Returns the largest distance of an original vertex from the simplified
+//triangles around the vertex it was collapsed onto. Vertices still in use
+//lie on the simplified surface.
+static GLfloat Deviation(const vector<Vector3> &positions,
+		const vector<GLuint> &triangles, const vector<GLuint> &first,
+		const vector<GLuint> &adjacent, const vector<GLuint> &collapsedTo)
+{
+	GLfloat deviation = 0.0f;
+	for(GLuint i = 0; i < collapsedTo.size(); i++)
+	{
+		GLuint to = collapsedTo[i];
+		if(to == i) continue;
+
+		//A vertex whose triangles all vanished is measured to the vertex
+		GLfloat nearest = positions[i].Distance(positions[to]);
+		for(GLuint k = first[to]; k < first[to+1]; k++)
+		{
+			const GLuint *tri = &triangles.front()+3*adjacent[k];
+			nearest = min(nearest, TriangleDistance(positions[i], 
+				positions[tri[0]], positions[tri[1]], positions[tri[2]]));
+		}
+		deviation = max(deviation, nearest);
+	}
+	return(deviation);
+}
+
+//Copies the triangles, numbered like the original vertex array
+static GLvoid KeepTriangles(const vector<GLuint> &triangles, 
+		const vector<GLuint> &unique, vector<GLuint> &lod)
+{
+	lod.resize(triangles.size());
+	for(size_t i = 0; i < triangles.size(); i++) lod[i] = unique[triangles[i]];
+}
+
+GLvoid Simplifier::Simplify(const Vector3 *vertices, const GLubyte *locked,
+		const GLuint *indices, size_t count, const vector<size_t> &targets,
+		vector<vector<GLuint> > &lods, vector<GLfloat> &errors)
+{
+	lods.assign(targets.size(), vector<GLuint>());
+	errors.assign(targets.size(), 0.0f);
+	count -= count%3;
+	if(count == 0 || targets.empty()) return;
+
+	//Number the vertices of the triangles from zero, so the work arrays
+	//only hold the vertices that are used
+	vector<GLuint> unique(indices, indices+count);
+	sort(unique.begin(), unique.end());
+	unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+	GLuint n = unique.size();
+	//Triangles that are already degenerate are dropped
+	vector<GLuint> triangles;
+	triangles.reserve(count);
+	for(size_t t = 0; t < count; t += 3)
+	{
+		const GLuint *tri = indices+t;
+		if(tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0]) continue;
+		for(GLuint c = 0; c < 3; c++)
+		{
+			triangles.push_back(lower_bound(unique.begin(), unique.end(), 
+				tri[c])-unique.begin());
+		}
+	}
+	count = triangles.size();
+	vector<Vector3> positions(n);
+	vector<GLubyte> lock(n, 0);
+	for(GLuint i = 0; i < n; i++)
+	{
+		positions[i] = vertices[unique[i]];
+		if(locked != NULL) lock[i] = locked[unique[i]];
+	}
+
+	//Every vertex starts with the planes of its triangles
+	Quadric zero = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+	vector<Quadric> quadrics(n, zero);
+	for(size_t t = 0; t < count; t += 3)
+	{
+		const Vector3 &a = positions[triangles[t]];
+		const Vector3 &b = positions[triangles[t+1]];
+		const Vector3 &c = positions[triangles[t+2]];
+		Vector3 normal = (b-a).CrossProduct(c-a);
+		GLdouble l = normal.Length();
+		if(l == 0.0) continue;
+
+		GLdouble x = normal.x/l, y = normal.y/l, z = normal.z/l;
+		GLdouble d = -(x*a.x+y*a.y+z*a.z), w = 0.5*l;
+		Quadric q = {w*x*x, w*y*y, w*z*z, w*d*d, w*x*y, w*x*z, w*x*d,
+			w*y*z, w*y*d, w*z*d, w};
+		for(GLuint k = 0; k < 3; k++) AddQuadric(quadrics[triangles[t+k]], q);
+	}
+
+	//Edges without a twin running the other way lie on a border, which
+	//would shrink if its vertices moved
+	vector<GLuint64> edges(count);
+	for(size_t t = 0; t < count; t += 3)
+	{
+		for(GLuint c = 0; c < 3; c++)
+		{
+			edges[t+c] = ((GLuint64)triangles[t+c] << 32) |
+				triangles[t+(c+1)%3];
+		}
+	}
+	sort(edges.begin(), edges.end());
+	for(size_t i = 0; i < count; i++)
+	{
+		GLuint a = edges[i] >> 32, b = edges[i] & 0xFFFFFFFF;
+		if(!binary_search(edges.begin(), edges.end(), ((GLuint64)b << 32) | a))
+			lock[a] = lock[b] = 1;
+	}
+
+	//Collapse in passes. Each pass collapses the cheapest edges, but moves
+	//or keeps every vertex at most once, so the costs stay valid for the
+	//whole pass.
+	vector<GLuint> first(n+1), adjacent(count), remap(n), collapsedTo(n);
+	vector<GLubyte> used(n);
+	vector<Collapse> collapses;
+	for(GLuint i = 0; i < n; i++) collapsedTo[i] = i;
+	GLfloat error = 0.0f;
+	size_t target = 0;
+	while(true)
+	{
+		//The triangles around each vertex
+		size_t size = triangles.size();
+		fill(first.begin(), first.end(), 0);
+		for(size_t i = 0; i < size; i++) first[triangles[i]+1]++;
+		for(GLuint i = 0; i < n; i++) first[i+1] += first[i];
+		for(size_t i = 0; i < size; i++)
+			adjacent[first[triangles[i]]++] = i/3;
+		for(GLuint i = n; i > 0; i--) first[i] = first[i-1];
+		first[0] = 0;
+
+		//Keep the triangles of every target reached. A level is never 
+		//reported as closer than the one before it.
+		if(target < targets.size() && size <= targets[target])
+		{
+			error = max(error, Deviation(positions, triangles, first, 
+				adjacent, collapsedTo));
+		}
+		while(target < targets.size() && size <= targets[target])
+		{
+			KeepTriangles(triangles, unique, lods[target]);
+			errors[target++] = error;
+		}
+		if(target == targets.size()) break;
+
+		//Both directions of every edge, interior edges are listed by the
+		//one triangle that has them running up
+		collapses.clear();
+		for(size_t t = 0; t < size; t += 3)
+		{
+			for(GLuint c = 0; c < 3; c++)
+			{
+				GLuint a = triangles[t+c], b = triangles[t+(c+1)%3];
+				if(a >= b) continue;
+				Quadric q = quadrics[a];
+				AddQuadric(q, quadrics[b]);
+				if(!lock[a])
+				{
+					Collapse collapse = {a, b, Evaluate(q, positions[b])};
+					collapses.push_back(collapse);
+				}
+				if(!lock[b])
+				{
+					Collapse collapse = {b, a, Evaluate(q, positions[a])};
+					collapses.push_back(collapse);
+				}
+			}
+		}
+		sort(collapses.begin(), collapses.end());
+
+		//Collapse until enough triangles are gone for the next target
+		size_t budget = (size-targets[target])/3, removed = 0;
+		fill(used.begin(), used.end(), 0);
+		for(GLuint i = 0; i < n; i++) remap[i] = i;
+		GLuint collapsed = 0;
+		for(size_t i = 0; i < collapses.size() && removed < budget; i++)
+		{
+			const Collapse &c = collapses[i];
+			if(used[c.from] || used[c.to]) continue;
+			const GLuint *around = &adjacent.front()+first[c.from];
+			GLuint aroundCount = first[c.from+1]-first[c.from];
+			if(Flips(positions, triangles, remap, around, aroundCount, 
+					c.from, c.to))
+				continue;
+
+			for(GLuint k = 0; k < aroundCount; k++)
+			{
+				const GLuint *t = &triangles.front()+3*around[k];
+				GLuint tri[3] = {remap[t[0]], remap[t[1]], remap[t[2]]};
+				if(tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+					continue;
+				if(tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+					removed++;
+			}
+			remap[c.from] = c.to;
+			used[c.from] = used[c.to] = 1;
+			AddQuadric(quadrics[c.to], quadrics[c.from]);
+			collapsed++;
+		}
+		if(collapsed == 0) break;
+		for(GLuint i = 0; i < n; i++) collapsedTo[i] = remap[collapsedTo[i]];
+
+		//Move the collapsed vertices and drop the triangles that vanished
+		size_t kept = 0;
+		for(size_t t = 0; t < size; t += 3)
+		{
+			GLuint a = remap[triangles[t]], b = remap[triangles[t+1]];
+			GLuint c = remap[triangles[t+2]];
+			if(a == b || b == c || c == a) continue;
+			triangles[kept++] = a, triangles[kept++] = b, triangles[kept++] = c;
+		}
+		triangles.resize(kept);
+	}
+
+	//Too many locked vertices to reach the remaining targets, they get the
+	//smallest triangle list there is. The triangles around each vertex are
+	//still those of the last pass, which collapsed nothing.
+	if(target < targets.size())
+	{
+		error = max(error, Deviation(positions, triangles, first, adjacent,
+			collapsedTo));
+	}
+	for(; target < targets.size(); target++)
+	{
+		KeepTriangles(triangles, unique, lods[target]);
+		errors[target] = error;
+	}
+}
@@ -0,0 +1,178 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <SFML/System/Clock.hpp>
+#include <sstream>
+#include <iomanip>
+
+#include <StreamBuffer.h>
+#include <GLState.h>
+
+using namespace std;
+
+StreamBufferStats::StreamBufferStats()
+{
+	bytes = 0, allocations = 0, waits = 0, waitTime = 0.0f, orphans = 0;
+}
+
+const string StreamBufferStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s<<left;
+	s<<setw(15)<<"STREAM BUFFER"<<": "<<bytes<<" bytes in "<<allocations<<
+		" ranges, "<<waits<<" fence waits ("<<waitTime<<" ms), "<<orphans<<
+		" orphans";
+	return(s.str());
+}
+
+StreamBuffer::StreamBuffer()
+{
+	buffer = 0, target = GL_ARRAY_BUFFER, size = 0, persistent = false;
+	mapped = NULL, head = 0, frameStart = 0;
+}
+
+GLboolean StreamBuffer::Create(GLenum target, GLsizeiptr frameSize,
+		GLboolean allowPersistent)
+{
+	Close();
+	this->target = target;
+	size = STREAM_BUFFER_FRAMES*frameSize;
+	persistent = allowPersistent && GLEW_ARB_buffer_storage;
+	glGenBuffers(1, &buffer);
+	GLState::BindBuffer(target, buffer);
+
+	if(persistent)
+	{
+		//The storage can't be reallocated, so it stays mapped for as long
+		//as the buffer lives. Coherent writes need no flushing.
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+			GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, size, NULL, flags);
+		mapped = (GLubyte*)glMapBufferRange(target, 0, size, flags);
+		if(mapped == NULL)
+		{
+			Close();
+			return(false);
+		}
+	}
+	else glBufferData(target, size, NULL, GL_STREAM_DRAW);
+	return(true);
+}
+
+GLvoid StreamBuffer::WaitFor(GLintptr start, GLintptr end)
+{
+	//Frames are fenced in order, so waiting for the newest overlapping
+	//frame also waits for the ones before it
+	GLint last = -1;
+	for(GLuint i = 0; i < fences.size(); i++)
+	{
+		const StreamFence &f = fences[i];
+		GLboolean overlaps = (f.start <= f.end) ?
+			(start < f.end && f.start < end) :
+			(start < f.end || f.start < end);
+		if(overlaps) last = i;
+	}
+	if(last < 0) return;
+
+	GLsync sync = fences[last].sync;
+	GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if(result == GL_TIMEOUT_EXPIRED)
+	{
+		//The GPU is behind, wait in steps of a millisecond
+		sf::Clock timer;
+		while(result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(sync, 0, 1000000);
+		stats.waits++;
+		stats.waitTime += timer.getElapsedTime().asSeconds()*1000.0f;
+	}
+	for(GLint i = 0; i <= last; i++)
+	{
+		glDeleteSync(fences.front().sync);
+		fences.pop_front();
+	}
+}
+
+GLvoid *StreamBuffer::Map(GLsizeiptr bytes, GLsizeiptr alignment,
+		GLintptr &offset)
+{
+	if(buffer == 0 || bytes <= 0 || bytes > size) return(NULL);
+	Unmap();
+	if(alignment < 1) alignment = 1;
+	GLintptr start = ((head+alignment-1)/alignment)*alignment;
+
+	//Wrap to the start of the ring. Without buffer storage the old storage
+	//is orphaned, the GPU keeps it until it is done with it.
+	if(start+bytes > size)
+	{
+		start = 0;
+		if(!persistent)
+		{
+			GLState::BindBuffer(target, buffer);
+			glBufferData(target, size, NULL, GL_STREAM_DRAW);
+			stats.orphans++;
+		}
+	}
+	head = start+bytes;
+	offset = start;
+	stats.bytes += bytes;
+	stats.allocations++;
+
+	if(persistent)
+	{
+		WaitFor(start, start+bytes);
+		return(mapped+start);
+	}
+
+	//Nothing the GPU reads is overwritten before the storage is orphaned,
+	//so the mapping needs no synchronization
+	GLState::BindBuffer(target, buffer);
+	mapped = (GLubyte*)glMapBufferRange(target, start, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+		GL_MAP_UNSYNCHRONIZED_BIT);
+	return(mapped);
+}
+
+GLvoid StreamBuffer::Unmap()
+{
+	if(persistent || mapped == NULL) return;
+	GLState::BindBuffer(target, buffer);
+	glUnmapBuffer(target);
+	mapped = NULL;
+}
+
+GLvoid StreamBuffer::EndFrame()
+{
+	Unmap();
+	if(persistent && head != frameStart)
+	{
+		StreamFence f;
+		f.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		f.start = frameStart, f.end = head;
+		fences.push_back(f);
+	}
+	frameStart = head;
+	lastFrame = stats;
+	stats = StreamBufferStats();
+}
+
+GLvoid StreamBuffer::Close()
+{
+	//Deleting a fence the GPU hasn't reached is fine, it is deleted once
+	//it is signaled
+	for(GLuint i = 0; i < fences.size(); i++) glDeleteSync(fences[i].sync);
+	fences.clear();
+	if(buffer != 0 && mapped != NULL)
+	{
+		GLState::BindBuffer(target, buffer);
+		glUnmapBuffer(target);
+	}
+	if(buffer != 0) GLState::DeleteBuffers(1, &buffer);
+	buffer = 0, size = 0, persistent = false, mapped = NULL;
+	head = 0, frameStart = 0;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	Close();
+}
@@ -0,0 +1,200 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+
+#include <Tokenizer.h>
+
+using namespace std;
+
+//Powers of ten that can be represented exactly by a double
+static const double pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+Tokenizer::Tokenizer(const GLchar *begin, const GLchar *end)
+{
+	this->pos=begin, this->end=end;
+}
+
+GLboolean Tokenizer::Done() const
+{
+	return(pos >= end);
+}
+
+GLvoid Tokenizer::SkipSpaces()
+{
+	while(pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) pos++;
+}
+
+GLvoid Tokenizer::SkipToken()
+{
+	while(pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' &&
+			*pos != '\n') pos++;
+}
+
+GLvoid Tokenizer::NextLine()
+{
+	//memchr is a lot faster than looping over each character ourselves
+	const GLchar *eol = (const GLchar*)memchr(pos, '\n', end-pos);
+	pos = (eol == NULL) ? end : eol+1;
+}
+
+GLboolean Tokenizer::EndOfLine()
+{
+	SkipSpaces();
+	return(pos >= end || *pos == '\n');
+}
+
+GLboolean Tokenizer::Keyword(const GLchar *keyword)
+{
+	const GLchar *p = pos;
+	while(*keyword != '\0')
+	{
+		if(p >= end || *p != *keyword) return(false);
+		p++, keyword++;
+	}
+
+	//The keyword must not just be the prefix of a longer word
+	if(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+		return(false);
+
+	pos = p;
+	return(true);
+}
+
+GLfloat Tokenizer::ReadFloat()
+{
+	SkipSpaces();
+	const GLchar *start = pos;
+
+	GLboolean negative = false;
+	if(pos < end && (*pos == '-' || *pos == '+')) negative = (*pos++ == '-');
+
+	//Accumulate up to 19 significant digits into a 64 bit integer, that is
+	//the most that is guaranteed not to overflow. The decimal point and any
+	//dropped digits are accounted for in the exponent.
+	uint64_t mantissa = 0;
+	GLint exponent = 0, digits = 0;
+	GLboolean found = false, truncated = false;
+	while(pos < end && *pos >= '0' && *pos <= '9')
+	{
+		if(digits < 19) 
+		{
+			mantissa = mantissa*10+(*pos-'0');
+			if(mantissa != 0) digits++;
+		}
+		else
+		{
+			exponent++;
+			if(*pos != '0') truncated = true;
+		}
+		found = true, pos++;
+	}
+	if(pos < end && *pos == '.')
+	{
+		pos++;
+		while(pos < end && *pos >= '0' && *pos <= '9')
+		{
+			if(digits < 19) 
+			{
+				mantissa = mantissa*10+(*pos-'0');
+				if(mantissa != 0) digits++;
+				exponent--;
+			}
+			else if(*pos != '0') truncated = true;
+			found = true, pos++;
+		}
+	}
+
+	//No digits at all means there is no number here
+	if(!found) {pos = start; return(0.0f);}
+
+	//The exponent is only valid if there is at least one digit after the 'e'
+	if(pos < end && (*pos == 'e' || *pos == 'E'))
+	{
+		const GLchar *e = pos++;
+		GLboolean enegative = false;
+		if(pos < end && (*pos == '-' || *pos == '+')) 
+			enegative = (*pos++ == '-');
+		if(pos < end && *pos >= '0' && *pos <= '9')
+		{
+			GLint value = 0;
+			while(pos < end && *pos >= '0' && *pos <= '9')
+			{
+				if(value < 100000) value = value*10+(*pos-'0');
+				pos++;
+			}
+			exponent += (enegative ? -value : value);
+		}
+		else pos = e;
+	}
+
+	//Fast path: the mantissa and the power of ten are both exact doubles so
+	//the multiplication or division is correctly rounded to a double. The
+	//result fits comfortably within the range of a normal float.
+	if(!truncated && mantissa < (((uint64_t)1)<<53) && exponent >= -22 &&
+			exponent <= 22)
+	{
+		double value = (double)mantissa;
+		value = (exponent < 0) ? value/pow10[-exponent] : value*pow10[exponent];
+
+		//Rounding the double to a float gives the correctly rounded float
+		//unless the double landed exactly halfway between two floats (the
+		//low 29 bits of the double's fraction are 1000...0). In that rare
+		//case the true value could be on either side, so use the slow path.
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		if((bits & 0x1FFFFFFF) != 0x10000000)
+			return((GLfloat)(negative ? -value : value));
+	}
+
+	//Slow path: hand the token to strtof. The program never changes the 
+	//locale from "C", and the token has to be copied because the range isn't
+	//null terminated.
+	GLchar buf[64];
+	size_t length = pos-start;
+	if(length < sizeof(buf))
+	{
+		memcpy(buf, start, length);
+		buf[length] = '\0';
+		return(strtof(buf, NULL));
+	}
+	return(strtof(string(start, length).c_str(), NULL));
+}
+
+GLint Tokenizer::ReadInt()
+{
+	SkipSpaces();
+
+	GLboolean negative = false;
+	const GLchar *start = pos;
+	if(pos < end && (*pos == '-' || *pos == '+')) negative = (*pos++ == '-');
+
+	GLint value = 0;
+	const GLchar *digits = pos;
+	while(pos < end && *pos >= '0' && *pos <= '9') value=value*10+(*pos++-'0');
+
+	//A sign on its own is not a number
+	if(pos == digits) {pos = start; return(0);}
+
+	return(negative ? -value : value);
+}
+
+const string Tokenizer::ReadLine()
+{
+	SkipSpaces();
+	const GLchar *start = pos;
+	while(pos < end && *pos != '\n') pos++;
+
+	//Drop trailing whitespace, such as the '\r' in a DOS line ending
+	const GLchar *last = pos;
+	while(last > start && (last[-1] == '\r' || last[-1] == ' ' || 
+				last[-1] == '\t')) last--;
+
+	return(string(start, last-start));
+}
@@ -0,0 +1,142 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <sstream>
+
+#include <Transform.h>
+
+#define PI 3.14159265358979323846264338327950288419716939937510582097494459231f
+
+using namespace std;
+
+Quaternion::Quaternion()
+{
+	x=0, y=0, z=0, w=1;
+}
+
+Quaternion::Quaternion(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+	this->x=x, this->y=y, this->z=z, this->w=w;
+}
+
+Quaternion Quaternion::FromAxisAngle(const Vector3 &axis, GLfloat angle)
+{
+	GLfloat l = axis.Length();
+	if(l == 0.0f) return(Quaternion());
+	GLfloat half = angle*(PI/180.0f)/2.0f;
+	GLfloat s = sinf(half)/l;
+	return(Quaternion(axis.x*s, axis.y*s, axis.z*s, cosf(half)));
+}
+
+Quaternion Quaternion::Normalize() const
+{
+	GLfloat l = sqrtf(x*x+y*y+z*z+w*w);
+	if(l == 0.0f) return(Quaternion());
+	return(Quaternion(x/l, y/l, z/l, w/l));
+}
+
+Quaternion Quaternion::Conjugate() const
+{
+	return(Quaternion(-x, -y, -z, w));
+}
+
+Quaternion Quaternion::Slerp(const Quaternion &q, GLfloat t) const
+{
+	//q and -q are the same rotation, the one closer to this quaternion
+	//takes the short way around
+	GLfloat d = x*q.x+y*q.y+z*q.z+w*q.w;
+	GLfloat k = (d < 0.0f) ? -1.0f : 1.0f;
+	d *= k;
+
+	//Nearly parallel quaternions are interpolated linearly, sin(theta)
+	//would be too small to divide by
+	GLfloat a = 1.0f-t, b = t;
+	if(d < 0.9995f)
+	{
+		GLfloat theta = acosf(d), s = sinf(theta);
+		a = sinf((1.0f-t)*theta)/s, b = sinf(t*theta)/s;
+	}
+	b *= k;
+	return(Quaternion(a*x+b*q.x, a*y+b*q.y, a*z+b*q.z,
+		a*w+b*q.w).Normalize());
+}
+
+Matrix4 Quaternion::ToMatrix() const
+{
+	Matrix4 m;
+	GLfloat xx = x*x, yy = y*y, zz = z*z, xy = x*y, xz = x*z, yz = y*z;
+	GLfloat wx = w*x, wy = w*y, wz = w*z;
+	m.mat[0] = 1.0f-2.0f*(yy+zz);
+	m.mat[1] = 2.0f*(xy+wz);
+	m.mat[2] = 2.0f*(xz-wy);
+	m.mat[4] = 2.0f*(xy-wz);
+	m.mat[5] = 1.0f-2.0f*(xx+zz);
+	m.mat[6] = 2.0f*(yz+wx);
+	m.mat[8] = 2.0f*(xz+wy);
+	m.mat[9] = 2.0f*(yz-wx);
+	m.mat[10] = 1.0f-2.0f*(xx+yy);
+	return(m);
+}
+
+Quaternion Quaternion::operator*(const Quaternion &q) const
+{
+	return(Quaternion(w*q.x+x*q.w+y*q.z-z*q.y,
+		w*q.y-x*q.z+y*q.w+z*q.x,
+		w*q.z+x*q.y-y*q.x+z*q.w,
+		w*q.w-x*q.x-y*q.y-z*q.z));
+}
+
+Vector3 Quaternion::operator*(const Vector3 &v) const
+{
+	//v+2w(q x v)+2q x (q x v), with q the vector part
+	Vector3 q(x, y, z);
+	Vector3 t = q.CrossProduct(v)*2.0f;
+	Vector3 r = v+t*w+q.CrossProduct(t);
+	r.w = v.w;
+	return(r);
+}
+
+const string Quaternion::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s << "(" << x << ", " << y << ", " << z << ", " << w << ")";
+	return(s.str());
+}
+
+Transform::Transform()
+	: position(0.0f, 0.0f, 0.0f), scale(1.0f, 1.0f, 1.0f)
+{
+}
+
+Matrix4 Transform::ToMatrix() const
+{
+	//The columns of the rotation scaled by the scale, with the translation
+	//in the fourth column
+	Matrix4 m = rotation.ToMatrix();
+	for(GLuint r = 0; r < 3; r++)
+	{
+		m.mat[r] *= scale.x, m.mat[4+r] *= scale.y, m.mat[8+r] *= scale.z;
+	}
+	m.mat[12] = position.x, m.mat[13] = position.y, m.mat[14] = position.z;
+	return(m);
+}
+
+Matrix4 Transform::InverseMatrix() const
+{
+	//The inverse scale times the transposed rotation, which moves the
+	//negated translation back into the object's space
+	if(scale.x == 0.0f || scale.y == 0.0f || scale.z == 0.0f)
+		return(Matrix4());
+	Matrix4 m = rotation.ToMatrix().Transpose();
+	GLfloat s[3] = {1.0f/scale.x, 1.0f/scale.y, 1.0f/scale.z};
+	for(GLuint c = 0; c < 3; c++)
+		for(GLuint r = 0; r < 3; r++) m.mat[4*c+r] *= s[r];
+	for(GLuint r = 0; r < 3; r++)
+	{
+		m.mat[12+r] = -(m.mat[r]*position.x+m.mat[4+r]*position.y+
+			m.mat[8+r]*position.z);
+	}
+	return(m);
+}
@@ -0,0 +1,118 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <UniformBuffer.h>
+#include <GLState.h>
+
+using namespace std;
+
+GLvoid Std140::Align(GLuint alignment)
+{
+	data.resize((data.size()+alignment-1) & ~(size_t)(alignment-1), 0);
+}
+
+GLvoid Std140::AddFloat(GLfloat x)
+{
+	Align(4);
+	const GLubyte *b = (const GLubyte*)&x;
+	data.insert(data.end(), b, b+sizeof(x));
+}
+
+GLvoid Std140::AddInt(GLint x)
+{
+	Align(4);
+	const GLubyte *b = (const GLubyte*)&x;
+	data.insert(data.end(), b, b+sizeof(x));
+}
+
+GLvoid Std140::AddVec3(const GLfloat *v)
+{
+	Align(16);
+	const GLubyte *b = (const GLubyte*)v;
+	data.insert(data.end(), b, b+3*sizeof(GLfloat));
+}
+
+GLvoid Std140::AddVec4(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+	GLfloat v[4] = {x, y, z, w};
+	Align(16);
+	const GLubyte *b = (const GLubyte*)v;
+	data.insert(data.end(), b, b+sizeof(v));
+}
+
+GLvoid Std140::AddMat4(const GLfloat *m)
+{
+	//The columns are vec4s, they are already packed
+	Align(16);
+	const GLubyte *b = (const GLubyte*)m;
+	data.insert(data.end(), b, b+16*sizeof(GLfloat));
+}
+
+GLsizeiptr Std140::Size()
+{
+	Align(16);
+	return(data.size());
+}
+
+GLvoid Std140::Clear()
+{
+	data.clear();
+}
+
+UniformBuffer::UniformBuffer()
+{
+	ubo = 0, size = 0;
+}
+
+GLvoid UniformBuffer::Create(GLsizeiptr size, const GLvoid *data,
+		GLenum usage)
+{
+	Close();
+	glGenBuffers(1, &ubo);
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, size, data, usage);
+	this->size = size;
+}
+
+GLvoid UniformBuffer::Update(GLintptr offset, GLsizeiptr size,
+		const GLvoid *data)
+{
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+GLvoid UniformBuffer::BindBase(GLuint binding) const
+{
+	GLState::BindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+}
+
+GLvoid UniformBuffer::BindRange(GLuint binding, GLintptr offset,
+		GLsizeiptr size) const
+{
+	GLState::BindBufferRange(GL_UNIFORM_BUFFER, binding, ubo, offset, size);
+}
+
+GLvoid UniformBuffer::Close()
+{
+	if(ubo != 0) GLState::DeleteBuffers(1, &ubo);
+	ubo = 0, size = 0;
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	Close();
+}
+
+GLsizeiptr UniformBuffer::Stride(GLsizeiptr size)
+{
+	//The alignment doesn't change, but it can only be queried once there
+	//is a context
+	static GLint alignment = 0;
+	if(alignment <= 0)
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if(alignment <= 0) alignment = 256;
+	}
+	return(((size+alignment-1)/alignment)*alignment);
+}
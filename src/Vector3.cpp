@@ -7,6 +7,7 @@
 #include <iomanip>
 
 #include <Vector3.h>
+#include <Simd.h>
 
 using namespace std;
 
@@ -25,9 +26,26 @@ Vector3::Vector3(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 	this->x=x, this->y=y, this->z=z, this->w=w;
 }
 
-Vector3::Vector3(const Vector3 &v)
+Vector3::Vector3(const Vec3f &v)
 {
-	*this = v;
+	x=v[0], y=v[1], z=v[2], w=1;
+}
+
+Vector3::Vector3(const Vec4f &v)
+{
+	x=v[0], y=v[1], z=v[2], w=v[3];
+}
+
+Vec3f Vector3::ToVec3() const
+{
+	Vec3f v = {{x, y, z}};
+	return(v);
+}
+
+Vec4f Vector3::ToVec4() const
+{
+	Vec4f v = {{x, y, z, w}};
+	return(v);
 }
 
 GLfloat Vector3::Distance(const Vector3 &v) const
@@ -37,13 +55,16 @@ GLfloat Vector3::Distance(const Vector3 &v) const
 
 Vector3 Vector3::Normalize() const
 {
-	GLfloat k = this->Length();
-	return(Vector3(x/k, y/k, z/k));
+	Vector3 v;
+	Simd::Store(&v.x, Simd::Normalize3(Simd::Load(&x)));
+	v.w = 1.0f;
+	return(v);
 }
 
 GLfloat Vector3::Length() const
 {
-	return(sqrt(x*x+y*y+z*z));
+	Simd4 v = Simd::Load(&x);
+	return(sqrt(Simd::Dot3(v, v)));
 }
 
 GLfloat Vector3::Angle(const Vector3 &v) const
@@ -53,7 +74,10 @@ GLfloat Vector3::Angle(const Vector3 &v) const
 
 Vector3 Vector3::CrossProduct(const Vector3 &v) const
 {
-	return(Vector3(y*v.z-z*v.y, z*v.x-x*v.z, x*v.y-y*v.x));
+	Vector3 c;
+	Simd::Store(&c.x, Simd::Cross3(Simd::Load(&x), Simd::Load(&v.x)));
+	c.w = 1.0f;
+	return(c);
 }
 
 Vector3 Vector3::operator+(const Vector3 &v) const
@@ -68,7 +92,7 @@ Vector3 Vector3::operator-(const Vector3 &v) const
 
 GLfloat Vector3::operator*(const Vector3 &v) const
 {
-	return(x*v.x+y*v.y+z*v.z);
+	return(Simd::Dot3(Simd::Load(&x), Simd::Load(&v.x)));
 }
 
 Vector3 Vector3::operator*(GLfloat k) const
@@ -76,15 +100,14 @@ Vector3 Vector3::operator*(GLfloat k) const
 	return(Vector3(x*k, y*k, z*k));
 }
 
-Vector3 Vector3::operator-() const
+Vector3 Vector3::operator/(GLfloat k) const
 {
-	return(Vector3(-x, -y, -z));
+	return(Vector3(x/k, y/k, z/k));
 }
 
-Vector3& Vector3::operator=(const Vector3 &v)
+Vector3 Vector3::operator-() const
 {
-	x=v.x, y=v.y, z=v.z, w=v.w;
-	return(*this);
+	return(Vector3(-x, -y, -z));
 }
 
 GLboolean Vector3::operator==(const Vector3 &v) const
@@ -0,0 +1,311 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#include <VertexCache.h>
+
+//Largest number of remaining triangles with a precomputed valence score
+#define VERTEX_CACHE_MAX_VALENCE 64
+
+using namespace std;
+
+//The scores of Forsyth's algorithm. The vertices of the last triangle get a
+//fixed score so that the next triangle doesn't simply reuse an edge of it,
+//the rest decay with their position in the cache. Vertices with few 
+//triangles left get a boost so that they are finished off, instead of 
+//leaving lone triangles behind.
+static const GLfloat cacheDecayPower = 1.5f;
+static const GLfloat lastTriangleScore = 0.75f;
+static const GLfloat valenceBoostScale = 2.0f;
+static const GLfloat valenceBoostPower = 0.5f;
+
+//Precomputed scores by cache position and by remaining triangles
+struct VertexScoreTable {
+	GLfloat cache[VERTEX_CACHE_LRU_SIZE];
+	GLfloat valence[VERTEX_CACHE_MAX_VALENCE];
+
+	VertexScoreTable()
+	{
+		for(GLuint i = 0; i < VERTEX_CACHE_LRU_SIZE; i++)
+		{
+			if(i < 3) cache[i] = lastTriangleScore;
+			else cache[i] = powf(1.0f-(i-3)*(1.0f/(VERTEX_CACHE_LRU_SIZE-3)), 
+				cacheDecayPower);
+		}
+		valence[0] = 0.0f;
+		for(GLuint i = 1; i < VERTEX_CACHE_MAX_VALENCE; i++)
+			valence[i] = valenceBoostScale*powf((GLfloat)i, -valenceBoostPower);
+	}
+};
+
+static const VertexScoreTable scoreTable;
+
+//Scores a vertex by its position in the cache (-1 if not cached) and its
+//number of remaining triangles
+static GLfloat VertexScore(GLint position, GLuint remaining)
+{
+	//Vertices without triangles left don't matter anymore
+	if(remaining == 0) return(-1.0f);
+
+	GLfloat score = (position >= 0) ? scoreTable.cache[position] : 0.0f;
+	if(remaining < VERTEX_CACHE_MAX_VALENCE) 
+		return(score+scoreTable.valence[remaining]);
+	return(score+valenceBoostScale*powf((GLfloat)remaining, 
+		-valenceBoostPower));
+}
+
+//Renumbers the vertices referenced by the indices from 0 to n-1, so the per
+//vertex arrays only need to be as large as the triangle list needs
+static GLuint LocalIndices(const GLuint *indices, size_t count, 
+		vector<GLuint> &local)
+{
+	local.resize(count);
+	if(count == 0) return(0);
+	GLuint last = *max_element(indices, indices+count);
+
+	//A table of every index is the fastest when the indices aren't spread
+	//much wider than the triangle list, e.g. a single group mesh
+	if(last/8 < count)
+	{
+		vector<GLuint> table(last+1, 0xFFFFFFFF);
+		GLuint numVerts = 0;
+		for(size_t i = 0; i < count; i++)
+		{
+			GLuint &v = table[indices[i]];
+			if(v == 0xFFFFFFFF) v = numVerts++;
+			local[i] = v;
+		}
+		return(numVerts);
+	}
+
+	//Otherwise look the indices up in the sorted list of unique indices
+	vector<GLuint> unique(indices, indices+count);
+	sort(unique.begin(), unique.end());
+	unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+	for(size_t i = 0; i < count; i++)
+	{
+		local[i] = lower_bound(unique.begin(), unique.end(), indices[i])-
+			unique.begin();
+	}
+	return(unique.size());
+}
+
+VertexCacheStats::VertexCacheStats()
+{
+	triangles = 0, vertices = 0, transforms = 0;
+}
+
+GLvoid VertexCacheStats::Add(const VertexCacheStats &s)
+{
+	triangles += s.triangles;
+	vertices += s.vertices;
+	transforms += s.transforms;
+}
+
+GLfloat VertexCacheStats::ACMR() const
+{
+	return((triangles > 0) ? (GLfloat)transforms/triangles : 0.0f);
+}
+
+GLfloat VertexCacheStats::ATVR() const
+{
+	return((vertices > 0) ? (GLfloat)transforms/vertices : 0.0f);
+}
+
+const string VertexCacheStats::ToString() const
+{
+	ostringstream s(ostringstream::out);
+	s<<"ACMR "<<ACMR()<<", ATVR "<<ATVR();
+	return(s.str());
+}
+
+VertexFetchStats::VertexFetchStats()
+{
+	fetches = 0, misses = 0;
+}
+
+GLfloat VertexFetchStats::MissRatio() const
+{
+	return((fetches > 0) ? (GLfloat)misses/fetches : 0.0f);
+}
+
+VertexCacheStats VertexCache::Measure(const GLuint *indices, size_t count,
+		GLuint cacheSize)
+{
+	VertexCacheStats stats;
+	vector<GLuint> local;
+	stats.triangles = count/3;
+	stats.vertices = LocalIndices(indices, count, local);
+
+	//A vertex is still in the FIFO if fewer than cacheSize vertices were 
+	//added after it
+	vector<GLuint> added(stats.vertices, 0);
+	for(size_t i = 0; i < count; i++)
+	{
+		GLuint &time = added[local[i]];
+		if(time == 0 || stats.transforms+1-time > cacheSize) 
+			time = ++stats.transforms;
+	}
+
+	return(stats);
+}
+
+VertexFetchStats VertexCache::MeasureFetch(const GLuint *indices, 
+		size_t count, GLuint vertexSize)
+{
+	VertexFetchStats stats;
+	if(count == 0) return(stats);
+	vector<GLuint> added(*max_element(indices, indices+count)+1, 0);
+
+	//The cached lines, most recently used first
+	size_t lines[VERTEX_FETCH_LINES];
+	GLuint cached = 0, transforms = 0;
+	for(size_t i = 0; i < count; i++)
+	{
+		//Same FIFO as Measure(), cached vertices aren't fetched again
+		GLuint &t = added[indices[i]];
+		if(t != 0 && transforms+1-t <= VERTEX_CACHE_FIFO_SIZE) continue;
+		t = ++transforms;
+		stats.fetches++;
+
+		size_t begin = (size_t)indices[i]*vertexSize;
+		size_t end = begin+vertexSize-1;
+		for(size_t line = begin/VERTEX_FETCH_LINE_SIZE; 
+				line <= end/VERTEX_FETCH_LINE_SIZE; line++)
+		{
+			GLuint k = 0;
+			while(k < cached && lines[k] != line) k++;
+			if(k == cached)
+			{
+				stats.misses++;
+				if(cached < VERTEX_FETCH_LINES) cached++;
+				k = cached-1;
+			}
+
+			//Move the line to the front
+			for(; k > 0; k--) lines[k] = lines[k-1];
+			lines[0] = line;
+		}
+	}
+
+	return(stats);
+}
+
+GLvoid VertexCache::Optimize(GLuint *indices, size_t count)
+{
+	size_t triangles = count/3;
+	if(triangles < 2) return;
+
+	vector<GLuint> local;
+	GLuint numVerts = LocalIndices(indices, count, local);
+
+	//List the triangles of each vertex, the first remaining[v] entries of a
+	//vertex's list are the triangles that haven't been drawn yet
+	vector<GLuint> remaining(numVerts, 0), offsets(numVerts+1, 0);
+	for(size_t i = 0; i < count; i++) remaining[local[i]]++;
+	for(GLuint v = 0; v < numVerts; v++) offsets[v+1] = offsets[v]+remaining[v];
+	vector<GLuint> adjacency(count), end(offsets.begin(), offsets.end()-1);
+	for(size_t i = 0; i < count; i++) adjacency[end[local[i]]++] = i/3;
+
+	vector<GLint> position(numVerts, -1);
+	vector<GLfloat> vertexScore(numVerts);
+	for(GLuint v = 0; v < numVerts; v++) 
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+
+	vector<GLfloat> triangleScore(triangles);
+	size_t best = 0;
+	for(size_t t = 0; t < triangles; t++)
+	{
+		triangleScore[t] = vertexScore[local[3*t]]+vertexScore[local[3*t+1]]+
+			vertexScore[local[3*t+2]];
+		if(triangleScore[t] > triangleScore[best]) best = t;
+	}
+
+	//The modelled cache has room for the three vertices of the next 
+	//triangle before the oldest entries are evicted
+	GLuint cache[VERTEX_CACHE_LRU_SIZE+3], next[VERTEX_CACHE_LRU_SIZE+3];
+	GLuint cached = 0;
+
+	vector<GLubyte> drawn(triangles, 0);
+	vector<GLuint> result(count);
+	size_t scan = 0;
+	for(size_t k = 0; k < triangles; k++)
+	{
+		//No cached vertex has triangles left, continue with the first
+		//triangle that wasn't drawn yet
+		if(best == triangles)
+		{
+			while(drawn[scan]) scan++;
+			best = scan;
+		}
+
+		drawn[best] = 1;
+		const GLuint *tri = &local[3*best];
+		for(GLuint c = 0; c < 3; c++) result[3*k+c] = indices[3*best+c];
+
+		//Take the triangle off its vertices' lists
+		for(GLuint c = 0; c < 3; c++)
+		{
+			GLuint v = tri[c];
+			GLuint *list = &adjacency[offsets[v]];
+			GLuint last = --remaining[v];
+			for(GLuint j = 0; j < last; j++)
+			{
+				if(list[j] == best) {swap(list[j], list[last]); break;}
+			}
+		}
+
+		//The triangle's vertices move to the front of the cache
+		GLuint size = 0;
+		for(GLuint c = 0; c < 3; c++) next[size++] = tri[c];
+		for(GLuint i = 0; i < cached; i++)
+		{
+			if(cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+				next[size++] = cache[i];
+		}
+
+		//Rescore every vertex whose cache position changed, including the
+		//evicted ones, and pass the change on to their triangles
+		for(GLuint i = 0; i < size; i++)
+		{
+			GLuint v = next[i];
+			position[v] = (i < VERTEX_CACHE_LRU_SIZE) ? (GLint)i : -1;
+			GLfloat score = VertexScore(position[v], remaining[v]);
+			GLfloat delta = score-vertexScore[v];
+			vertexScore[v] = score;
+
+			const GLuint *list = &adjacency[offsets[v]];
+			for(GLuint j = 0; j < remaining[v]; j++) 
+				triangleScore[list[j]] += delta;
+		}
+
+		//The next triangle is the best one touching the cache
+		cached = (size < VERTEX_CACHE_LRU_SIZE) ? size : VERTEX_CACHE_LRU_SIZE;
+		best = triangles;
+		GLfloat bestScore = -1.0f;
+		for(GLuint i = 0; i < cached; i++)
+		{
+			GLuint v = cache[i] = next[i];
+			const GLuint *list = &adjacency[offsets[v]];
+			for(GLuint j = 0; j < remaining[v]; j++)
+			{
+				if(triangleScore[list[j]] > bestScore) 
+				{
+					bestScore = triangleScore[list[j]];
+					best = list[j];
+				}
+			}
+		}
+	}
+
+	//Meshes exported in strips can already be close to optimal for the 
+	//hardware's FIFO, keep their order unless the new one is better
+	if(Measure(&result.front(), count).transforms < 
+			Measure(indices, count).transforms)
+		copy(result.begin(), result.end(), indices);
+}
@@ -0,0 +1,212 @@
+//Copyright (c) 2012 Sekhar Bhattacharya
+//Licensed under the MIT license
+//See license.txt
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <stdint.h>
+
+#include <VertexFormat.h>
+#include <Parallel.h>
+
+//Number of vertices quantized by one task of Parallel::For
+#define QUANTIZE_BLOCK_SIZE (1<<16)
+
+using namespace std;
+
+//The arrays shared by the tasks quantizing blocks of vertices
+struct QuantizeJob {
+	const Vector3 *positions;
+	const Vector3 *normals;
+	const Vec2f *texcoords;
+	size_t count;
+	Vector3 min;
+	Vector3 scale;
+	QuantizedVertex *out;
+};
+
+//Rounds the value to the nearest integer in [lo, hi]
+static GLint RoundClamped(GLfloat value, GLint lo, GLint hi)
+{
+	GLint q = (GLint)floorf(value+0.5f);
+	return((q < lo) ? lo : ((q > hi) ? hi : q));
+}
+
+//Quantizes one block of QUANTIZE_BLOCK_SIZE vertices
+static GLvoid QuantizeBlock(GLuint index, GLvoid *data)
+{
+	QuantizeJob &job = *(QuantizeJob*)data;
+	size_t begin = (size_t)index*QUANTIZE_BLOCK_SIZE;
+	size_t end = begin+QUANTIZE_BLOCK_SIZE;
+	if(end > job.count) end = job.count;
+
+	for(size_t i = begin; i < end; i++)
+	{
+		QuantizedVertex &q = job.out[i];
+		const Vector3 &p = job.positions[i];
+		q.position[0] = RoundClamped((p.x-job.min.x)*job.scale.x, 0, 65535);
+		q.position[1] = RoundClamped((p.y-job.min.y)*job.scale.y, 0, 65535);
+		q.position[2] = RoundClamped((p.z-job.min.z)*job.scale.z, 0, 65535);
+		q.position[3] = 65535;
+
+		if(job.normals != NULL) VertexFormat::OctEncode(job.normals[i], 
+				q.normal);
+		else q.normal[0] = q.normal[1] = 0;
+
+		if(job.texcoords != NULL)
+		{
+			q.texcoord[0] = VertexFormat::FloatToHalf(job.texcoords[i][0]);
+			q.texcoord[1] = VertexFormat::FloatToHalf(job.texcoords[i][1]);
+		}
+		else q.texcoord[0] = q.texcoord[1] = 0;
+	}
+}
+
+GLsizei VertexFormat::Size(GLuint format)
+{
+	//The float layout stores a position and a normal
+	if(format == VERTEX_FORMAT_QUANTIZED) return(sizeof(QuantizedVertex));
+	return(2*sizeof(Vector3));
+}
+
+const string VertexFormat::Name(GLuint format)
+{
+	if(format == VERTEX_FORMAT_QUANTIZED) return("quantized");
+	return("float");
+}
+
+const string VertexFormat::Report(GLuint format, size_t count)
+{
+	ostringstream s(ostringstream::out);
+	GLfloat mb = 1.0f/(1024.0f*1024.0f);
+	GLsizei size = Size(format), full = Size(VERTEX_FORMAT_FLOAT);
+
+	s<<left;
+	s<<setw(15)<<"VERTEX FORMAT"<<": "<<Name(format)<<", "<<size<<
+		" bytes/vertex"<<endl;
+	s<<setw(15)<<"VERTEX MEMORY"<<": "<<count*size*mb<<" MB";
+	if(size < full)
+	{
+		s<<endl<<setw(15)<<"FORMAT SAVINGS"<<": "<<full-size<<
+			" bytes/vertex, "<<count*(full-size)*mb<<" MB ("<<
+			(100.0f*(full-size))/full<<"%)";
+	}
+	return(s.str());
+}
+
+GLushort VertexFormat::FloatToHalf(GLfloat f)
+{
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+	GLushort sign = (x>>16) & 0x8000;
+	uint32_t a = x & 0x7FFFFFFF;
+
+	//Infinity and NaN, keep NaNs quiet
+	if(a >= 0x7F800000) return(sign | 0x7C00 | ((a > 0x7F800000) ? 0x200:0));
+
+	//65520 and up round to infinity
+	if(a >= 0x477FF000) return(sign | 0x7C00);
+
+	//Below the smallest normal half, shift the mantissa into a denormal
+	if(a < 0x38800000)
+	{
+		if(a < 0x33000000) return(sign);
+		uint32_t mantissa = (a & 0x7FFFFF) | 0x800000;
+		uint32_t shift = 126-(a>>23);
+		uint32_t h = mantissa>>shift;
+		uint32_t rest = mantissa & ((1<<shift)-1), half = 1<<(shift-1);
+		if(rest > half || (rest == half && (h & 1))) h++;
+		return(sign | h);
+	}
+
+	//Rebias the exponent and round the mantissa to nearest even, a carry
+	//into the exponent is still the correctly rounded result
+	uint32_t h = (a-0x38000000)>>13;
+	uint32_t rest = a & 0x1FFF;
+	if(rest > 0x1000 || (rest == 0x1000 && (h & 1))) h++;
+	return(sign | h);
+}
+
+GLfloat VertexFormat::HalfToFloat(GLushort h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000)<<16;
+	uint32_t exponent = (h>>10) & 0x1F, mantissa = h & 0x3FF;
+
+	//Denormals are exact in single precision
+	if(exponent == 0) 
+	{
+		GLfloat f = mantissa*(1.0f/16777216.0f);
+		return(sign ? -f : f);
+	}
+
+	uint32_t x;
+	if(exponent == 31) x = sign | 0x7F800000 | (mantissa<<13);
+	else x = sign | ((exponent+112)<<23) | (mantissa<<13);
+	GLfloat f;
+	memcpy(&f, &x, sizeof(f));
+	return(f);
+}
+
+GLvoid VertexFormat::OctEncode(const Vector3 &n, GLshort e[2])
+{
+	//Project onto the octahedron |x|+|y|+|z| = 1
+	GLfloat l = fabsf(n.x)+fabsf(n.y)+fabsf(n.z);
+	if(l == 0.0f) {e[0] = e[1] = 0; return;}
+	GLfloat x = n.x/l, y = n.y/l;
+
+	//Fold the lower half over the diagonals
+	if(n.z < 0.0f)
+	{
+		GLfloat fx = (1.0f-fabsf(y))*((x >= 0.0f) ? 1.0f : -1.0f);
+		GLfloat fy = (1.0f-fabsf(x))*((y >= 0.0f) ? 1.0f : -1.0f);
+		x = fx, y = fy;
+	}
+
+	//Rounding each component on its own isn't always the closest code, 
+	//pick the best of the four surrounding codes
+	GLint x0 = (GLint)floorf(x*32767.0f), y0 = (GLint)floorf(y*32767.0f);
+	GLfloat best = -2.0f;
+	for(GLint i = 0; i < 4; i++)
+	{
+		GLshort c[2];
+		c[0] = RoundClamped((GLfloat)(x0+(i & 1)), -32767, 32767);
+		c[1] = RoundClamped((GLfloat)(y0+(i>>1)), -32767, 32767);
+		GLfloat d = OctDecode(c)*n;
+		if(d > best) best = d, e[0] = c[0], e[1] = c[1];
+	}
+}
+
+Vector3 VertexFormat::OctDecode(const GLshort e[2])
+{
+	//Unfold the lower half, the same way the vertex shader does
+	GLfloat x = e[0]/32767.0f, y = e[1]/32767.0f;
+	GLfloat z = 1.0f-fabsf(x)-fabsf(y);
+	GLfloat t = (z < 0.0f) ? -z : 0.0f;
+	x += (x >= 0.0f) ? -t : t;
+	y += (y >= 0.0f) ? -t : t;
+
+	GLfloat l = sqrtf(x*x+y*y+z*z);
+	return(Vector3(x/l, y/l, z/l));
+}
+
+GLvoid VertexFormat::Quantize(const Vector3 *positions, 
+		const Vector3 *normals, const Vec2f *texcoords, size_t count, 
+		const BoundingBox &bounds, QuantizedVertex *out)
+{
+	if(count == 0) return;
+
+	//Positions map from [min, max] onto [0, 65535], a flat axis maps to 0
+	Vector3 size = bounds.Size();
+	QuantizeJob job;
+	job.positions = positions, job.normals = normals;
+	job.texcoords = texcoords, job.count = count, job.out = out;
+	job.min = bounds.min;
+	job.scale = Vector3((size.x > 0.0f) ? 65535.0f/size.x : 0.0f,
+		(size.y > 0.0f) ? 65535.0f/size.y : 0.0f,
+		(size.z > 0.0f) ? 65535.0f/size.z : 0.0f);
+
+	Parallel::For((count+QUANTIZE_BLOCK_SIZE-1)/QUANTIZE_BLOCK_SIZE, 
+		&QuantizeBlock, &job);
+}
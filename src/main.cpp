@@ -2,14 +2,48 @@
 //Licensed under the MIT license
 //See license.txt
 
+#include <string>
+#include <cstdlib>
+
 #include <App.h>
+#include <Mesh.h>
+#include <Benchmark.h>
+#include <GLState.h>
 
 int32_t main(int32_t argc, char **argv)
 {
 	App::objectFilename = "teapot.obj";
-	if(argc > 1 && argv[1] != NULL)
+
+	//Options start with a '-', anything else is the object file to render
+	std::string benchmark;
+	for(int32_t i = 1; i < argc; i++)
+	{
+		if(argv[i] == NULL) continue;
+		std::string arg(argv[i]);
+		if(arg == "-mapped") App::loadFlags |= MESH_LOAD_MAPPED;
+		else if(arg == "-parallel") App::loadFlags |= MESH_LOAD_PARALLEL;
+		else if(arg == "-cache") App::loadFlags |= MESH_LOAD_CACHE;
+		else if(arg == "-weld") App::loadFlags |= MESH_LOAD_WELD;
+		else if(arg == "-optimize") App::loadFlags |= MESH_LOAD_OPTIMIZE;
+		else if(arg == "-quantize") 
+			App::vertexFormat = VERTEX_FORMAT_QUANTIZED;
+		else if(arg == "-meshlets") App::cullMeshlets = true;
+		else if(arg == "-lod") App::selectLods = true;
+		else if(arg == "-occlusion") App::cullOccluded = true;
+		else if(arg == "-stats") App::printStats = true;
+		else if(arg == "-validate") GLState::validate = true;
+		else if(arg == "-instances" && i+1 < argc) 
+			App::instanceCount = atoi(argv[++i]);
+		else if(arg == "-bench" && i+1 < argc) benchmark = argv[++i];
+		else App::objectFilename = arg;
+	}
+
+	//Benchmarks run headless, without ever opening a window
+	if(!benchmark.empty())
 	{
-		App::objectFilename = argv[1];
+		if(!Benchmark::Run(benchmark, App::objectFilename)) 
+			return(EXIT_FAILURE);
+		return(EXIT_SUCCESS);
 	}
 
 	if (!App::Init()) return(EXIT_FAILURE);
@@ -18,4 +52,3 @@ int32_t main(int32_t argc, char **argv)
 
     return(EXIT_SUCCESS);
 }
-